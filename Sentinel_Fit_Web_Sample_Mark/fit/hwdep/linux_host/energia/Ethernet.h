@@ -0,0 +1,78 @@
+/****************************************************************************\
+**
+** Ethernet.h
+**
+** Energia Ethernet library interface as used by the web sample; connections
+** are simulated in memory by www_loopback.cpp.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __ETHERNET_H__
+#define __ETHERNET_H__
+
+#include "energia.h"
+
+/** Simulated TCP connection, see www_loopback.cpp.*/
+struct lb_conn;
+
+class EthernetClient {
+public:
+    EthernetClient(struct lb_conn *conn = NULL) : conn(conn) {}
+
+    int available(void);
+    int read(void);
+    int read(uint8_t *buf, size_t size);
+    uint8_t connected(void);
+    void stop(void);
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buf, size_t size);
+    size_t print(const char *s);
+    size_t print(char c);
+    size_t print(int n);
+    size_t print(unsigned int n);
+    size_t print(long n);
+    size_t print(unsigned long n);
+    size_t println(void);
+    size_t println(const char *s);
+    size_t println(int n);
+    size_t println(unsigned int n);
+    size_t println(long n);
+    size_t println(unsigned long n);
+
+    operator bool(void) { return conn != NULL; }
+    bool operator==(const EthernetClient &other) const { return conn == other.conn; }
+
+    struct lb_conn *conn;
+};
+
+class EthernetServer {
+public:
+    EthernetServer(uint16_t port) : port(port) {}
+
+    void begin(void);
+    EthernetClient available(void);
+
+    uint16_t port;
+};
+
+class EthernetClass {
+public:
+    void begin(uint8_t *mac, IPAddress ip, IPAddress dns, IPAddress gateway, IPAddress subnet);
+    int begin(uint8_t *mac);
+    void enableLinkLed(void) {}
+    void enableActivityLed(void) {}
+    void macAddress(uint8_t *mac);
+    IPAddress localIP(void) { return ip; }
+    IPAddress subnetMask(void) { return subnet; }
+    IPAddress gatewayIP(void) { return gateway; }
+    IPAddress dnsServerIP(void) { return dns; }
+
+    IPAddress ip, dns, gateway, subnet;
+};
+
+extern EthernetClass Ethernet;
+
+#endif /* __ETHERNET_H__ */
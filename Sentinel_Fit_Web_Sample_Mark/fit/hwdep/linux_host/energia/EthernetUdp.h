@@ -0,0 +1,16 @@
+/****************************************************************************\
+**
+** EthernetUdp.h
+**
+** Part of the minimal Energia core for Linux host, see energia.h.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __MOCK_ETHERNETUDP_H__
+#define __MOCK_ETHERNETUDP_H__
+
+#include "energia.h"
+
+#endif /* __MOCK_ETHERNETUDP_H__ */
@@ -0,0 +1,67 @@
+/****************************************************************************\
+**
+** energia.h
+**
+** Minimal Energia core for building the web sample (www.cpp, util.cpp,
+** fit_web_sample.cpp) on Linux host. Only what the web sample uses is
+** declared; EEPROM is the emulation of fit_eeprom_mem.c, network is the
+** loopback of www_loopback.cpp.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __ENERGIA_H__
+#define __ENERGIA_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fit_eeprom_mem.h"
+
+typedef bool boolean;
+
+/** Milliseconds since start, advanced by the loopback harness.*/
+uint32_t millis(void);
+
+/* Tiva driverlib ***********************************************************/
+
+#define SYSCTL_PERIPH_GPION     0
+#define GPIO_PORTN_BASE         0
+#define GPIO_PIN_0              0x01
+#define GPIO_PIN_1              0x02
+
+static inline void SysCtlPeripheralEnable(uint32_t periph) { (void)periph; }
+static inline bool SysCtlPeripheralReady(uint32_t periph) { (void)periph; return true; }
+static inline void GPIOPinTypeGPIOOutput(uint32_t port, uint8_t pins) { (void)port; (void)pins; }
+static inline void GPIOPinWrite(uint32_t port, uint8_t pins, uint8_t val)
+{
+    (void)port; (void)pins; (void)val;
+}
+
+static inline void ROM_FlashUserGet(uint32_t *user0, uint32_t *user1)
+{
+    *user0 = 0x1A0000;
+    *user1 = 0x563412;
+}
+
+static inline uint32_t EEPROMSizeGet(void) { return eeprom_size(); }
+static inline uint32_t EEPROMMassErase(void) { eeprom_mass_erase(); return 0; }
+
+/* IP address ***************************************************************/
+
+class IPAddress {
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0)
+    {
+        addr[0] = a; addr[1] = b; addr[2] = c; addr[3] = d;
+    }
+    uint8_t operator[](int i) const { return addr[i]; }
+
+private:
+    uint8_t addr[4];
+};
+
+#endif /* __ENERGIA_H__ */
@@ -0,0 +1,413 @@
+/****************************************************************************\
+**
+** fit_eeprom_mem.c
+**
+** Contains memory(EEPROM) related function definitions for Linux host.
+**
+** EEPROM is emulated by a RAM buffer that is loaded from and written through
+** to a file, so content survives between runs like on the board. Like the
+** TM4C EEPROM, memory is accessed in 32 bit words; every read call and every
+** word can be given a latency to model slow EEPROM (see eeprom_set_latency).
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef __linux__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fit/hwdep/linux_host/fit_eeprom_mem.h>
+
+/* value of erased EEPROM byte */
+#define EE_ERASED           0xFF
+
+static uint8_t  *ee_data = NULL;
+static uint32_t ee_size = 0;
+static FILE     *ee_file = NULL;
+static uint32_t ee_access_ns = 0;
+static uint32_t ee_word_ns = 0;
+static fit_eeprom_stats_t ee_stats;
+
+/* words programmed per block of EE_BLOCK_SIZE bytes, see eeprom_block_writes */
+#define EE_BLOCK_SIZE       64
+
+static uint32_t *ee_block_writes = NULL;
+
+/**
+ *
+ * ee_delay
+ *
+ * Busy waits for number of nanoseconds passed in. nanosleep is not used as its
+ * granularity is far above EEPROM access times.
+ *
+ */
+
+static void ee_delay (uint64_t ns)
+{
+    struct timespec start, now;
+
+    if (ns == 0)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while ((uint64_t)(now.tv_sec - start.tv_sec) * 1000000000u +
+             (uint64_t)now.tv_nsec - (uint64_t)start.tv_nsec < ns);
+}
+
+/**
+ *
+ * ee_access
+ *
+ * Accounts for one EEPROM read access of len bytes starting at addr.
+ *
+ */
+
+static void ee_access (uint32_t addr, uint32_t len)
+{
+    uint32_t words = ((addr % 4) + len + 3) / 4;
+
+    ee_stats.reads++;
+    ee_stats.read_words += words;
+    ee_delay((uint64_t)ee_access_ns + (uint64_t)ee_word_ns * words);
+}
+
+/**
+ *
+ * eeprom_open
+ *
+ * Creates emulated EEPROM of size bytes. If path is not NULL, EEPROM content is
+ * loaded from this file (missing part reads as erased) and every write goes
+ * through to the file. Returns 0 on success, -1 on failure.
+ *
+ * @param   path --> name of backing file or NULL for RAM only EEPROM.
+ * @param   size --> EEPROM size in bytes; 0 for FIT_EEPROM_DEFAULT_SIZE.
+ *
+ */
+
+int eeprom_open (const char *path, uint32_t size)
+{
+    size_t n = 0;
+
+    eeprom_close();
+
+    if (size == 0)
+        size = FIT_EEPROM_DEFAULT_SIZE;
+    ee_data = (uint8_t *)malloc(size);
+    ee_block_writes = (uint32_t *)calloc((size + EE_BLOCK_SIZE - 1) / EE_BLOCK_SIZE, sizeof(uint32_t));
+    if (ee_data == NULL || ee_block_writes == NULL) {
+        eeprom_close();
+        return -1;
+    }
+    ee_size = size;
+
+    if (path != NULL) {
+        ee_file = fopen(path, "r+b");
+        if (ee_file == NULL)
+            ee_file = fopen(path, "w+b");
+        if (ee_file == NULL) {
+            eeprom_close();
+            return -1;
+        }
+        n = fread(ee_data, 1, size, ee_file);
+    }
+    memset(ee_data + n, EE_ERASED, size - n);
+    if (ee_file != NULL && n < size) {
+        fseek(ee_file, (long)n, SEEK_SET);
+        fwrite(ee_data + n, 1, size - n, ee_file);
+        fflush(ee_file);
+    }
+
+    eeprom_stats_reset();
+    return 0;
+}
+
+/**
+ *
+ * eeprom_close
+ *
+ * Closes backing file and frees emulated EEPROM.
+ *
+ */
+
+void eeprom_close (void)
+{
+    if (ee_file != NULL)
+        fclose(ee_file);
+    ee_file = NULL;
+    free(ee_data);
+    ee_data = NULL;
+    free(ee_block_writes);
+    ee_block_writes = NULL;
+    ee_size = 0;
+}
+
+/**
+ *
+ * eeprom_size
+ *
+ * Returns size of emulated EEPROM in bytes.
+ *
+ */
+
+uint32_t eeprom_size (void)
+{
+    return ee_size;
+}
+
+/**
+ *
+ * eeprom_mass_erase
+ *
+ * Sets complete EEPROM to erased state.
+ *
+ */
+
+void eeprom_mass_erase (void)
+{
+    if (ee_data == NULL)
+        return;
+
+    memset(ee_data, EE_ERASED, ee_size);
+    if (ee_file != NULL) {
+        fseek(ee_file, 0, SEEK_SET);
+        fwrite(ee_data, 1, ee_size, ee_file);
+        fflush(ee_file);
+    }
+}
+
+/**
+ *
+ * eeprom_set_latency
+ *
+ * Sets time spent on every EEPROM read call and on every word read.
+ *
+ * @param   access_ns --> latency per read call in nanoseconds.
+ * @param   word_ns   --> latency per 32 bit word in nanoseconds.
+ *
+ */
+
+void eeprom_set_latency (uint32_t access_ns, uint32_t word_ns)
+{
+    ee_access_ns = access_ns;
+    ee_word_ns = word_ns;
+}
+
+/**
+ *
+ * eeprom_stats
+ *
+ * Returns EEPROM access counters.
+ *
+ * @param   stats --> pointer to structure that will contain counters.
+ *
+ */
+
+void eeprom_stats (fit_eeprom_stats_t *stats)
+{
+    *stats = ee_stats;
+}
+
+/**
+ *
+ * eeprom_stats_reset
+ *
+ * Clears EEPROM access counters.
+ *
+ */
+
+void eeprom_stats_reset (void)
+{
+    memset(&ee_stats, 0, sizeof(ee_stats));
+    if (ee_block_writes != NULL)
+        memset(ee_block_writes, 0, ((ee_size + EE_BLOCK_SIZE - 1) / EE_BLOCK_SIZE) * sizeof(uint32_t));
+}
+
+/**
+ *
+ * eeprom_block_writes
+ *
+ * Returns number of words programmed into EEPROM block (EE_BLOCK_SIZE bytes)
+ * since eeprom_open or eeprom_stats_reset.
+ *
+ * @param   block --> block number.
+ *
+ */
+
+uint32_t eeprom_block_writes (uint32_t block)
+{
+    if (ee_block_writes == NULL || block >= (ee_size + EE_BLOCK_SIZE - 1) / EE_BLOCK_SIZE)
+        return 0;
+
+    return ee_block_writes[block];
+}
+
+/**
+ *
+ * eeprom_cache_invalidate
+ *
+ * Host EEPROM has no read cache; present for compatibility with board code.
+ *
+ */
+
+void eeprom_cache_invalidate (void)
+{
+}
+
+/**
+ *
+ * eeprom_cache_stats
+ *
+ * Host EEPROM has no read cache, every read is reported as miss.
+ *
+ * @param   hits --> pointer to integer that will contain number of hits.
+ * @param   misses --> pointer to integer that will contain number of misses.
+ *
+ */
+
+void eeprom_cache_stats (uint32_t *hits, uint32_t *misses)
+{
+    *hits = 0;
+    *misses = ee_stats.reads;
+}
+
+/**
+ *
+ * read_eeprom_u8
+ *
+ * Reads 1 byte data from data pointer passed in.
+ *
+ * @param   p --> pointer to data.
+ *
+ */
+
+uint8_t read_eeprom_u8 (const uint8_t *p)
+{
+    uint32_t addr = (uint32_t)(uintptr_t)p;
+
+    ee_access(addr, 1);
+    if (addr >= ee_size)
+        return EE_ERASED;
+
+    return ee_data[addr];
+}
+
+/**
+ *
+ * read_eeprom_block
+ *
+ * Reads len bytes of data from data pointer passed in.
+ *
+ * @param   dst --> pointer to destination buffer.
+ * @param   p   --> pointer to data.
+ * @param   len --> number of bytes to read.
+ *
+ */
+
+void read_eeprom_block (uint8_t *dst, const uint8_t *p, uint16_t len)
+{
+    uint32_t addr = (uint32_t)(uintptr_t)p;
+    uint32_t n = 0;
+
+    ee_access(addr, len);
+    if (addr < ee_size) {
+        n = ee_size - addr;
+        if (n > len)
+            n = len;
+        memcpy(dst, ee_data + addr, n);
+    }
+    memset(dst + n, EE_ERASED, len - n);
+}
+
+/**
+ *
+ * write_eeprom_u8
+ *
+ * Writes 1 byte to EEPROM address passed in. Containing word is programmed only
+ * if its value changes.
+ *
+ * @param   address --> EEPROM address.
+ * @param   value   --> byte to be written.
+ *
+ */
+
+void write_eeprom_u8 (int address, uint8_t value)
+{
+    if (address < 0 || (uint32_t)address >= ee_size)
+        return;
+
+    if (ee_data[address] != value) {
+        ee_data[address] = value;
+        ee_stats.write_words++;
+        ee_block_writes[address / EE_BLOCK_SIZE]++;
+        if (ee_file != NULL) {
+            fseek(ee_file, address, SEEK_SET);
+            fputc(value, ee_file);
+            fflush(ee_file);
+        }
+    }
+}
+
+/**
+ *
+ * write_eeprom_words
+ *
+ * Writes count 32 bit words (little endian) to word aligned EEPROM address
+ * passed in. Only words whose value changes are programmed.
+ *
+ * @param   address --> word aligned EEPROM address.
+ * @param   words   --> words to be written.
+ * @param   count   --> number of words.
+ *
+ */
+
+void write_eeprom_words (int address, const uint32_t *words, uint32_t count)
+{
+    uint8_t b[4];
+    uint32_t i;
+
+    if (address < 0 || (address % 4) || (uint32_t)address + 4 * count > ee_size)
+        return;
+
+    for (i = 0; i < count; i++, address += 4) {
+        b[0] = (uint8_t)words[i];
+        b[1] = (uint8_t)(words[i] >> 8);
+        b[2] = (uint8_t)(words[i] >> 16);
+        b[3] = (uint8_t)(words[i] >> 24);
+
+        if (memcmp(ee_data + address, b, 4) == 0)
+            continue;
+
+        memcpy(ee_data + address, b, 4);
+        ee_stats.write_words++;
+        ee_block_writes[address / EE_BLOCK_SIZE]++;
+        if (ee_file != NULL) {
+            fseek(ee_file, address, SEEK_SET);
+            fwrite(b, 1, 4, ee_file);
+            fflush(ee_file);
+        }
+    }
+}
+
+/**
+ *
+ * write_eeprom_u32
+ *
+ * Writes 32 bit word (little endian) to word aligned EEPROM address passed in.
+ * Word is programmed only if its value changes.
+ *
+ * @param   address --> word aligned EEPROM address.
+ * @param   value   --> word to be written.
+ *
+ */
+
+void write_eeprom_u32 (int address, uint32_t value)
+{
+    write_eeprom_words(address, &value, 1);
+}
+
+#endif // #ifdef __linux__
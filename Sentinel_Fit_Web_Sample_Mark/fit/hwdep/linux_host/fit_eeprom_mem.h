@@ -0,0 +1,50 @@
+/****************************************************************************\
+**
+** fit_eeprom_mem.h
+**
+** Contains declaration of EEPROM emulation for Linux host. EEPROM content is
+** kept in a RAM buffer backed by a file; EEPROM addresses (as used by util.cpp
+** and fit_pointer_t) are offsets into this buffer.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_EEPROM_MEM_H__
+#define __FIT_EEPROM_MEM_H__
+
+#include "fit_hwdep.h"
+
+/* Default size of emulated EEPROM (TM4C1294 has 6K) */
+#define FIT_EEPROM_DEFAULT_SIZE     0x1800
+
+/* Types ********************************************************************/
+
+/** EEPROM access counters, see eeprom_stats.*/
+typedef struct fit_eeprom_stats {
+    /** Number of read calls (read_eeprom_u8 or read_eeprom_block).*/
+    uint32_t reads;
+    /** Number of 32 bit words read from EEPROM.*/
+    uint32_t read_words;
+    /** Number of 32 bit words programmed.*/
+    uint32_t write_words;
+} fit_eeprom_stats_t;
+
+/* Function Prototypes ******************************************************/
+
+EXTERNC int  eeprom_open (const char *path, uint32_t size);
+EXTERNC void eeprom_close (void);
+EXTERNC uint32_t eeprom_size (void);
+EXTERNC void eeprom_mass_erase (void);
+EXTERNC void eeprom_set_latency (uint32_t access_ns, uint32_t word_ns);
+EXTERNC void eeprom_stats (fit_eeprom_stats_t *stats);
+EXTERNC void eeprom_stats_reset (void);
+EXTERNC uint32_t eeprom_block_writes (uint32_t block);
+
+EXTERNC void write_eeprom_u8 (int address, uint8_t value);
+EXTERNC void write_eeprom_u32 (int address, uint32_t value);
+EXTERNC void write_eeprom_words (int address, const uint32_t *words, uint32_t count);
+EXTERNC void eeprom_cache_invalidate (void);
+EXTERNC void eeprom_cache_stats (uint32_t *hits, uint32_t *misses);
+
+#endif /* __FIT_EEPROM_MEM_H__ */
@@ -0,0 +1,46 @@
+/****************************************************************************\
+**
+** fit_fingerprint.c
+**
+** get board fingerprint - Linux host version
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef __linux__
+
+#include <stdint.h>
+#include <string.h>
+#include "fit_debug.h"
+#include "fit_hwdep.h"
+
+
+char fit_dev_id[FIT_DEVID_MAXLEN] = FIT_DEVICE_ID;
+uint16_t fit_dev_id_len = sizeof(FIT_DEVICE_ID) - 1;
+
+/**
+ *
+ * fit_device_id_get
+ *
+ * Host has no unique hardware id; device id is taken from fit_dev_id, so that
+ * node locked licenses can be tested for any fingerprint by changing it.
+ *
+ */
+fit_status_t fit_device_id_get(uint8_t *rawdata,
+                               uint8_t rawdata_size,
+                               uint16_t *datalen)
+{
+    DBG(FIT_TRACE_INFO, "Fetching deviceid for linux host: ");
+
+    if (fit_dev_id_len > rawdata_size) {
+        return FIT_STATUS_INVALID_DEVICE_ID_LEN;
+    }
+
+    memcpy(rawdata, fit_dev_id, fit_dev_id_len);
+    *datalen = fit_dev_id_len;
+
+    return FIT_STATUS_OK;
+}
+
+#endif // #ifdef __linux__
@@ -0,0 +1,69 @@
+/****************************************************************************\
+**
+** fit_get_time.c
+**
+** Contains function declaration related with expiration based licenses.
+** Linux host version; time is taken from system clock and can be moved with
+** fit_time_set (e.g. for running tests at a fixed date).
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef __linux__
+
+#include <time.h>
+#include <fit/hwdep/linux_host/fit_get_time.h>
+
+#include "fit_debug.h"
+
+/* difference between board time and system time in seconds */
+static int64_t time_offset = 0;
+
+/**
+ *
+ * fit_time_get
+ *
+ * This function returns the current time for hardware board.
+ *
+ */
+uint32_t fit_time_get (void)
+{
+    uint32_t unixtime = (uint32_t)((int64_t)time(NULL) + time_offset);
+
+    DBG(FIT_TRACE_INFO, "Get unix time %lu\n", (unsigned long)unixtime);
+    return unixtime;
+}
+
+
+/**
+ *
+ * fit_time_set
+ *
+ * This function set the current unix time for hardware board.
+ *
+ */
+void fit_time_set (uint32_t settime)
+{
+    DBG(FIT_TRACE_INFO, "Set unix time %lu\n", (unsigned long)settime);
+    time_offset = (int64_t)settime - (int64_t)time(NULL);
+}
+
+
+ /**
+  *
+  * fit_time_init
+  *
+  * This function initializes an RTC
+  * returns 0 for failure,
+  *         1 for success
+  *
+  */
+
+uint32_t fit_time_init (void)
+{
+    time_offset = 0;
+    return 1; /* OK */
+}
+
+#endif // #ifdef __linux__
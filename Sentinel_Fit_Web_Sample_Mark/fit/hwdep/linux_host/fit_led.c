@@ -0,0 +1,33 @@
+/****************************************************************************\
+**
+** fit_led.c
+**
+** LED functions - Linux host version (no LED, functions do nothing)
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef __linux__
+
+#include "fit_hwdep.h"
+
+void fit_led_on(void)
+{
+}
+
+void fit_led_off(void)
+{
+}
+
+void fit_led_init(void)
+{
+    fit_led_off();
+}
+
+void fit_led_deinit(void)
+{
+    fit_led_off();
+}
+
+#endif // #ifdef __linux__
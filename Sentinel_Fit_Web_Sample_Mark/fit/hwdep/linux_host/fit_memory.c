@@ -0,0 +1,49 @@
+/****************************************************************************\
+**
+** fit_memory.c
+**
+** Contains memory related function declaration for Linux host RAM version
+**
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef __linux__
+
+#include "fit_types.h"
+#include <inttypes.h>
+#include <string.h>
+
+
+/**
+ *
+ * read_ram_u8
+ *
+ * Reads 1 byte data from data pointer passed in.
+ *
+ * @param   p --> pointer to data.
+ *
+ */
+uint8_t read_ram_u8 (const uint8_t *p)
+{
+    return (uint8_t)*p;
+}
+
+/**
+ *
+ * read_ram_block
+ *
+ * Reads len bytes of data from data pointer passed in.
+ *
+ * @param   dst --> pointer to destination buffer.
+ * @param   p   --> pointer to data.
+ * @param   len --> number of bytes to read.
+ *
+ */
+void read_ram_block (uint8_t *dst, const uint8_t *p, uint16_t len)
+{
+    memcpy(dst, p, len);
+}
+
+#endif // #ifdef __linux__
@@ -0,0 +1,57 @@
+/****************************************************************************\
+**
+** fit_uart.c
+**
+** UART output functions - Linux host version, console is stdin/stdout
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef __linux__
+
+#include <stdio.h>
+#include <fit/hwdep/linux_host/fit_uart.h>
+
+
+/**
+ * fit_uart_init
+ *
+ * initialize UART
+ *
+ */
+
+void fit_uart_init(unsigned int baudrate)
+{
+    (void)baudrate;
+    setvbuf(stdout, NULL, _IOLBF, 0);
+}
+
+/**
+ * fit_uart_putc
+ *
+ * transmit byte to UART
+ *
+ * @param data -> byte to be transmitted
+ */
+
+void fit_uart_putc ( unsigned char data )
+{
+    putchar(data);
+}
+
+/**
+ * fit_uart_getchar
+ *
+ * receive byte from UART; returns 0 at end of input
+ *
+ */
+
+unsigned char fit_uart_getchar ( void )
+{
+    int c = getchar();
+
+    return (c == EOF) ? 0 : (unsigned char)c;
+}
+
+#endif // #ifdef __linux__
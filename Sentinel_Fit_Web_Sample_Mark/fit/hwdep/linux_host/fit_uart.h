@@ -0,0 +1,21 @@
+/****************************************************************************\
+**
+** fit_uart.h
+**
+** UART output functions - Linux host version
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef SENTINEL_FIT_WEB_SAMPLE_MARK_FIT_HWDEP_LINUX_HOST_FIT_UART_H_
+#define SENTINEL_FIT_WEB_SAMPLE_MARK_FIT_HWDEP_LINUX_HOST_FIT_UART_H_
+
+#include "fit_hwdep.h"
+
+EXTERNC void fit_uart_init( unsigned int baudrate );
+EXTERNC void fit_uart_putc( unsigned char data );
+EXTERNC unsigned char fit_uart_getchar( void );
+
+
+#endif /* SENTINEL_FIT_WEB_SAMPLE_MARK_FIT_HWDEP_LINUX_HOST_FIT_UART_H_ */
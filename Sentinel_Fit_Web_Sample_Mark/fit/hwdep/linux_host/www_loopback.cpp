@@ -0,0 +1,630 @@
+/****************************************************************************\
+**
+** www_loopback.cpp
+**
+** Regression test of the web server connection handling (do_www() in www.cpp)
+** on Linux host. EthernetClient/EthernetServer of energia/Ethernet.h are backed
+** by in-memory connections: hundreds of simulated clients connect at once and
+** send their requests in random pieces while loop() polls the server, one
+** millisecond per call. Some clients stall or go away in the middle of a
+** request. Every client must get the expected reply (or be dropped without
+** one), no connection or upload lock may leak, and rejected or abandoned key
+** uploads must leave the stored keys untouched.
+**
+** Build (from Sentinel_Fit_Web_Sample_Mark directory):
+**
+**   M=fit/mbedtls-2.2.1/library
+**   L=fit/hwdep/linux_host
+**   I="-I$L/energia -I$L -I. -Ifit/inc -Ifit/mbedtls-2.2.1/include"
+**   gcc -std=gnu99 -O2 $I -c fit/src/[a-z]*.c fit_demo_getinfo.c \
+**       $L/fit_board_setup.c $L/fit_eeprom_mem.c $L/fit_fingerprint.c \
+**       $L/fit_flash_mem.c $L/fit_get_time.c $L/fit_led.c $L/fit_memory.c \
+**       $L/fit_uart.c $M/asn1parse.c $M/base64.c $M/bignum.c $M/md.c \
+**       $M/md5.c $M/md_wrap.c $M/oid.c $M/pem.c $M/pk.c $M/pk_wrap.c \
+**       $M/pkparse.c $M/rsa.c $M/sha256.c
+**   g++ -O2 -fpermissive $I -o www_loopback $L/www_loopback.cpp www.cpp \
+**       util.cpp fit_web_sample.cpp *.o
+**
+** Usage: www_loopback [-n clients] [-s seed] > console.log
+**
+**   -n clients number of simulated clients (default 400)
+**   -s seed    seed of random request splitting (default 1)
+**
+** Results are written to stderr, console output of the web sample to stdout.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef __linux__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "util.h"
+#include "www.h"
+
+/* Constants ****************************************************************/
+
+#define LB_DEFAULT_CLIENTS      400
+#define LB_MAX_TICKS            2000000
+#define LB_IDLE_TIMEOUT         1000    /* WWW_IDLE_TIMEOUT of www.cpp */
+#define LB_MAX_CHUNK            40      /* bytes sent by a client at once */
+#define LB_BOUNDARY             "----fitloopback"
+
+/* Types ********************************************************************/
+
+/** Kind of simulated client, see lb_kinds.*/
+typedef enum lb_kind {
+    LB_GET_JSON,
+    LB_GET_INDEX,
+    LB_GET_LOGO,
+    LB_GET_CONSUME,
+    LB_GET_UNKNOWN,
+    LB_LINE_TOO_LONG,
+    LB_BAD_METHOD,
+    LB_POST_AES,
+    LB_POST_RSA_BIG,
+    LB_POST_RSA_BAD,
+    LB_POST_V2C_BAD,
+    LB_STALL_REQUEST,
+    LB_STALL_BODY,
+    LB_CLOSE_REQUEST,
+    LB_NUM_KINDS
+} lb_kind_t;
+
+/** Expected reply of a client kind.*/
+typedef struct lb_expect {
+    const char *name;
+    const char *status;         /* status line, NULL if dropped without reply */
+    boolean     busy_ok;        /* 503 accepted (POST while another upload runs) */
+    const char *body;           /* text that must be in 200 reply, or NULL */
+} lb_expect_t;
+
+/** Simulated TCP connection; client side and server side in one.*/
+struct lb_conn {
+    lb_kind_t   kind;
+    char       *req;            /* complete request of client */
+    uint32_t    reqlen;
+    uint32_t    limit;          /* bytes client sends before it stalls or closes */
+    uint32_t    sent;           /* bytes sent by client so far */
+    uint32_t    pos;            /* bytes read by server so far */
+    boolean     open;           /* client side still open */
+    boolean     stopped;        /* closed by server */
+    uint32_t    lastread;       /* millis() of last read by server */
+    uint32_t    closed;         /* millis() of stop() */
+    char       *resp;           /* reply written by server, 0 terminated */
+    uint32_t    resplen;
+    uint32_t    respsize;
+    uint32_t    late_writes;    /* bytes written after stop() */
+};
+
+/* Global Data **************************************************************/
+
+static const lb_expect_t lb_kinds[LB_NUM_KINDS] = {
+    { "GET /getinfo.txt",   "HTTP/1.1 200", false, NULL },
+    { "GET /",              "HTTP/1.1 200", false, NULL },
+    { "GET /gemalto.png",   "HTTP/1.1 200", false, NULL },
+    { "GET /consume",       "HTTP/1.1 200", false, NULL },
+    { "GET unknown",        "HTTP/1.1 404", false, NULL },
+    { "line too long",      "HTTP/1.1 400", false, NULL },
+    { "bad method",         "HTTP/1.1 400", false, NULL },
+    { "POST aes key",       "HTTP/1.1 200", true,  "AES key stored" },
+    { "POST rsa too big",   "HTTP/1.1 200", true,  "too big" },
+    { "POST rsa invalid",   "HTTP/1.1 200", true,  "previous key kept" },
+    { "POST v2c invalid",   "HTTP/1.1 200", true,  "previous license kept" },
+    { "stall in request",   NULL,           false, NULL },
+    { "stall in body",      NULL,           true,  NULL },
+    { "close in request",   NULL,           false, NULL },
+};
+
+/* AES key uploaded by clients; stored AES and RSA keys before the run */
+static const uint8_t lb_aes_key[16] = {
+    0x0d, 0x0a, 0x2d, 0x2d, 0x66, 0x69, 0x74, 0x00,
+    0xff, 0x0d, 0x0a, 0x0d, 0x0a, 0x2d, 0x2d, 0x2d
+};
+static const char lb_aes_seed[] = "stored aes key..";
+static const char lb_rsa_seed[] = "stored rsa key, must survive rejected uploads";
+
+static struct lb_conn *lb_conns;
+static uint32_t lb_num_conns;
+static uint32_t lb_now;
+static uint32_t lb_rand_state = 1;
+
+EthernetClass Ethernet;
+
+/* Function Prototypes ******************************************************/
+
+void setup(void);
+void loop(void);
+
+/* Functions ****************************************************************/
+
+static uint32_t lb_rand(void)
+{
+    lb_rand_state = lb_rand_state * 1103515245u + 12345u;
+    return lb_rand_state >> 16;
+}
+
+uint32_t millis(void)
+{
+    return lb_now;
+}
+
+/* Loopback Ethernet ********************************************************/
+
+static uint32_t lb_unread(const struct lb_conn *c)
+{
+    return c->sent - c->pos;
+}
+
+static size_t lb_write(struct lb_conn *c, const void *data, size_t len)
+{
+    if (c == NULL)
+        return 0;
+    if (c->stopped) {
+        c->late_writes += (uint32_t)len;
+        return 0;
+    }
+    if (c->resplen + len + 1 > c->respsize) {
+        c->respsize = (uint32_t)(2 * (c->resplen + len + 1));
+        c->resp = (char *)realloc(c->resp, c->respsize);
+        if (c->resp == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+    memcpy(c->resp + c->resplen, data, len);
+    c->resplen += (uint32_t)len;
+    c->resp[c->resplen] = 0;
+    return len;
+}
+
+int EthernetClient::available(void)
+{
+    return (conn && !conn->stopped) ? (int)lb_unread(conn) : 0;
+}
+
+int EthernetClient::read(void)
+{
+    if (available() <= 0)
+        return -1;
+    conn->lastread = lb_now;
+    return (uint8_t)conn->req[conn->pos++];
+}
+
+int EthernetClient::read(uint8_t *buf, size_t size)
+{
+    size_t n = (size_t)available();
+
+    if (n == 0)
+        return -1;
+    if (n > size)
+        n = size;
+    memcpy(buf, conn->req + conn->pos, n);
+    conn->pos += (uint32_t)n;
+    conn->lastread = lb_now;
+    return (int)n;
+}
+
+uint8_t EthernetClient::connected(void)
+{
+    return conn && !conn->stopped && (conn->open || lb_unread(conn) > 0);
+}
+
+void EthernetClient::stop(void)
+{
+    if (conn && !conn->stopped) {
+        conn->stopped = true;
+        conn->closed = lb_now;
+    }
+}
+
+size_t EthernetClient::write(uint8_t c) { return lb_write(conn, &c, 1); }
+size_t EthernetClient::write(const uint8_t *buf, size_t size) { return lb_write(conn, buf, size); }
+size_t EthernetClient::print(const char *s) { return lb_write(conn, s, strlen(s)); }
+size_t EthernetClient::print(char c) { return lb_write(conn, &c, 1); }
+size_t EthernetClient::print(int n) { return print((long)n); }
+size_t EthernetClient::print(unsigned int n) { return print((unsigned long)n); }
+
+size_t EthernetClient::print(long n)
+{
+    char s[24];
+
+    snprintf(s, sizeof(s), "%ld", n);
+    return print(s);
+}
+
+size_t EthernetClient::print(unsigned long n)
+{
+    char s[24];
+
+    snprintf(s, sizeof(s), "%lu", n);
+    return print(s);
+}
+
+size_t EthernetClient::println(void) { return print("\r\n"); }
+size_t EthernetClient::println(const char *s) { return print(s) + println(); }
+size_t EthernetClient::println(int n) { return print(n) + println(); }
+size_t EthernetClient::println(unsigned int n) { return print(n) + println(); }
+size_t EthernetClient::println(long n) { return print(n) + println(); }
+size_t EthernetClient::println(unsigned long n) { return print(n) + println(); }
+
+void EthernetServer::begin(void)
+{
+}
+
+/**
+ * like the lwIP socket table: lowest connection with unread data, even if it is
+ * already being served
+ */
+EthernetClient EthernetServer::available(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < lb_num_conns; i++) {
+        if (!lb_conns[i].stopped && lb_unread(&lb_conns[i]) > 0)
+            return EthernetClient(&lb_conns[i]);
+    }
+    return EthernetClient();
+}
+
+void EthernetClass::begin(uint8_t *mac, IPAddress ip, IPAddress dns, IPAddress gateway,
+                          IPAddress subnet)
+{
+    (void)mac;
+    this->ip = ip;
+    this->dns = dns;
+    this->gateway = gateway;
+    this->subnet = subnet;
+}
+
+int EthernetClass::begin(uint8_t *mac)
+{
+    (void)mac;
+    return 0;
+}
+
+void EthernetClass::macAddress(uint8_t *mac)
+{
+    memset(mac, 0, 6);
+}
+
+/* Simulated clients ********************************************************/
+
+static void lb_append(struct lb_conn *c, const void *data, uint32_t len)
+{
+    c->req = (char *)realloc(c->req, c->reqlen + len);
+    if (c->req == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    memcpy(c->req + c->reqlen, data, len);
+    c->reqlen += len;
+}
+
+static void lb_append_str(struct lb_conn *c, const char *s)
+{
+    lb_append(c, s, (uint32_t)strlen(s));
+}
+
+/**
+ * multipart/form-data POST of data to path
+ */
+static void lb_make_post(struct lb_conn *c, const char *path, const uint8_t *data, uint32_t len)
+{
+    char head[256];
+    const char *part = "--" LB_BOUNDARY "\r\n"
+                       "Content-Disposition: form-data; name=\"file\"; filename=\"up.bin\"\r\n"
+                       "Content-Type: application/octet-stream\r\n"
+                       "\r\n";
+    const char *tail = "\r\n--" LB_BOUNDARY "--\r\n";
+
+    snprintf(head, sizeof(head),
+             "POST %s HTTP/1.1\r\n"
+             "Host: fit\r\n"
+             "Content-Type: multipart/form-data; boundary=" LB_BOUNDARY "\r\n"
+             "Content-Length: %u\r\n"
+             "\r\n", path, (unsigned int)(strlen(part) + len + strlen(tail)));
+    lb_append_str(c, head);
+    lb_append_str(c, part);
+    lb_append(c, data, len);
+    lb_append_str(c, tail);
+}
+
+static void lb_make_client(struct lb_conn *c, lb_kind_t kind, uint32_t id)
+{
+    uint8_t data[1500];
+    char line[256];
+    uint32_t i;
+
+    memset(c, 0, sizeof(*c));
+    c->kind = kind;
+    c->open = true;
+
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = (uint8_t)('A' + (i + id) % 26);
+
+    switch (kind) {
+    case LB_GET_JSON:
+        lb_append_str(c, "GET /getinfo.txt HTTP/1.1\r\nHost: fit\r\n\r\n");
+        break;
+    case LB_GET_INDEX:
+        lb_append_str(c, "GET / HTTP/1.1\r\nHost: fit\r\n\r\n");
+        break;
+    case LB_GET_LOGO:
+        lb_append_str(c, "GET /gemalto.png HTTP/1.1\r\n\r\n");
+        break;
+    case LB_GET_CONSUME:
+        snprintf(line, sizeof(line), "GET /consume?%u HTTP/1.1\r\n\r\n", (unsigned int)id);
+        lb_append_str(c, line);
+        break;
+    case LB_GET_UNKNOWN:
+        snprintf(line, sizeof(line), "GET /no%%20such/page%u?x=1 HTTP/1.1\r\n\r\n",
+                 (unsigned int)id);
+        lb_append_str(c, line);
+        break;
+    case LB_LINE_TOO_LONG:
+        lb_append_str(c, "GET /getinfo.txt?");
+        lb_append(c, data, 200);
+        lb_append_str(c, " HTTP/1.1\r\n\r\n");
+        break;
+    case LB_BAD_METHOD:
+        lb_append_str(c, "PUT /aeskey HTTP/1.1\r\n\r\n");
+        break;
+    case LB_POST_AES:
+        lb_make_post(c, "/aeskey", lb_aes_key, sizeof(lb_aes_key));
+        break;
+    case LB_POST_RSA_BIG:
+        lb_make_post(c, "/rsakey", data, sizeof(data));
+        break;
+    case LB_POST_RSA_BAD:
+        lb_make_post(c, "/rsakey", data, 300);
+        break;
+    case LB_POST_V2C_BAD:
+        lb_make_post(c, "/v2c", data, 100);
+        break;
+    case LB_STALL_REQUEST:
+        lb_append_str(c, "GET /getinfo.txt HT");
+        break;
+    case LB_STALL_BODY:
+        lb_make_post(c, "/aeskey", data, 200);
+        break;
+    case LB_CLOSE_REQUEST:
+        lb_append_str(c, "GET /getinfo.txt?closed");
+        break;
+    default:
+        break;
+    }
+
+    c->limit = c->reqlen;
+    if (kind == LB_STALL_BODY)
+        c->limit = c->reqlen - 150;
+}
+
+/**
+ * every client sends the next piece of its request with probability 1/3; a client
+ * that has sent everything it is going to send stalls or closes its side
+ */
+static void lb_clients_send(struct lb_conn *conns, uint32_t num)
+{
+    struct lb_conn *c;
+    uint32_t i, n;
+
+    for (i = 0; i < num; i++) {
+        c = &conns[i];
+        if (c->stopped || c->sent >= c->limit || lb_rand() % 3 != 0)
+            continue;
+        n = 1 + lb_rand() % LB_MAX_CHUNK;
+        if (n > c->limit - c->sent)
+            n = c->limit - c->sent;
+        c->sent += n;
+        if (c->sent == c->limit && c->kind == LB_CLOSE_REQUEST)
+            c->open = false;
+    }
+}
+
+/**
+ * poll server until all connections are closed by it; returns 0 on success
+ */
+static int lb_run(struct lb_conn *conns, uint32_t num)
+{
+    uint32_t i, ticks, open;
+
+    lb_conns = conns;
+    lb_num_conns = num;
+
+    for (ticks = 0; ticks < LB_MAX_TICKS; ticks++) {
+        lb_clients_send(conns, num);
+        loop();
+        lb_now++;
+
+        for (open = 0, i = 0; i < num; i++)
+            open += !conns[i].stopped;
+        if (open == 0)
+            return 0;
+    }
+
+    fprintf(stderr, "%u of %u connections still open after %u ms\n",
+            (unsigned int)open, (unsigned int)num, (unsigned int)ticks);
+    return -1;
+}
+
+/**
+ * check reply of one client; returns 0 if it is the expected one, 1 for 503 and -1 if it
+ * is not expected
+ */
+static int lb_check(struct lb_conn *c)
+{
+    const lb_expect_t *e = &lb_kinds[c->kind];
+    const char *busy = "HTTP/1.1 503";
+
+    if (c->late_writes != 0)
+        return -1;
+
+    if (c->resplen >= strlen(busy) && memcmp(c->resp, busy, strlen(busy)) == 0)
+        return e->busy_ok ? 1 : -1;
+
+    if (e->status == NULL) {
+        /* dropped without reply, stalled ones not before idle timeout */
+        if (c->resplen != 0)
+            return -1;
+        if (c->kind != LB_CLOSE_REQUEST && c->closed - c->lastread <= LB_IDLE_TIMEOUT)
+            return -1;
+        return 0;
+    }
+
+    if (c->resplen < strlen(e->status) || memcmp(c->resp, e->status, strlen(e->status)) != 0)
+        return -1;
+    if (e->body != NULL && strstr(c->resp, e->body) == NULL)
+        return -1;
+    return 0;
+}
+
+/**
+ * returns 0 if the active slot of A/B object ab holds data passed in
+ */
+static int lb_region_is(const ee_ab_t *ab, const void *data, uint32_t len)
+{
+    fit_pointer_t fp;
+    uint8_t buf[EE_AES_MAXSIZE];
+
+    set_fit_ptr_ab(&fp, ab);
+    if (fp.length != len || len > sizeof(buf))
+        return -1;
+    read_eeprom_block(buf, fp.data, (uint16_t)len);
+    return memcmp(buf, data, len) == 0 ? 0 : -1;
+}
+
+static void lb_free(struct lb_conn *conns, uint32_t num)
+{
+    uint32_t i;
+
+    for (i = 0; i < num; i++) {
+        free(conns[i].req);
+        free(conns[i].resp);
+    }
+    free(conns);
+}
+
+static void usage(const char *prog)
+{
+    printf("Usage: %s [-n clients] [-s seed] > console.log\n"
+           "  -n clients number of simulated clients (default %u)\n"
+           "  -s seed    seed of random request splitting (default 1)\n",
+           prog, (unsigned int)LB_DEFAULT_CLIENTS);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t num = LB_DEFAULT_CLIENTS;
+    uint32_t ok[LB_NUM_KINDS], busy[LB_NUM_KINDS], failed[LB_NUM_KINDS], count[LB_NUM_KINDS];
+    struct lb_conn *conns;
+    uint32_t i, stored = 0;
+    int opt, rv = 0, r;
+
+    while ((opt = getopt(argc, argv, "n:s:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            num = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            lb_rand_state = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return (opt == 'h') ? 0 : 1;
+        }
+    }
+    if (num < LB_NUM_KINDS) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (eeprom_open(NULL, 0) != 0) {
+        fprintf(stderr, "cannot set up EEPROM\n");
+        return 1;
+    }
+    /* keys stored in the former EEPROM layout, taken over by setup() */
+    blob_write_ee(EE_OLD_AES_OFFSET, EE_OLD_AES_MAXSIZE, (char *)lb_aes_seed, sizeof(lb_aes_seed) - 1);
+    blob_write_ee(EE_RSA_OFFSET, EE_OLD_RSA_MAXSIZE, (char *)lb_rsa_seed, sizeof(lb_rsa_seed) - 1);
+    setup();
+
+    /* all clients connect at once */
+    conns = (struct lb_conn *)calloc(num, sizeof(struct lb_conn));
+    if (conns == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < num; i++)
+        lb_make_client(&conns[i], (lb_kind_t)(i % LB_NUM_KINDS), i);
+
+    rv |= lb_run(conns, num);
+
+    memset(ok, 0, sizeof(ok));
+    memset(busy, 0, sizeof(busy));
+    memset(failed, 0, sizeof(failed));
+    memset(count, 0, sizeof(count));
+    for (i = 0; i < num; i++) {
+        r = lb_check(&conns[i]);
+        count[conns[i].kind]++;
+        if (r == 0)
+            ok[conns[i].kind]++;
+        else if (r > 0)
+            busy[conns[i].kind]++;
+        else
+            failed[conns[i].kind]++;
+    }
+    stored = ok[LB_POST_AES];
+
+    fprintf(stderr, "%-20s %8s %8s %8s %8s\n", "client", "count", "ok", "503", "failed");
+    for (i = 0; i < LB_NUM_KINDS; i++) {
+        fprintf(stderr, "%-20s %8u %8u %8u %8u\n", lb_kinds[i].name, (unsigned int)count[i],
+                (unsigned int)ok[i], (unsigned int)busy[i], (unsigned int)failed[i]);
+        if (failed[i] != 0)
+            rv = -1;
+    }
+    lb_free(conns, num);
+
+    /* rejected and abandoned uploads keep stored keys */
+    if (lb_region_is(&ee_ab_rsa, lb_rsa_seed, sizeof(lb_rsa_seed) - 1) != 0) {
+        fprintf(stderr, "stored RSA key changed by rejected upload\n");
+        rv = -1;
+    }
+    /* every AES upload may have been turned away while the upload lock was held */
+    if (stored == 0) {
+        if (lb_region_is(&ee_ab_aes, lb_aes_seed, sizeof(lb_aes_seed) - 1) != 0) {
+            fprintf(stderr, "stored AES key changed without accepted upload\n");
+            rv = -1;
+        }
+    } else if (lb_region_is(&ee_ab_aes, lb_aes_key, sizeof(lb_aes_key)) != 0) {
+        fprintf(stderr, "uploaded AES key not stored\n");
+        rv = -1;
+    }
+
+    /* nothing leaked: every slot and the upload lock are free again */
+    conns = (struct lb_conn *)calloc(5, sizeof(struct lb_conn));
+    if (conns == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    for (i = 0; i < 4; i++)
+        lb_make_client(&conns[i], LB_GET_JSON, i);
+    lb_make_client(&conns[4], LB_POST_AES, 4);
+    rv |= lb_run(conns, 5);
+    for (i = 0; i < 5; i++) {
+        if (lb_check(&conns[i]) != 0) {
+            fprintf(stderr, "idle server: %s failed\n", lb_kinds[conns[i].kind].name);
+            rv = -1;
+        }
+    }
+    lb_free(conns, 5);
+
+    fprintf(stderr, "%s\n", rv ? "FAILED" : "PASSED");
+    eeprom_close();
+    return rv ? 1 : 0;
+}
+
+#endif // #ifdef __linux__
@@ -10,6 +10,7 @@
 
 #include <fit/hwdep/tm4c1294xl_energia/fit_get_time.h>
 #include "fit_hwdep.h"
+#include "fit_api.h"
 
 
 void fit_board_setup(void)
@@ -17,5 +18,15 @@ void fit_board_setup(void)
     fit_led_init();
     fit_uart_init(0);
     FIT_TIME_INIT();
+
+    /* multi byte reads of license and keys */
+    fit_licenf_register_read_block((fit_read_byte_callback_t)FIT_READ_BYTE_RAM,
+                                   (fit_read_block_callback_t)FIT_READ_BLOCK_RAM);
+    fit_licenf_register_read_block((fit_read_byte_callback_t)FIT_READ_BYTE_E2,
+                                   (fit_read_block_callback_t)FIT_READ_BLOCK_E2);
+#ifdef FIT_USE_FLASH
+    fit_licenf_register_read_block((fit_read_byte_callback_t)FIT_READ_BYTE_FLASH,
+                                   (fit_read_block_callback_t)FIT_READ_BLOCK_FLASH);
+#endif
 }
 
@@ -10,12 +10,97 @@
 
 #include "Energia.h"
 #include "driverlib/eeprom.h"
+#include <string.h>
 
 
 //#include <stdint.h>
 //#include "driverlib/rom.h"
 //#include "driverlib/rom_map.h"
 
+/*
+ * EEPROM read cache. Direct mapped, EE_CACHE_LINES lines of EE_CACHE_LINE_SIZE
+ * bytes each, keyed by EEPROM address of the line. Sequential reads of license
+ * and keys then cost one EEPROM access per line instead of one per byte.
+ */
+#define EE_CACHE_LINE_SIZE  16
+#ifndef EE_CACHE_LINES
+#define EE_CACHE_LINES      8
+#endif
+
+static uint32_t ee_cache_data[EE_CACHE_LINES][EE_CACHE_LINE_SIZE/4];
+static uint32_t ee_cache_addr[EE_CACHE_LINES];
+static uint8_t  ee_cache_valid[EE_CACHE_LINES];
+static uint32_t ee_cache_hits;
+static uint32_t ee_cache_misses;
+
+/*
+ * EEPROM is organized in blocks of 16 words. Number of words programmed into
+ * each block since power up is counted, see eeprom_block_writes.
+ */
+#define EE_BLOCK_SIZE       64
+#define EE_BLOCKS           96
+
+static uint32_t ee_block_writes[EE_BLOCKS];
+
+/**
+ *
+ * ee_cache_line
+ *
+ * Returns cache line containing EEPROM address passed in. Line is read from
+ * EEPROM if not present in cache.
+ *
+ * @param   addr --> EEPROM address.
+ *
+ */
+
+static const uint8_t *ee_cache_line (uint32_t addr)
+{
+    uint32_t lineAddr = addr - (addr % EE_CACHE_LINE_SIZE);
+    uint32_t line = (lineAddr / EE_CACHE_LINE_SIZE) % EE_CACHE_LINES;
+
+    if (ee_cache_valid[line] && ee_cache_addr[line] == lineAddr) {
+        ee_cache_hits++;
+    } else {
+        ee_cache_misses++;
+        ROM_EEPROMRead(ee_cache_data[line], lineAddr, EE_CACHE_LINE_SIZE);
+        ee_cache_addr[line] = lineAddr;
+        ee_cache_valid[line] = 1;
+    }
+
+    return (const uint8_t *)ee_cache_data[line];
+}
+
+/**
+ *
+ * eeprom_cache_invalidate
+ *
+ * Invalidates complete EEPROM read cache. Must be called after EEPROM is
+ * modified other than by the write functions below (e.g. EEPROMMassErase).
+ *
+ */
+
+void eeprom_cache_invalidate (void)
+{
+    memset(ee_cache_valid, 0, sizeof(ee_cache_valid));
+}
+
+/**
+ *
+ * eeprom_cache_stats
+ *
+ * Returns number of EEPROM read cache hits and misses.
+ *
+ * @param   hits --> pointer to integer that will contain number of hits.
+ * @param   misses --> pointer to integer that will contain number of misses.
+ *
+ */
+
+void eeprom_cache_stats (uint32_t *hits, uint32_t *misses)
+{
+    *hits = ee_cache_hits;
+    *misses = ee_cache_misses;
+}
+
 /**
  *
  * read_eeprom_u8
@@ -28,14 +113,64 @@
 
 uint8_t read_eeprom_u8 (const uint8_t *p)
 {
-    uint32_t x = 0;
     uint32_t addr = (uint32_t)p;
-    uint32_t byteAddr = addr - (addr % 4);
 
-    ROM_EEPROMRead(&x, byteAddr, 4);
-    x = x >> (8*(addr % 4));
+    return ee_cache_line(addr)[addr % EE_CACHE_LINE_SIZE];
+}
+
+/**
+ *
+ * read_eeprom_block
+ *
+ * Reads len bytes of data from data pointer passed in. Data is read line wise
+ * through EEPROM read cache.
+ *
+ * @param   dst --> pointer to destination buffer.
+ * @param   p   --> pointer to data.
+ * @param   len --> number of bytes to read.
+ *
+ */
+
+void read_eeprom_block (uint8_t *dst, const uint8_t *p, uint16_t len)
+{
+    uint32_t addr = (uint32_t)p;
+    uint32_t ofs, n;
+
+    while (len > 0) {
+        ofs = addr % EE_CACHE_LINE_SIZE;
+        n = EE_CACHE_LINE_SIZE - ofs;
+        if (n > len)
+            n = len;
+        memcpy(dst, ee_cache_line(addr) + ofs, n);
+        dst += n;
+        addr += n;
+        len -= n;
+    }
+}
+
+/**
+ *
+ * ee_programmed
+ *
+ * Accounts for count words programmed at addr: counts them per EEPROM block
+ * and drops cached copies of modified lines.
+ *
+ */
+
+static void ee_programmed (uint32_t addr, uint32_t count)
+{
+    uint32_t lineAddr, line;
+
+    while (count--) {
+        lineAddr = addr - (addr % EE_CACHE_LINE_SIZE);
+        line = (lineAddr / EE_CACHE_LINE_SIZE) % EE_CACHE_LINES;
+        if (ee_cache_addr[line] == lineAddr)
+            ee_cache_valid[line] = 0;
 
-    return (uint8_t) x;
+        if (addr / EE_BLOCK_SIZE < EE_BLOCKS)
+            ee_block_writes[addr / EE_BLOCK_SIZE]++;
+        addr += 4;
+    }
 }
 
 void write_eeprom_u8 (int address, uint8_t value)
@@ -50,6 +185,84 @@ void write_eeprom_u8 (int address, uint8_t value)
 
     if (x != y) {
         ROM_EEPROMProgram(&y, byteAddr, 4);
+        ee_programmed(byteAddr, 1);
+    }
+}
+
+/**
+ *
+ * write_eeprom_words
+ *
+ * Writes count 32 bit words to word aligned EEPROM address passed in. Current
+ * content is read block wise and compared; only changed words are programmed,
+ * each run of adjacent changed words with a single ROM_EEPROMProgram call.
+ *
+ * @param   address --> word aligned EEPROM address.
+ * @param   words   --> words to be written.
+ * @param   count   --> number of words.
+ *
+ */
+
+void write_eeprom_words (int address, const uint32_t *words, uint32_t count)
+{
+    uint32_t cur[EE_BLOCK_SIZE / 4];
+    uint32_t n, i, run;
+
+    while (count > 0) {
+        n = EE_BLOCK_SIZE / 4;
+        if (n > count)
+            n = count;
+        ROM_EEPROMRead(cur, address, n * 4);
+
+        i = 0;
+        while (i < n) {
+            if (cur[i] == words[i]) {
+                i++;
+                continue;
+            }
+            run = i;
+            while (i < n && cur[i] != words[i])
+                i++;
+            ROM_EEPROMProgram((uint32_t *)&words[run], address + run * 4, (i - run) * 4);
+            ee_programmed(address + run * 4, i - run);
+        }
+
+        address += n * 4;
+        words += n;
+        count -= n;
     }
 }
 
+/**
+ *
+ * write_eeprom_u32
+ *
+ * Writes 32 bit word to word aligned EEPROM address passed in. The word is
+ * programmed in one operation, so after a power loss it holds either the old
+ * or the new value. Word is programmed only if its value changes.
+ *
+ * @param   address --> word aligned EEPROM address.
+ * @param   value   --> word to be written.
+ *
+ */
+
+void write_eeprom_u32 (int address, uint32_t value)
+{
+    write_eeprom_words(address, &value, 1);
+}
+
+/**
+ *
+ * eeprom_block_writes
+ *
+ * Returns number of words programmed into EEPROM block (16 words, 64 bytes)
+ * since power up.
+ *
+ * @param   block --> block number.
+ *
+ */
+
+uint32_t eeprom_block_writes (uint32_t block)
+{
+    return (block < EE_BLOCKS) ? ee_block_writes[block] : 0;
+}
@@ -26,4 +26,21 @@ uint8_t read_flash_u8 (const uint8_t *p)
 {
     return (uint8_t)pgm_read_byte_near(p);
 }
+
+/**
+ *
+ * read_flash_block
+ *
+ * Reads len bytes of data from data pointer passed in.
+ *
+ * @param   dst --> pointer to destination buffer.
+ * @param   p   --> pointer to data.
+ * @param   len --> number of bytes to read.
+ *
+ */
+void read_flash_block (uint8_t *dst, const uint8_t *p, uint16_t len)
+{
+    while (len--)
+        *dst++ = (uint8_t)pgm_read_byte_near(p++);
+}
 #endif // #ifdef FIT_USE_FLASH
@@ -11,6 +11,7 @@
 
 #include "fit_types.h"
 #include <inttypes.h>
+#include <string.h>
 
 
 /**
@@ -26,3 +27,19 @@ uint8_t read_ram_u8 (const uint8_t *p)
 {
     return (uint8_t)*p;
 }
+
+/**
+ *
+ * read_ram_block
+ *
+ * Reads len bytes of data from data pointer passed in.
+ *
+ * @param   dst --> pointer to destination buffer.
+ * @param   p   --> pointer to data.
+ * @param   len --> number of bytes to read.
+ *
+ */
+void read_ram_block (uint8_t *dst, const uint8_t *p, uint16_t len)
+{
+    memcpy(dst, p, len);
+}
@@ -38,8 +38,6 @@
 #define FIT_UID_LEN                     0x20
 /** Maximum length for any field in sproto (except RSA signature) */
 #define FIT_MAX_FIELD_SIZE              0x20
-/** Davies meyer hash size */
-#define FIT_DM_HASH_SIZE                0x10
 /** Version Regex length*/
 #define FIT_VER_REGEX_LEN               0x20
 
@@ -74,6 +72,8 @@ enum fit_operation_type {
     FIT_OP_GET_DATA_ADDRESS,
     /** Get licence related info */
     FIT_OP_GET_LICENSE_INFO_DATA,
+    /** Build license index i.e. addresses of frequently used license fields */
+    FIT_OP_BUILD_LICENSE_INDEX,
 
 #ifdef FIT_USE_UNIT_TESTS
     /*
@@ -154,10 +154,17 @@ typedef struct fit_context {
         struct {
             /** Pointer to callback function to be called for get info api.*/
             fit_get_info_callback callback_fn;
+            /** Callback function receiving cursor; used instead of callback_fn if set.*/
+            fit_get_info_cursor_callback cursor_fn;
             /** Pointer to requested data for get info api.*/
             void *get_info_data;
+            /** Position of field being parsed.*/
+            fit_info_cursor_t cursor;
         } getinfodata;
 
+        /** Pointer to license index to be filled in.*/
+        fit_license_index_t *licindex;
+
     } parserdata;
 
 } fit_context_data_t;
@@ -270,10 +277,117 @@ typedef struct fit_v2c {
     fit_signature_data_t    *signature;
 } fit_v2c_data_t;
 
+/** Structure defining one counter of a product part (flat license model).*/
+typedef struct fit_lic_counter {
+    /** Counter ID.*/
+    uint32_t        counterid;
+    /** Counter limit.*/
+    uint32_t        limit;
+    /** Counter soft limit.*/
+    uint32_t        softlimit;
+    /** Counter is_field flag.*/
+    uint8_t         isfield;
+} fit_lic_counter_t;
+
+/*
+ * Structure defining one product part (flat license model). Features and counters of
+ * the part are stored consecutively in features/counters arrays of fit_license_info_t.
+ */
+typedef struct fit_lic_prodpart {
+    /** Product Part ID.*/
+    uint32_t        partid;
+    /** Start date information for time based licenses.*/
+    uint32_t        startdate;
+    /** End date information for time based licenses.*/
+    uint32_t        enddate;
+    /** Index of first feature of this part in features array.*/
+    uint16_t        firstfeat;
+    /** Number of features of this part.*/
+    uint16_t        numfeat;
+    /** Index of first counter of this part in counters array.*/
+    uint16_t        firstcounter;
+    /** Number of counters of this part.*/
+    uint16_t        numcounters;
+    /** tell whether feature's are perpetual or not.*/
+    uint8_t         perpetual;
+    /** License type (see enum fit_license_type) */
+    uint8_t         lictype;
+} fit_lic_prodpart_t;
+
+/*
+ * Structure defining license data decoded by fit_licenf_get_license_info. Product
+ * parts, features and counters point into arena buffer provided by caller.
+ */
+typedef struct fit_license_info {
+    /** Structure defining License Header data.*/
+    fit_header_data_t   header;
+    /** License container ID.*/
+    uint32_t            containerid;
+    /** Vendor ID.*/
+    uint32_t            vendorid;
+    /** Product ID.*/
+    uint32_t            prodid;
+    /** Product version related information (zero terminated).*/
+    char                verregex[FIT_VER_REGEX_LEN];
+    /** Algorithm used for signing license data.*/
+    uint16_t            algid;
+    /** Number of entries in prodparts array.*/
+    uint16_t            num_prodparts;
+    /** Number of entries in features array.*/
+    uint16_t            num_features;
+    /** Number of entries in counters array.*/
+    uint16_t            num_counters;
+    /** Product parts, in license order.*/
+    fit_lic_prodpart_t  *prodparts;
+    /** Feature IDs of all product parts.*/
+    uint32_t            *features;
+    /** Counters of all product parts.*/
+    fit_lic_counter_t   *counters;
+} fit_license_info_t;
+
 /* Macro Functions **********************************************************/
 
+/*
+ * Upper bound of arena size needed by fit_licenf_get_license_info for a license of
+ * liclen bytes. Every feature or counter takes at least 8 bytes of license data
+ * (element length, field count and one field) and every product part at least 12,
+ * so no record needs more than twice its license bytes; extra dword covers
+ * alignment of the arena.
+ */
+#define FIT_LICENSE_INFO_ARENA_SIZE(liclen) \
+    (2 * (uint32_t)(liclen) + sizeof(uint32_t))
+
 /* Function Prototypes ******************************************************/
 
+/**
+ *
+ * \skip fit_licenf_get_license_info
+ *
+ * This function decodes license binary into flat structure. Product parts, features
+ * and counters are stored in arrays carved from caller provided arena, so no memory
+ * is allocated. License is parsed twice: first pass counts the records, second pass
+ * fills them in.
+ *
+ * @param IN    license     \n Start address of the license in binary format.
+ *
+ * @param OUT   info        \n On return contains decoded license data.
+ *
+ * @param IN    arena       \n Buffer for product parts, features and counters. Can be
+ *                             NULL to query the needed size. If not dword aligned,
+ *                             up to 3 more bytes are needed.
+ *
+ * @param IO    arenasize   \n On input size of arena in bytes; on return number of
+ *                             bytes needed (see also FIT_LICENSE_INFO_ARENA_SIZE).
+ *
+ * @return FIT_STATUS_OK on success; FIT_STATUS_INSUFFICIENT_MEMORY if arena is too
+ *         small; otherwise appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_get_license_info(fit_pointer_t *license,
+                                         fit_license_info_t *info,
+                                         void *arena,
+                                         uint16_t *arenasize);
+
 
 #endif /* __FIT_H__ */
 
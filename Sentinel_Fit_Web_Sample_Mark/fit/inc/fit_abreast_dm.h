@@ -23,12 +23,36 @@
 /** Abreast DM hash output size */
 #define FIT_ABREAST_DM_HASH_SIZE        0x20
 
+/** Size of message block hashed by abreast dm hash */
+#define FIT_ABREAST_DM_BLOCK_SIZE       0x10
+
 /* Types ********************************************************************/
 
+/** Context for calculating abreast dm hash incrementally (init/update/final).*/
+typedef struct fit_abreastdm_ctx {
+    /** Intermediate hash value (Gi-1 || Hi-1).*/
+    uint8_t hash[FIT_ABREAST_DM_HASH_SIZE];
+    /** Data not hashed yet (less than one message block).*/
+    uint8_t buf[FIT_ABREAST_DM_BLOCK_SIZE];
+    /** Number of bytes in buf.*/
+    uint8_t buflen;
+    /** Number of message bytes passed to update so far.*/
+    uint32_t msglen;
+} fit_abreastdm_ctx_t;
+
 /* Function Prototypes ******************************************************/
 
 /** This function will get the abreast dm hash of the data passed in.*/
 fit_status_t fit_get_abreastdm_hash(fit_pointer_t *msg, uint8_t *hash);
 
+/** Initializes context for incremental abreast dm hash calculation.*/
+void fit_abreastdm_init(fit_abreastdm_ctx_t *ctx);
+
+/** Adds data (in RAM) to abreast dm hash calculation.*/
+void fit_abreastdm_update(fit_abreastdm_ctx_t *ctx, const uint8_t *data, uint16_t len);
+
+/** Pads remaining data and returns abreast dm hash of all data passed to update.*/
+fit_status_t fit_abreastdm_final(fit_abreastdm_ctx_t *ctx, uint8_t *hash);
+
 
 #endif /* __FIT_ABREAST_DM_H__ */
@@ -26,6 +26,16 @@
 /** The number of columns comprising a state in AES. This is a constant in AES. Value=4 */
 #define FIT_AES_NB                  0x4
 
+/* Macro Functions **********************************************************/
+
+/** Read big endian 32 bit word (AES state column) from byte array */
+#define FIT_AES_GETU32(p)       (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | \
+                                 ((uint32_t)(p)[2] << 8) | ((uint32_t)(p)[3]))
+
+/** Write 32 bit word to byte array in big endian order */
+#define FIT_AES_PUTU32(p, v)    { (p)[0] = (uint8_t)((v) >> 24); (p)[1] = (uint8_t)((v) >> 16); \
+                                  (p)[2] = (uint8_t)((v) >> 8); (p)[3] = (uint8_t)(v); }
+
 /* Types ********************************************************************/
 
 typedef struct fit_aes {
@@ -48,6 +58,14 @@ void fit_aes_encrypt(fit_aes_t *aes,
 fit_status_t fit_aes_setup(fit_aes_t *aes,
                            const fit_pointer_t *key,
                            uint8_t *skey);
+/** Encrypts one block with AES-128, expanding key on the fly (no round key buffer).*/
+void fit_aes128_expand_encrypt(const uint8_t *key, uint8_t *block);
+/** Encrypts one block with AES-256, expanding key on the fly (no round key buffer).*/
+void fit_aes256_expand_encrypt(const uint8_t *key, uint8_t *block);
+/** Encrypts one or two blocks (words) with same AES-256 key, expanding key on the fly.*/
+void fit_aes256_encrypt_words(const uint32_t *key, uint32_t *lane0, uint32_t *lane1);
+void add_round_key(uint8_t *state, const uint8_t *key, uint16_t round);
+void sub_bytes(uint8_t *state);
 void fit_shift_rows(uint8_t *state);
 void fit_mix_columns(uint8_t *state);
 void fit_block_copy(uint8_t *output, uint8_t *input);
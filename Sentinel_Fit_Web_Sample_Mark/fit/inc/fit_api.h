@@ -107,6 +107,40 @@ fit_status_t fit_licenf_consume_license(fit_pointer_t *license,
                                         uint32_t feature_id,
                                         fit_key_array_t *keys);
 
+/**
+ *
+ * \skip fit_licenf_consume_license_idx
+ *
+ * This function is same as fit_licenf_consume_license except that addresses of
+ * license fields (signature, fingerprint, license property blocks etc.) are taken
+ * from license index instead of parsing complete license binary.
+ *
+ * @param IN  \b  license       \n  Start address of the license in binary format,
+ *                                  depending on your READ_LICENSE_BYTE definition
+ *                                  e.g. in case of RAM, this can just be the memory
+ *                                  address of the license variable 
+ *
+ * @param IN  \b  feature_id    \n  feature id which will be consumed/used for login
+ *                                  operation.
+ *
+ * @param IN  \b  keys          \n  Pointer to array of key data. Also contains
+ *                                  callback function to read key data in different
+ *                                  types of memory(FLASH, E2, RAM).
+ *
+ * @param IN  \b  licindex      \n  Pointer to license index built by
+ *                                  fit_licenf_build_license_index for license
+ *                                  passed in.
+ *
+ * @return same values as fit_licenf_consume_license.
+ * @return FIT_STATUS_INVALID_PARAM_3 if license index is not valid for license
+ *                                    passed in.
+ *
+ */
+fit_status_t fit_licenf_consume_license_idx(fit_pointer_t *license,
+                                            uint32_t feature_id,
+                                            fit_key_array_t *keys,
+                                            fit_license_index_t *licindex);
+
 /**
  *
  * \skip fit_licenf_get_info
@@ -133,6 +167,30 @@ fit_status_t fit_licenf_get_info(fit_pointer_t* license,
                                  fit_get_info_callback callback_fn,
                                  void *context);
 
+/**
+ *
+ * \skip fit_licenf_get_info_cursor
+ *
+ * Same as fit_licenf_get_info, but callback function also receives position of
+ * every field i.e. tag ids of enclosing objects/arrays and element numbers of
+ * enclosing arrays. All traversal state is kept on stack of this call, so callback
+ * does not need static variables to know e.g. which product part a feature belongs
+ * to, and several licenses can be traversed at the same time.
+ *
+ * @param IN    \b  license     \n Start address of the license in binary format.
+ *
+ * @param IN    \b  callback_fn \n User provided callback function to be called by
+ *                                 fit core.
+ *
+ * @param IO    \b  context     \n Pointer to user provided data structure.
+ *
+ * @return FIT_STATUS_OK on success; otherwise, returns appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_get_info_cursor(fit_pointer_t* license,
+                                        fit_get_info_cursor_callback callback_fn,
+                                        void *context);
+
 /**
  *
  * \skip fit_licenf_validate_license
@@ -155,6 +213,58 @@ fit_status_t fit_licenf_get_info(fit_pointer_t* license,
 fit_status_t fit_licenf_validate_license(fit_pointer_t *license,
                                          fit_key_array_t *keys);
 
+/**
+ *
+ * \skip fit_licenf_build_license_index
+ *
+ * This function will parse the license binary once and record addresses of
+ * signature, algorithm id, header, fingerprint, license container and license
+ * property blocks in license index. Licensing model of each license property block
+ * is decoded and, with FIT_USE_FEATURE_INDEX, feature ids are recorded in a hash
+ * table, so that consume does not parse license data.
+ *
+ * License index must be built again after any write to license data. Functions
+ * taking license index reject it (FIT_STATUS_INVALID_PARAM_3) if license address,
+ * length or leading signature bytes differ from those recorded at build time, but
+ * this check is not a substitute for rebuilding the index.
+ *
+ * @param IN    \b  license     \n Pointer to fit_pointer_t structure containing license
+ *                                 data. To access the license data in different types of
+ *                                 memory (FLASH, E2, RAM), fit_pointer_t is used.
+ *
+ * @param OUT   \b  licindex    \n Pointer to license index to be filled in.
+ *
+ * @return FIT_STATUS_OK on success; otherwise, returns appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_build_license_index(fit_pointer_t *license,
+                                            fit_license_index_t *licindex);
+
+/**
+ *
+ * \skip fit_licenf_validate_license_idx
+ *
+ * This function is same as fit_licenf_validate_license except that addresses of
+ * license fields are taken from license index instead of parsing license binary.
+ *
+ * @param IN    \b  license     \n Pointer to fit_pointer_t structure containing license
+ *                                 data. To access the license data in different types of
+ *                                 memory (FLASH, E2, RAM), fit_pointer_t is used.
+ *
+ * @param IN    \b  keys    \n Pointer to array of key data. Also contains callback
+ *                             function to read key data in differenttypes of memory
+ *                             (FLASH, E2, RAM).
+ *
+ * @param IN    \b  licindex    \n Pointer to license index built by
+ *                                 fit_licenf_build_license_index for license passed in.
+ *
+ * @return FIT_STATUS_OK on success; otherwise, returns appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_validate_license_idx(fit_pointer_t *license,
+                                             fit_key_array_t *keys,
+                                             fit_license_index_t *licindex);
+
 /**
  *
  * \skip fit_licenf_get_version
@@ -178,6 +288,172 @@ fit_status_t fit_licenf_get_version(uint8_t *major_version,
                                     uint8_t *minor_version,
                                     uint8_t *revision);
 
+/**
+ *
+ * \skip fit_licenf_rsa_key_cache_invalidate
+ *
+ * This function drops RSA public key kept parsed between signature verifications
+ * (see FIT_USE_RSA_KEY_CACHE). Cached key is also re-parsed automatically when key
+ * data changes; calling this function after storing new key releases memory of old
+ * key at once. Cached license verification results do not depend on this call: key
+ * is identified by Davies Meyer hash of its data on every lookup.
+ *
+ */
+void fit_licenf_rsa_key_cache_invalidate(void);
+
+/**
+ *
+ * \skip fit_licenf_aes_key_cache_invalidate
+ *
+ * This function drops expanded AES signing key kept between OMAC verifications (see
+ * FIT_USE_AES_KEY_CACHE). Cached key is also expanded again automatically when key
+ * data changes; calling this function after storing new key clears old round keys
+ * from RAM at once.
+ *
+ */
+void fit_licenf_aes_key_cache_invalidate(void);
+
+/**
+ *
+ * \skip fit_licenf_register_read_block
+ *
+ * This function registers block read function for memory read by read byte
+ * callback passed in. Core then reads field headers, hash input, keys and
+ * signatures of fit_pointer_t and fit_key_array_t using that read byte callback
+ * with one block read call instead of one call per byte. Data of read byte
+ * callbacks without block read function is read byte by byte. fit_board_setup
+ * registers block read functions of board memories (FIT_READ_BYTE_RAM,
+ * FIT_READ_BYTE_E2 and, if enabled, FIT_READ_BYTE_FLASH).
+ *
+ * @param IN    \b  read_byte   \n Read byte callback used in fit_pointer_t or
+ *                                 fit_key_array_t.
+ *
+ * @param IN    \b  read_block  \n Function reading len bytes of same memory into
+ *                                 RAM buffer; NULL to remove registered function.
+ *
+ * @return FIT_STATUS_OK on success; FIT_STATUS_INSUFFICIENT_MEMORY if
+ *         FIT_MAX_READ_BLOCK_CALLBACKS functions are registered already; otherwise,
+ *         returns appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_register_read_block(fit_read_byte_callback_t read_byte,
+                                            fit_read_block_callback_t read_block);
+
+/**
+ *
+ * \skip fit_licenf_revalidate_license_idx
+ *
+ * This function is same as fit_licenf_validate_license_idx except that RSA signature
+ * is not verified again if result of verification of same license data against same
+ * RSA public key is cached (see FIT_VERIFY_CACHE_SIZE and
+ * fit_licenf_set_verify_record); only Davies Meyer hash of license is calculated
+ * then. Node lock verification is always done.
+ *
+ * @param IN    \b  license     \n Pointer to fit_pointer_t structure containing license
+ *                                 data. To access the license data in different types of
+ *                                 memory (FLASH, E2, RAM), fit_pointer_t is used.
+ *
+ * @param IN    \b  keys    \n Pointer to array of key data. Also contains callback
+ *                             function to read key data in differenttypes of memory
+ *                             (FLASH, E2, RAM).
+ *
+ * @param IN    \b  licindex    \n Pointer to license index built by
+ *                                 fit_licenf_build_license_index for license passed in.
+ *
+ * @return FIT_STATUS_OK on success; otherwise, returns appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_revalidate_license_idx(fit_pointer_t *license,
+                                               fit_key_array_t *keys,
+                                               fit_license_index_t *licindex);
+
+/**
+ *
+ * \skip fit_licenf_get_verify_record
+ *
+ * This function is used for getting record of last successful RSA license
+ * verification. Application can keep the record in non volatile memory and pass it
+ * to fit_licenf_set_verify_record after reboot, so that license is not RSA verified
+ * again. Record must be stored as safe against modification as the RSA public key.
+ *
+ * @param OUT   \b  record  \n On return it will contain the verification record.
+ *
+ * @return FIT_STATUS_OK on success; FIT_STATUS_LIC_CACHING_ERROR if no license is
+ *         verified; otherwise, returns appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_get_verify_record(fit_verify_record_t *record);
+
+/**
+ *
+ * \skip fit_licenf_set_verify_record
+ *
+ * This function restores record of RSA license verification taken by
+ * fit_licenf_get_verify_record. Record is used by fit_licenf_revalidate_license_idx
+ * and consume functions only if license and key data still match it.
+ *
+ * @param IN    \b  record  \n Pointer to verification record.
+ *
+ * @return FIT_STATUS_OK on success; FIT_STATUS_LIC_CACHING_ERROR if record is made
+ *         by other core version or is not one of successful verification; otherwise,
+ *         returns appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_set_verify_record(const fit_verify_record_t *record);
+
+/**
+ *
+ * \skip fit_licenf_verify_cache_invalidate
+ *
+ * This function drops all license verification results kept in RAM (see
+ * FIT_VERIFY_CACHE_SIZE). Not needed on key change: results are kept per key, and
+ * key is identified by Davies Meyer hash of its data on every lookup.
+ *
+ */
+void fit_licenf_verify_cache_invalidate(void);
+
+/**
+ *
+ * \skip fit_licenf_get_verify_cache_stats
+ *
+ * This function is used for getting statistics of license verification cache.
+ *
+ * @param OUT   \b  hits    \n On return it will contain number of license uses that
+ *                             did not need RSA verification.
+ *
+ * @param OUT   \b  misses  \n On return it will contain number of license uses that
+ *                             needed RSA verification.
+ *
+ * @return FIT_STATUS_OK on success; otherwise, returns appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_get_verify_cache_stats(uint32_t *hits, uint32_t *misses);
+
+/**
+ *
+ * \skip fit_licenf_compile_rsa_key
+ *
+ * This function converts RSA-2048 public key (PEM or DER) into compiled key record
+ * (see FIT_USE_RSA_FIXED_VERIFY). Record holds the key values needed for signature
+ * verification, so storing it instead of PEM key saves key parsing (base64, ASN.1)
+ * and Montgomery setup on every verification.
+ *
+ * @param IN    \b  key     \n Pointer to fit_pointer_t structure containing RSA public
+ *                             key data.
+ *
+ * @param OUT   \b  record  \n Buffer of at least FIT_RSA_KEY_RECORD_SIZE bytes.
+ *
+ * @param IO    \b  length  \n Size of record buffer; on return length of record.
+ *
+ * @return FIT_STATUS_OK on success; FIT_STATUS_INVALID_RSA_PUBKEY if key is not
+ *         RSA-2048 key with odd public exponent less than 2^32; otherwise, returns
+ *         appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_compile_rsa_key(fit_pointer_t *key,
+                                        uint8_t *record,
+                                        uint16_t *length);
+
 #ifdef __cplusplus
 }
 #endif
@@ -39,5 +39,29 @@
 #define FIT_USE_COMX
 #endif
 
+#if defined(FIT_USE_FEATURE_INDEX) && (!defined(FIT_FEATURE_INDEX_SIZE) ||   \
+                                       (FIT_FEATURE_INDEX_SIZE) < 2 ||       \
+                                       (FIT_FEATURE_INDEX_SIZE) > 0x8000 ||  \
+                                       ((FIT_FEATURE_INDEX_SIZE) & ((FIT_FEATURE_INDEX_SIZE)-1)) != 0)
+#error "FIT_FEATURE_INDEX_SIZE must be a power of 2 when FIT_USE_FEATURE_INDEX is defined"
+#endif
+
+#if defined(FIT_VERIFY_CACHE_SIZE) && ((FIT_VERIFY_CACHE_SIZE) < 1 ||  \
+                                       (FIT_VERIFY_CACHE_SIZE) > 0xFF)
+#error "FIT_VERIFY_CACHE_SIZE must be between 1 and 255"
+#endif
+
+#if defined(FIT_USE_RSA_FIXED_VERIFY) && !defined(FIT_USE_RSA_SIGNING)
+#error "FIT_USE_RSA_FIXED_VERIFY requires FIT_USE_RSA_SIGNING"
+#endif
+
+#if defined(FIT_USE_AES_KEY_CACHE) && !defined(FIT_USE_AES_SIGNING)
+#error "FIT_USE_AES_KEY_CACHE requires FIT_USE_AES_SIGNING"
+#endif
+
+#if defined(FIT_USE_AES_TTABLE) && defined(__AVR__)
+#error "FIT_USE_AES_TTABLE is not supported on AVR (table is read without pgm_read_dword)"
+#endif
+
 
 #endif /* __FIT_CHECK_CONFIG_H__ */
@@ -34,6 +34,40 @@
 */
 #define FIT_USE_PEM
 
+/**
+ * \def FIT_USE_RSA_KEY_CACHE
+ *
+ * Keep parsed RSA public key (mbedtls pk context, including Montgomery constant)
+ * between signature verifications. Key is parsed again only if Davies Meyer hash
+ * of key data changes.
+ *
+ * Comment if RAM for keeping parsed RSA public key is not available.
+ */
+#define FIT_USE_RSA_KEY_CACHE
+
+/**
+ * \def FIT_USE_RSA_FIXED_VERIFY
+ *
+ * Verify RSA-2048 signatures with fixed size (2048 bit) Montgomery arithmetic in
+ * statically allocated RAM (about 2KB) instead of mbedtls bignum, which allocates
+ * memory dozens of times per verification. mbedtls is still used for parsing the
+ * public key, and for verification with keys of other size. Keys compiled by
+ * fit_licenf_compile_rsa_key are used directly, without mbedtls key parsing.
+ *
+ * Comment if 2KB of RAM is not available.
+ */
+#define FIT_USE_RSA_FIXED_VERIFY
+
+/**
+ * \def FIT_VERIFY_CACHE_SIZE
+ *
+ * Number of RSA license verification results kept in RAM (least recently used one
+ * is replaced). A license verified before against the same key is not RSA verified
+ * again by consume; only Davies Meyer hash of license data is calculated. Each entry
+ * takes 40 bytes.
+ */
+#define FIT_VERIFY_CACHE_SIZE       4
+
 /**
  * \def FIT_USE_AES_SIGNING
  *
@@ -44,6 +78,28 @@
  */
 #define FIT_USE_AES_SIGNING
 
+/**
+ * \def FIT_USE_AES_TTABLE
+ *
+ * Use word oriented (T-table) AES encryption instead of byte oriented one. Each
+ * round is done with 16 lookups in 1KB table placed in flash, which is several
+ * times faster on 32 bit CPUs. Key schedule (fit_aes_setup) is the same for both.
+ *
+ * Comment if 1KB of extra flash is not available or CPU is 8 bit.
+ */
+#define FIT_USE_AES_TTABLE
+
+/**
+ * \def FIT_USE_AES_KEY_CACHE
+ *
+ * Keep expanded AES signing key and OMAC subkeys between OMAC license verifications
+ * (about 220 bytes of RAM). Key schedule and subkey encryption are done again only
+ * if AES key data changes.
+ *
+ * Comment if RAM for keeping expanded AES key is not available.
+ */
+#define FIT_USE_AES_KEY_CACHE
+
 /**
  * \def FIT_USE_FLASH
  *
@@ -85,6 +141,27 @@
  */
 #define FIT_USE_NODE_LOCKING
 
+/**
+ * \def FIT_USE_FEATURE_INDEX
+ *
+ * License index (see fit_licenf_build_license_index) can contain a hash table that
+ * maps feature id to license property block containing it. With this table
+ * fit_licenf_consume_license_idx does not parse license data for looking up the
+ * feature id. Size of the table is set by FIT_FEATURE_INDEX_SIZE.
+ *
+ * Comment if user does not want to spend RAM on feature table.
+ */
+#define FIT_USE_FEATURE_INDEX
+
+/**
+ * \def FIT_FEATURE_INDEX_SIZE
+ *
+ * Number of entries in feature table of license index. Must be a power of 2. If
+ * license contains more features, consume falls back to parsing license property
+ * blocks.
+ */
+#define FIT_FEATURE_INDEX_SIZE      64
+
 /**
  * \def FIT_USE_SYSTEM_CALLS
  *
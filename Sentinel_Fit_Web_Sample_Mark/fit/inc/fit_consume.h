@@ -36,5 +36,16 @@ fit_status_t fit_find_feature_id(fit_pointer_t *pdata,
 /** This function is used for getting algorithm id used for signing license data. */
 fit_status_t fit_get_license_sign_algid(fit_pointer_t *license, uint32_t *algid);
 
+/** This function is used for getting licensing model from license property data. */
+fit_status_t fit_get_lic_prop_data(fit_pointer_t *pdata, fit_licensemodel_t *licmodel);
+
+#ifdef FIT_USE_FEATURE_INDEX
+/** This function is used for adding feature id to feature table of license index. */
+void fit_feature_index_add(fit_license_index_t *licindex, uint32_t featid, uint8_t lic_prop);
+
+/** This function is used for looking up feature id in feature table of license index. */
+uint8_t fit_feature_index_find(fit_license_index_t *licindex, uint32_t featid);
+#endif /* #ifdef FIT_USE_FEATURE_INDEX */
+
 #endif /* __FIT_CONSUME_LIC_H__ */
 
@@ -19,17 +19,41 @@
 
 /* Constants ****************************************************************/
 
+/** Block size of cipher (AES-128) used in davies meyer hash */
+#define FIT_DM_CIPHER_BLOCK_SIZE            0x10
+
 /* Types ********************************************************************/
 
+/** Context for calculating davies meyer hash incrementally (init/update/final).*/
+typedef struct fit_dm_hash_ctx {
+    /** Intermediate hash value (Hi-1).*/
+    uint8_t hash[FIT_DM_CIPHER_BLOCK_SIZE];
+    /** Data not hashed yet (less than one cipher block).*/
+    uint8_t buf[FIT_DM_CIPHER_BLOCK_SIZE];
+    /** Number of bytes in buf.*/
+    uint8_t buflen;
+    /** Number of message bytes passed to update so far.*/
+    uint32_t msglen;
+} fit_dm_hash_ctx_t;
+
 /* Function Prototypes ******************************************************/
 
 /** This function will be used to get the davies meyer hash of the data passed in */
 fit_status_t fit_davies_meyer_hash(fit_pointer_t *pdata, uint8_t *dmhash);
 
+/** Initializes context for incremental davies meyer hash calculation.*/
+void fit_dm_hash_init(fit_dm_hash_ctx_t *ctx);
+
+/** Adds data (in RAM) to davies meyer hash calculation.*/
+void fit_dm_hash_update(fit_dm_hash_ctx_t *ctx, const uint8_t *data, uint16_t len);
+
+/** Pads remaining data and returns davies meyer hash of all data passed to update.*/
+void fit_dm_hash_final(fit_dm_hash_ctx_t *ctx, uint8_t *dmhash);
+
 /*
  * This function will be used to pad the data to make its length be an even
  * multiple of the block size and include a length encoding
  */
-void fit_dm_hash_init(uint8_t *pdata, uint16_t *pdatalen, uint16_t msgfulllen);
+void fit_dm_hash_pad(uint8_t *pdata, uint16_t *pdatalen, uint16_t msgfulllen);
 
 #endif /* __FIT_DM_HASH_H__ */
@@ -57,6 +57,19 @@ EXTERNC uint8_t  FIT_READ_BYTE_RAM  (const uint8_t *p);
 EXTERNC uint8_t  FIT_READ_BYTE_FLASH  (const uint8_t *p);
 EXTERNC uint8_t  FIT_READ_BYTE_E2  (const uint8_t *p);
 
+/*
+ * Optional block read functions for the same memory types. These are used for
+ * reading multiple bytes at once (field headers, hash input, keys, signatures)
+ * once fit_board_setup registers them (fit_licenf_register_read_block).
+ */
+#define FIT_READ_BLOCK_RAM         read_ram_block
+#define FIT_READ_BLOCK_FLASH       read_flash_block
+#define FIT_READ_BLOCK_E2          read_eeprom_block
+
+EXTERNC void  FIT_READ_BLOCK_RAM  (uint8_t *dst, const uint8_t *src, uint16_t len);
+EXTERNC void  FIT_READ_BLOCK_FLASH  (uint8_t *dst, const uint8_t *src, uint16_t len);
+EXTERNC void  FIT_READ_BLOCK_E2  (uint8_t *dst, const uint8_t *src, uint16_t len);
+
 /*
  * Time specific defines
  */
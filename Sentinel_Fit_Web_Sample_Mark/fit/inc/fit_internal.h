@@ -140,32 +140,44 @@ enum fit_information_codes
 #define FIT_SOFT_LIMIT_FIELD                4
 #define FIT_IS_FIELD                        5
 
-/* Types ********************************************************************/
+/** Number of entries in RSA validation cache */
+#ifndef FIT_VERIFY_CACHE_SIZE
+#define FIT_VERIFY_CACHE_SIZE               4
+#endif
 
-/** Type of licensing model supported.*/
-typedef struct fit_licensemodel
-{
-    /** for perpetual licenses.*/
-    fit_boolean_t   isperpetual;
-    /** for time based licenses.*/
-    fit_boolean_t   isstartdate;
-    /** Start date information for time based licenses.*/
-    uint32_t        startdate;
-    /** for time expiration licenses.*/
-    fit_boolean_t   isenddate;
-    /** End date information for time based licenses.*/
-    uint32_t        enddate;
-} fit_licensemodel_t;
+/* Types ********************************************************************/
 
 /*
- * Global structure for caching RSA validation data. It caches the hash of license
- * string using Davies Meyer hash function.
+ * Entry of RSA validation cache. It records result of RSA verification of license
+ * against a key, both identified by Davies Meyer hash of their data.
  */
-typedef struct fit_cache_data {
-    /** TRUE if RSA operation was performed, FALSE otherwise */
-    fit_boolean_t rsa_check_done;
+typedef struct fit_cache_entry {
     /** Davies Meyer hash of license data.*/
     uint8_t dm_hash[FIT_DM_HASH_SIZE];
+    /** Davies Meyer hash of RSA public key data (key id).*/
+    uint8_t key_hash[FIT_DM_HASH_SIZE];
+    /** Result of RSA verification (FIT_STATUS_OK or FIT_STATUS_INVALID_SIGNATURE).*/
+    fit_status_t status;
+    /** Value of use counter at last use of entry; 0 for free entry.*/
+    uint32_t stamp;
+} fit_cache_entry_t;
+
+/*
+ * Global structure for caching RSA validation data. It keeps results of last
+ * FIT_VERIFY_CACHE_SIZE license verifications (least recently used entry is
+ * replaced), so that several licenses can be used alternately.
+ */
+typedef struct fit_cache_data {
+    /** Cached verification results.*/
+    fit_cache_entry_t entry[FIT_VERIFY_CACHE_SIZE];
+    /** Use counter; stamp of most recently used entry.*/
+    uint32_t clock;
+    /** Number of cache lookups answered from cache.*/
+    uint32_t hits;
+    /** Number of cache lookups that needed RSA verification.*/
+    uint32_t misses;
+    /** Davies Meyer hash of RSA public key data last used (taken on every lookup).*/
+    uint8_t key_hash[FIT_DM_HASH_SIZE];
 } fit_cache_data_t;
 
 /*
@@ -221,16 +233,6 @@ struct fit_testcallbacks
 
 /* Function Prototypes ******************************************************/
 
-/*
- * Callback function for get_info. Called for every item while traversing license data
- * This function will get complete license information for embedded devices
- */
-fit_status_t fit_getlicensedata_cb (uint8_t tagid,
-                                            fit_pointer_t *pdata,
-                                            uint16_t length,
-                                            fit_boolean_t *stop_parse,
-                                            void *context);
-
 /*
  * This function will fetch fingerprint/deviceid for the respective board. This will
  * call the hardware implemented callback function which will give raw data that would
@@ -240,7 +242,8 @@ fit_status_t fit_get_device_fpblob(fit_fingerprint_t* fp,
                                    fit_fp_callback callback_fn);
 
 /** This function is used to validate the fingerprint information present in license data */
-fit_status_t fit_validate_fp_data(fit_pointer_t *license);
+fit_status_t fit_validate_fp_data(fit_pointer_t *license,
+                                  fit_license_index_t *licindex);
 
 /** This function will fetch licensing information present in the data passed in.*/
 fit_status_t fit_testgetinfodata(fit_pointer_t *licenseData, uint8_t *pgetinfo,
@@ -251,7 +254,16 @@ fit_status_t fit_getunixtime(uint32_t *unixtime);
 /** This function is used to validate signature (AES, RSA etc) in the license binary. */
 fit_status_t fit_verify_license(fit_pointer_t *license,
                                 fit_key_array_t *keys,
-                                fit_boolean_t check_cache);
+                                fit_boolean_t check_cache,
+                                fit_license_index_t *licindex);
+
+/** This function is used to check whether license index is built for license data.*/
+fit_boolean_t fit_license_index_ok(fit_pointer_t *license,
+                                   fit_license_index_t *licindex);
+
+/** This function returns checksum of leading signature bytes recorded in license index.*/
+uint32_t fit_license_index_checksum(fit_pointer_t *license,
+                                    fit_license_index_t *licindex);
 
 #ifdef FIT_USE_SYSTEM_CALLS
 #define fit_memcpy memcpy
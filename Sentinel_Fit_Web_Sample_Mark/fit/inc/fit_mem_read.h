@@ -26,6 +26,11 @@
 
 /* Constants ****************************************************************/
 
+/** Number of block read functions that can be registered (one per memory type).*/
+#ifndef FIT_MAX_READ_BLOCK_CALLBACKS
+#define FIT_MAX_READ_BLOCK_CALLBACKS    4
+#endif
+
 /* Forward Declarations *****************************************************/
 
 /* Types ********************************************************************/
@@ -84,4 +89,47 @@ uint32_t read_dword(const uint8_t *address,
  */
 uint8_t fit_read_ram_u8 (const uint8_t *datap);
 
+/**
+ *
+ * fitptr_read_block
+ *
+ * Reads len bytes of data from address passed in. Uses block read function
+ * registered for read_byte callback of pdata (see fit_licenf_register_read_block);
+ * otherwise read_byte callback is called for every byte.
+ *
+ * @param   dst --> pointer to destination buffer.
+ * @param   address --> pointer to data.
+ * @param   len --> number of bytes to read.
+ * @param   pdata --> fit_pointer_t containing read callback functions.
+ *
+ */
+void fitptr_read_block(uint8_t *dst,
+                       const uint8_t *address,
+                       uint16_t len,
+                       const fit_pointer_t *pdata);
+
+/**
+ *
+ * fitptr_read_word
+ *
+ * Reads 2 byte data from address passed in using read callbacks of pdata.
+ *
+ * @param   address --> pointer to data.
+ * @param   pdata --> fit_pointer_t containing read callback functions.
+ *
+ */
+uint16_t fitptr_read_word(const uint8_t *address, const fit_pointer_t *pdata);
+
+/**
+ *
+ * fitptr_read_dword
+ *
+ * Reads 4 byte data (1 dword) from address passed in using read callbacks of pdata.
+ *
+ * @param   address --> pointer to data.
+ * @param   pdata --> fit_pointer_t containing read callback functions.
+ *
+ */
+uint32_t fitptr_read_dword(const uint8_t *address, const fit_pointer_t *pdata);
+
 #endif /* __FIT_MEM_READ_H__ */
@@ -36,15 +36,21 @@
 
 /* Types ********************************************************************/
 
-/** Structure describing OMAC state */
+/** Structure describing OMAC key: expanded AES-128 key and subkeys L.u and L.u^2 */
+typedef struct omac_key
+{
+    fit_aes_t aes;
+    uint32_t Lu[2][OMAC_BLOCK_LENGTH / 4];
+    uint8_t key[OMAC_KEY_LENGTH];
+} omac_key_t;
+
+/** Structure describing OMAC state (blocks are kept as words for 32 bit XOR) */
 typedef struct omac_state
 {
     uint8_t buflen;
-    uint8_t blklen;
-    uint8_t block[OMAC_MAX_CIPHER_BLOCK_SIZE];
-    uint8_t prev[OMAC_MAX_CIPHER_BLOCK_SIZE];
-    uint8_t Lu[2][OMAC_MAX_CIPHER_BLOCK_SIZE];
-    uint8_t key[OMAC_KEY_LENGTH];
+    uint32_t block[OMAC_BLOCK_LENGTH / 4];
+    uint32_t prev[OMAC_BLOCK_LENGTH / 4];
+    omac_key_t *key;
     uint8_t state[4][4];
 } omac_state_t;
 
@@ -64,7 +70,8 @@ fit_status_t fit_omac_memory(uint16_t blocklength,
  * value present in license data is compared against cached omac value.
  */
 fit_status_t fit_validate_omac_signature(fit_pointer_t* license,
-                                         fit_pointer_t* aeskey);
+                                         fit_pointer_t* aeskey,
+                                         fit_license_index_t *licindex);
 
 
 #endif // ifdef FIT_USE_AES_SIGNING
@@ -33,7 +33,8 @@
 /** This function is used for verify RSA signing and license node locking verification */
 fit_status_t fit_verify_rsa_signature(fit_pointer_t *license,
                                       fit_pointer_t *key,
-                                      fit_boolean_t check_cache);
+                                      fit_boolean_t check_cache,
+                                      fit_license_index_t *licindex);
 
 /** This function is to validate rsa signature and hash against rsa public key. */
 fit_status_t fit_validate_rsa_signature(fit_pointer_t *signature,
@@ -45,7 +46,8 @@ fit_status_t fit_validate_rsa_signature(fit_pointer_t *signature,
  * binary and update the hash table with davies meyer hash of license.
  */
 fit_status_t fit_lic_do_rsa_verification(fit_pointer_t* license,
-                                         fit_pointer_t* rsakey);
+                                         fit_pointer_t* rsakey,
+                                         fit_license_index_t *licindex);
 
 #endif // #ifdef FIT_USE_RSA_SIGNING
 #endif /* __FIT_RSA_H__ */
@@ -12,6 +12,13 @@
 #define __FIT_TYPES_H__
 
 /* Required Includes ********************************************************/
+
+#if !defined(FIT_CONFIG_FILE)
+#include "fit_config.h"
+#else
+#include FIT_CONFIG_FILE
+#endif
+
 #ifndef _MSC_VER
 #include <stdint.h>
 #endif
@@ -19,6 +26,22 @@
 
 /* Constants ****************************************************************/
 
+/** No. of leading signature bytes checksummed to identify license of license index */
+#ifndef FIT_LIC_INDEX_CHECK_SIZE
+#define FIT_LIC_INDEX_CHECK_SIZE        0x10
+#endif
+
+/** Maximum no. of license property blocks that can be recorded in license index */
+#ifndef FIT_LIC_INDEX_MAX_LIC_PROPS
+#define FIT_LIC_INDEX_MAX_LIC_PROPS     0x10
+#endif
+
+/** Davies meyer hash size */
+#define FIT_DM_HASH_SIZE                0x10
+
+/** Size of compiled RSA-2048 public key record (see fit_licenf_compile_rsa_key) */
+#define FIT_RSA_KEY_RECORD_SIZE         0x220
+
 /* Types ********************************************************************/
 
 /*
@@ -102,6 +125,13 @@ typedef struct fit_key_data {
 /** Prototype of read "license/RSA public key" byte callback function.*/
 typedef uint8_t (*fit_read_byte_callback_t)(const void *address);
 
+/**
+ * Prototype of read "license/RSA public key" block callback function. Block
+ * reader is not part of fit_pointer_t; core selects it from read_byte callback
+ * (see fitptr_read_block).
+ */
+typedef void (*fit_read_block_callback_t)(uint8_t *dst, const void *src, uint16_t len);
+
 /*
  * To access the license data and RSA public key data in differnt types of memory
  * (FLASH, E2, RAM), following structure is used.
@@ -127,6 +157,94 @@ typedef struct fit_key_array {
 
 } fit_key_array_t;
 
+/** Type of licensing model supported.*/
+typedef struct fit_licensemodel
+{
+    /** for perpetual licenses.*/
+    fit_boolean_t   isperpetual;
+    /** for time based licenses.*/
+    fit_boolean_t   isstartdate;
+    /** Start date information for time based licenses.*/
+    uint32_t        startdate;
+    /** for time expiration licenses.*/
+    fit_boolean_t   isenddate;
+    /** End date information for time based licenses.*/
+    uint32_t        enddate;
+} fit_licensemodel_t;
+
+#ifdef FIT_USE_FEATURE_INDEX
+/** Entry of feature table in license index.*/
+typedef struct fit_feature_index_entry {
+    /** Feature id.*/
+    uint32_t featid;
+    /** Position+1 of license property block (in lic_prop) containing feature; 0 for free entry.*/
+    uint8_t lic_prop;
+} fit_feature_index_entry_t;
+#endif /* #ifdef FIT_USE_FEATURE_INDEX */
+
+/*
+ * License index. Contains addresses of license fields that are needed by validate
+ * and consume operations. It is built once per license, so that these operations
+ * do not need to parse complete license binary on every call.
+ */
+typedef struct fit_license_index {
+    /** FIT_TRUE if index is built successfully; FIT_FALSE otherwise.*/
+    fit_boolean_t valid;
+    /** Start address of license binary against which index is built.*/
+    uint8_t *license;
+    /** Length of license data passed in (fit_pointer_t length) when index was built.*/
+    uint16_t datalength;
+    /** Checksum of leading signature bytes (see fit_license_index_checksum).*/
+    uint32_t checksum;
+    /** Length of complete license binary (V2C data).*/
+    uint16_t length;
+    /** Algorithm id used for signing the license.*/
+    uint32_t algid;
+    /** Address of signature data (RSA signature or OMAC value).*/
+    uint8_t *signature;
+    /** Length of signature data.*/
+    uint16_t siglength;
+    /** Address of license header data.*/
+    uint8_t *header;
+    /** Address of fingerprint data. NULL if license is not node locked.*/
+    uint8_t *fingerprint;
+    /** Address of license container data.*/
+    uint8_t *container;
+    /** Address of license part (signed data) of license binary.*/
+    uint8_t *licdata;
+    /** Length of license part (signed data) of license binary.*/
+    uint16_t liclength;
+    /** FIT_TRUE if license contains more license property blocks than lic_prop can hold.*/
+    fit_boolean_t lic_prop_overflow;
+    /** Number of license property blocks recorded in lic_prop.*/
+    uint8_t num_lic_props;
+    /** Address of each license property block (features and licensing model).*/
+    uint8_t *lic_prop[FIT_LIC_INDEX_MAX_LIC_PROPS];
+    /** Licensing model of each license property block recorded in lic_prop.*/
+    fit_licensemodel_t lic_model[FIT_LIC_INDEX_MAX_LIC_PROPS];
+#ifdef FIT_USE_FEATURE_INDEX
+    /** FIT_TRUE if not all features of license could be recorded in features table.*/
+    fit_boolean_t feature_overflow;
+    /** Hash table (open addressing) mapping feature id to license property block.*/
+    fit_feature_index_entry_t features[FIT_FEATURE_INDEX_SIZE];
+#endif /* #ifdef FIT_USE_FEATURE_INDEX */
+} fit_license_index_t;
+
+/**
+ * Record of successful RSA license verification (see fit_licenf_get_verify_record).
+ * License and RSA public key are identified by Davies Meyer hash of their data.
+ */
+typedef struct fit_verify_record {
+    /** Core version (FIT_CORE_VERSION) that did the verification.*/
+    uint16_t    version;
+    /** Result of the verification (FIT_STATUS_OK).*/
+    uint16_t    status;
+    /** Davies Meyer hash of license binary (V2C data).*/
+    uint8_t     lic_hash[FIT_DM_HASH_SIZE];
+    /** Davies Meyer hash of RSA public key data.*/
+    uint8_t     key_hash[FIT_DM_HASH_SIZE];
+} fit_verify_record_t;
+
 /** Prototype of a get_info callback function.
  *
  * @param IN  \b  tagid         \n  identifier of the value being returned in pdata
@@ -147,6 +265,47 @@ typedef fit_status_t (*fit_get_info_callback)(uint8_t tagid,
                                               fit_boolean_t *stop_parse,
                                               void *context);
 
+/** Number of license schema levels tracked by fit_info_cursor_t */
+#define FIT_INFO_MAX_DEPTH  8
+
+/**
+ * Position of a field in license data, maintained by fit core while traversing the
+ * license for fit_licenf_get_info_cursor. Each traversal has its own cursor, so
+ * several licenses can be traversed at the same time.
+ */
+typedef struct fit_info_cursor {
+    /** identifier of the value being returned */
+    uint8_t     tagid;
+    /** level/depth of the value in license schema */
+    uint8_t     level;
+    /** tagid of object or array containing fields of each level */
+    uint8_t     parent[FIT_INFO_MAX_DEPTH];
+    /** element number in array containing fields of each level (0 if not array) */
+    uint16_t    element[FIT_INFO_MAX_DEPTH];
+} fit_info_cursor_t;
+
+/** Prototype of a get_info callback function receiving position of the value.
+ *
+ * @param IN  \b  cursor        \n  position of the value being returned in pdata;
+ *                                  cursor->parent[cursor->level] is tagid of the
+ *                                  enclosing object or array.
+ *
+ * @param IN  \b  pdata         \n  pointer to returned data
+ *
+ * @param IN  \b  length        \n  length of data
+ *
+ * @param IO  \b  stop_parse    \n  set to value FIT_TRUE to stop further calling the callback fn,
+ *                                  otherwise set to value FIT_FALSE.
+ *
+ * @param IN  \b  context       \n  pointer to context parameter given in get info call
+ */
+
+typedef fit_status_t (*fit_get_info_cursor_callback)(const fit_info_cursor_t *cursor,
+                                                     fit_pointer_t *pdata,
+                                                     uint16_t length,
+                                                     fit_boolean_t *stop_parse,
+                                                     void *context);
+
 /** Prototype of a get fingerprint/deviceid data callback function.
  *
  * @param IO  \b  rawdata       \n  pointer to buffer containing the fingerprint raw data
@@ -22,6 +22,10 @@
  * Sentinel Fit version milestones - not to be changed
  */
 #define FIT_INITIAL_VERSION	100      /* FIT_MAJOR_VERSION *100 + FIT_MINOR_VERSION */
+
+/** Core version as single number, recorded in fit_verify_record_t */
+#define FIT_CORE_VERSION        (FIT_MAJOR_VERSION * 10000 + FIT_MINOR_VERSION * 100 + \
+                                 FIT_REVISION_VERSION)
 /* Types ********************************************************************/
 
 
@@ -27,14 +27,7 @@
 #include "fit_internal.h"
 #include "fit_dm_hash.h"
 #include "fit_debug.h"
-
-/* Constants ****************************************************************/
-
-#define FIT_ROUNDS_256BIT_KEY_LENGTH        240
-
-/* Global Data **************************************************************/
-
-static uint8_t fit_aes256key[FIT_AES_256_KEY_LENGTH] = {0};
+#include "fit_mem_read.h"
 
 /* Functions ****************************************************************/
 
@@ -55,70 +48,54 @@ static void fit_aes256_abreastdm_init(uint8_t *hash)
 
 /**
  *
- * fit_aes_km_load256
- *
- * This function will update the aes key (AES algorithm) used in encryption of
- * license data.
- *
- * @param IN    key     \n Pointer to aes key data that need to be updated.
- *
- */
-static void fit_aes_km_load256(uint8_t *key)
-{
-    fit_memcpy(fit_aes256key, key, FIT_AES_256_KEY_LENGTH);
-}
-
-/**
- *
- * fit_aes_ecb_encrypt
+ * fit_aes256_abreastdm_update_blk
  *
- * This function will encrypt the data passed in based on global aes key.
+ * This function will update the hash of the license data (for one block of data).
+ * Hash, message and AES-256 keys are kept in 32 bit words. Key of second encryption
+ * contains Gi computed by the first one, so the two encryptions are done one after
+ * the other. Timed on Linux host only (fit_benchmark.c "abreast-dm hash"); cycle
+ * counts on Cortex-M4 (TM4C1294) are still to be measured.
  *
- * @param IN    in  \n Pointer to data that needs to be encrypted.
+ * @param IN    indata  \n Buffer to hold data
  *
- * @param  IN   blk_num     \n Block number in case this function is called message
- *                             greater than 16 bytes.
+ * @param IO    hash    \n Hash Buffer to hold thye hash value
  *
  */
-static fit_status_t fit_aes_ecb_encrypt(uint8_t *in, uint16_t blk_num)
+static void fit_aes256_abreastdm_update_blk(const uint8_t *indata, uint8_t *hash)
 {
-    uint8_t aes_state[4][4];
-    fit_status_t status = FIT_STATUS_UNKNOWN_ERROR;
-    fit_aes_t aes;
-    uint8_t out[FIT_AES_OUTPUT_DATA_SIZE];
-    fit_pointer_t fitkey;
-    uint8_t *skey = 0;
-
-    skey = fit_calloc(1, FIT_ROUNDS_256BIT_KEY_LENGTH);
-    if (NULL == skey) {
-        status = FIT_STATUS_INSUFFICIENT_MEMORY;
-        DBG(FIT_TRACE_ERROR, "failed to initialize memory \n");
-        goto bail;
-    }
-
-    fit_memset((uint8_t *)&aes_state, 0, sizeof(aes_state));
-    fit_memset(out, 0, sizeof(out));
-
-    fit_memset((uint8_t *)&fitkey, 0, sizeof(fit_pointer_t));
-    fitkey.read_byte = (fit_read_byte_callback_t) FIT_READ_BYTE_RAM;
-    fitkey.data = (uint8_t *) fit_aes256key;
-    fitkey.length = FIT_AES_256_KEY_LENGTH;
+    uint32_t aeskey[FIT_AES_256_KEY_LENGTH / 4];
+    uint32_t hashg[4];
+    uint32_t hashh[4];
+    uint32_t tempbuf[4];
+    uint8_t  i = 0;
 
-    /* Initialize the aes context */
-    status = fit_aes_setup(&aes, &fitkey, skey);
-    if (status != FIT_STATUS_OK)
+    for (i = 0; i < 4; i++)
     {
-        DBG(FIT_TRACE_ERROR, "failed to initialize aes setup error =%d\n", status);
-        goto bail;
+        hashg[i] = FIT_AES_GETU32(hash + 4 * i);
+        hashh[i] = FIT_AES_GETU32(hash + 16 + 4 * i);
+        aeskey[i] = hashh[i];
+        aeskey[i + 4] = FIT_AES_GETU32(indata + 4 * i);
+        tempbuf[i] = hashg[i];
     }
 
-    fit_memset((uint8_t*)aes_state, 0, sizeof(aes_state));
-    fit_aes_encrypt(&aes, in, out, skey, (uint8_t*)aes_state);
-    fit_memcpy(in, out, 16);
+    /* Gi = Gi-1 XOR AES(Gi-1 || Hi-1Mi) */
+    fit_aes256_encrypt_words(aeskey, tempbuf, NULL);
+    for (i = 0; i < 4; i++)
+    {
+        hashg[i] ^= tempbuf[i];
+        aeskey[i] = aeskey[i + 4];
+        aeskey[i + 4] = hashg[i];
+        tempbuf[i] = ~hashh[i];
+    }
 
-bail:
-    if (skey) fit_free(skey);
-    return status;
+    /* Hi = Hi-1 XOR AES(~ Hi-1 || Mi Gi) */
+    fit_aes256_encrypt_words(aeskey, tempbuf, NULL);
+    for (i = 0; i < 4; i++)
+    {
+        hashh[i] ^= tempbuf[i];
+        FIT_AES_PUTU32(hash + 4 * i, hashg[i]);
+        FIT_AES_PUTU32(hash + 16 + 4 * i, hashh[i]);
+    }
 }
 
 /**
@@ -136,43 +113,11 @@ bail:
  */
 void fit_aes256_abreastdm_update(uint8_t *indata, uint16_t numofblks, uint8_t *hash)
 {
-    uint8_t  tempbuf[FIT_AES_OUTPUT_DATA_SIZE];
     uint8_t *msg = indata;
-    uint8_t *hashg = hash;
-    uint8_t *hashh = hash + 16;
-    uint8_t  i = 0;
 
-    fit_memset(fit_aes256key, 0, sizeof(fit_aes256key));
-    fit_memset(tempbuf, 0, sizeof(tempbuf));
     while(numofblks--)
     {
-        /* Gi = Gi-1 XOR AES(Gi-1 || Hi-1Mi) */
-        fit_memcpy(fit_aes256key, hashh, FIT_AES_256_KEY_LENGTH/2); 
-        fit_memcpy(fit_aes256key+FIT_AES_256_KEY_LENGTH/2, msg,
-            FIT_AES_256_KEY_LENGTH/2);
-
-        fit_memcpy(tempbuf, hashg, 16);
-        fit_aes_ecb_encrypt(tempbuf, 1);
-        for(i=0;i<16;i++)
-        {
-            hashg[i] ^= tempbuf[i];
-        }
-
-        /* Hi = Hi-1 XOR AES(~ Hi-1 || Mi Gi-1) */
-        fit_memcpy(fit_aes256key, msg, FIT_AES_256_KEY_LENGTH/2); 
-        fit_memcpy(fit_aes256key+FIT_AES_256_KEY_LENGTH/2, hashg,
-            FIT_AES_256_KEY_LENGTH/2);
-
-        fit_memcpy(tempbuf, hashh, 16); 
-        for(i=0; i<16; i++)
-        {
-            tempbuf[i] ^= 0xFF;
-        }
-        fit_aes_ecb_encrypt(tempbuf, 1);
-        for(i=0;i<16;i++)
-        {
-            hashh[i] ^= tempbuf[i];
-        }
+        fit_aes256_abreastdm_update_blk(msg, hash);
 
         /* Next block */
         msg  += 16;
@@ -181,84 +126,149 @@ void fit_aes256_abreastdm_update(uint8_t *indata, uint16_t numofblks, uint8_t *h
 
 /**
  *
- * fit_aes256_abreastdm_update_blk
- *
- * This function will update the hash of the license data (for one block of data)
+ * fit_aes256_abreastdm_finalize
  *
- * @param IN    indata  \n Buffer to hold data
+ * This function will perform final update on hash of the license data. Both
+ * halves of hash are encrypted with same key (hash value before this update), so
+ * they are encrypted as two lanes sharing one on the fly key expansion.
  *
- * @param IO    hash    \n Hash Buffer to hold thye hash value
+ * @param IO    hash    \n Hash Buffer to hold the hash value
  *
  */
-static void fit_aes256_abreastdm_update_blk(uint8_t *indata, uint8_t *hash)
+static fit_status_t fit_aes256_abreastdm_finalize(uint8_t *hash)
 {
-    uint8_t  tempbuf[FIT_AES_OUTPUT_DATA_SIZE];
-    uint8_t *msg = indata;
-    uint8_t *hashg = hash;
-    uint8_t *hashh = hash + 16;
-    uint8_t  i = 0;
+    uint8_t i;
+    uint32_t aeskey[FIT_AES_256_KEY_LENGTH / 4];
+    uint32_t hashg[4];
+    uint32_t hashh[4];
 
-    fit_memset(tempbuf, 0, sizeof(tempbuf));
-    /* Gi = Gi-1 XOR AES(Gi-1 || Hi-1Mi) */
-    fit_memcpy(fit_aes256key, hashh, FIT_AES_256_KEY_LENGTH/2); 
-    fit_memcpy(fit_aes256key+FIT_AES_256_KEY_LENGTH/2, msg,
-        FIT_AES_256_KEY_LENGTH/2); 
+    for (i = 0; i < 4; i++)
+    {
+        aeskey[i] = hashg[i] = FIT_AES_GETU32(hash + 4 * i);
+        aeskey[i + 4] = hashh[i] = FIT_AES_GETU32(hash + 16 + 4 * i);
+    }
 
-    fit_memcpy(tempbuf, hashg, 16);
-    fit_aes_ecb_encrypt(tempbuf, 1);
-    for(i=0;i<16;i++)
+    /* hash[0-15] and hash[16-32] */
+    fit_aes256_encrypt_words(aeskey, hashg, hashh);
+    for (i = 0; i < 4; i++)
     {
-        hashg[i] ^= tempbuf[i];
+        FIT_AES_PUTU32(hash + 4 * i, aeskey[i] ^ hashg[i]);
+        FIT_AES_PUTU32(hash + 16 + 4 * i, aeskey[i + 4] ^ hashh[i]);
     }
 
-    /* Hi = Hi-1 XOR AES(~ Hi-1 || Mi Gi-1) */
-    fit_memcpy(fit_aes256key, msg, FIT_AES_256_KEY_LENGTH/2); 
-    fit_memcpy(fit_aes256key+FIT_AES_256_KEY_LENGTH/2, hashg,
-        FIT_AES_256_KEY_LENGTH/2); 
+    return FIT_STATUS_OK;
+}
 
-    fit_memcpy(tempbuf, hashh, 16); 
-    for(i=0; i<16; i++)
+/**
+ *
+ * fit_abreastdm_init
+ *
+ * This function initializes context for incremental abreast dm hash calculation.
+ * Data is then passed by one or more fit_abreastdm_update calls, and the hash is
+ * returned by fit_abreastdm_final. No memory is allocated.
+ *
+ * @param OUT   ctx     \n Pointer to abreast dm hash context.
+ *
+ */
+void fit_abreastdm_init(fit_abreastdm_ctx_t *ctx)
+{
+    fit_aes256_abreastdm_init(ctx->hash);
+    fit_memset(ctx->buf, 0, sizeof(ctx->buf));
+    ctx->buflen = 0;
+    ctx->msglen = 0;
+}
+
+/**
+ *
+ * fit_abreastdm_update
+ *
+ * This function adds data to abreast dm hash calculation. Data can be passed in
+ * chunks of any size; complete message blocks are hashed immediately, remaining
+ * bytes are kept in context.
+ *
+ * @param IO    ctx     \n Pointer to abreast dm hash context.
+ *
+ * @param IN    data    \n Pointer to data (in RAM) to be hashed.
+ *
+ * @param IN    len     \n Length of data.
+ *
+ */
+void fit_abreastdm_update(fit_abreastdm_ctx_t *ctx, const uint8_t *data, uint16_t len)
+{
+    uint16_t cnt = 0;
+
+    ctx->msglen += len;
+
+    /* Complete message block kept from previous call */
+    if (ctx->buflen != 0)
     {
-        tempbuf[i] ^= 0xFF;
+        cnt = FIT_ABREAST_DM_BLOCK_SIZE - ctx->buflen;
+        if (cnt > len)
+        {
+            cnt = len;
+        }
+        fit_memcpy(ctx->buf + ctx->buflen, (uint8_t *)data, cnt);
+        ctx->buflen += (uint8_t)cnt;
+        data += cnt;
+        len -= cnt;
+
+        if (ctx->buflen < FIT_ABREAST_DM_BLOCK_SIZE)
+        {
+            return;
+        }
+        fit_aes256_abreastdm_update_blk(ctx->buf, ctx->hash);
+        ctx->buflen = 0;
     }
-    fit_aes_ecb_encrypt(tempbuf, 1);
-    for(i=0;i<16;i++)
+
+    /* Hash complete message blocks directly from data */
+    while (len >= FIT_ABREAST_DM_BLOCK_SIZE)
     {
-        hashh[i] ^= tempbuf[i];
+        fit_aes256_abreastdm_update_blk(data, ctx->hash);
+        data += FIT_ABREAST_DM_BLOCK_SIZE;
+        len -= FIT_ABREAST_DM_BLOCK_SIZE;
+    }
+
+    if (len != 0)
+    {
+        fit_memcpy(ctx->buf, (uint8_t *)data, len);
+        ctx->buflen = (uint8_t)len;
     }
 }
 
 /**
  *
- * fit_aes256_abreastdm_finalize
+ * fit_abreastdm_final
  *
- * This function will perform final update on hash of the license data
+ * This function pads the data kept in context, hashes it and performs final
+ * update on hash.
  *
- * @param IO    hash    \n Hash Buffer to hold the hash value
+ * @param IO    ctx     \n Pointer to abreast dm hash context.
+ *
+ * @param OUT   hash    \n On return this will contain the abreast dm hash of data
+ *                         passed to fit_abreastdm_update.
  *
  */
-static void fit_aes256_abreastdm_finalize(uint8_t *hash)
+fit_status_t fit_abreastdm_final(fit_abreastdm_ctx_t *ctx, uint8_t *hash)
 {
-    uint8_t i;
-    uint8_t tempbuf[FIT_AES_OUTPUT_DATA_SIZE];
+    uint8_t tempmsg[32];
+    uint16_t msglen = ctx->buflen;
+    uint16_t cntr = 0;
+    fit_status_t status = FIT_STATUS_OK;
 
-    fit_aes_km_load256(hash);
-    /* hash[0-15] */
-    fit_memcpy(tempbuf, hash, 16);
-    fit_aes_ecb_encrypt(tempbuf, 1);
-    for(i =0; i< 16; i++)
-    {
-        hash[i] ^= tempbuf[i];
-    }
-    /* hash[16-32] */
-    fit_memcpy(tempbuf, hash+16, 16);
-    fit_aes_ecb_encrypt(tempbuf, 1);
-    for(i =0; i< 16; i++)
+    fit_memset(tempmsg, 0, sizeof(tempmsg));
+    fit_memcpy(tempmsg, ctx->buf, ctx->buflen);
+
+    /* Do padding for the last block of data (length is encoded on 16 bits).*/
+    fit_dm_hash_pad(tempmsg, &msglen, (uint16_t)ctx->msglen);
+    for (cntr = 0; cntr < msglen; cntr += FIT_ABREAST_DM_BLOCK_SIZE)
     {
-        hash[i+16] ^= tempbuf[i];
+        fit_aes256_abreastdm_update_blk(tempmsg+cntr, ctx->hash);
     }
 
-   return;
+    status = fit_aes256_abreastdm_finalize(ctx->hash);
+    fit_memcpy(hash, ctx->hash, FIT_ABREAST_DM_HASH_SIZE);
+
+    return status;
 }
 
 /**
@@ -275,44 +285,23 @@ static void fit_aes256_abreastdm_finalize(uint8_t *hash)
  */
 fit_status_t fit_get_abreastdm_hash(fit_pointer_t *msg, uint8_t *hash)
 {
-    uint16_t cntr           = 0;
-    uint8_t tempmsg[32];
-    uint16_t msglen         = 0;
-    fit_pointer_t fitptr;
+    fit_abreastdm_ctx_t ctx;
+    uint8_t tempmsg[FIT_ABREAST_DM_BLOCK_SIZE];
+    uint16_t cntr   = 0;
+    uint16_t len    = 0;
 
-    fit_memset((uint8_t *)&fitptr, 0, sizeof(fit_pointer_t));
-    /* Initialize the read pointer.*/
-    fitptr.read_byte = msg->read_byte;
-
-    /* Initialize hash value;*/
-    fit_aes256_abreastdm_init(hash);
-
-    fit_memset(tempmsg, 0, sizeof(tempmsg));
+    fit_abreastdm_init(&ctx);
     /* Break data in blocks (16 bytes each) and hash the data.*/
-    for (cntr = 0; cntr < msg->length; cntr+=16)
+    for (cntr = 0; cntr < msg->length; cntr += len)
     {
-        if ((cntr+16) < msg->length) 
+        len = msg->length - cntr;
+        if (len > FIT_ABREAST_DM_BLOCK_SIZE)
         {
-            fitptr.data = msg->data+cntr;
-            fitptr.length = 16;
-            fitptr_memcpy(tempmsg, &fitptr);
-            fit_aes256_abreastdm_update_blk(tempmsg, hash);
+            len = FIT_ABREAST_DM_BLOCK_SIZE;
         }
+        fitptr_read_block(tempmsg, msg->data + cntr, len, msg);
+        fit_abreastdm_update(&ctx, tempmsg, len);
     }
-    cntr -= 16;
 
-    fitptr.data = msg->data+cntr;
-    fitptr.length = msg->length-cntr;
-    msglen = fitptr.length;
-    fitptr_memcpy(tempmsg, &fitptr);
-
-    fit_dm_hash_init(tempmsg, &msglen, msg->length);
-    for (cntr = 0; cntr < msglen; cntr+=16)
-    {
-        fit_aes256_abreastdm_update_blk(tempmsg+cntr, hash);
-    }
-
-    fit_aes256_abreastdm_finalize(hash);
-
-    return FIT_STATUS_OK;
+    return fit_abreastdm_final(&ctx, hash);
 }
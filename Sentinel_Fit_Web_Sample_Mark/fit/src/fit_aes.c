@@ -16,6 +16,7 @@
 
 #include "fit_aes.h"
 #include "fit_debug.h"
+#include "fit_mem_read.h"
 
 /* Global Data **************************************************************/
 static const uint8_t sbox_P[256] PROGMEM = {
@@ -54,6 +55,57 @@ static const uint8_t Rcon_P[255] PROGMEM = {
     0xc6, 0x97, 0x35, 0x6a, 0xd4, 0xb3, 0x7d, 0xfa, 0xef, 0xc5, 0x91, 0x39, 0x72, 0xe4, 0xd3, 0xbd, 
     0x61, 0xc2, 0x9f, 0x25, 0x4a, 0x94, 0x33, 0x66, 0xcc, 0x83, 0x1d, 0x3a, 0x74, 0xe8, 0xcb  };
 
+#ifdef FIT_USE_AES_TTABLE
+/*
+ * Combined SubBytes/MixColumns table. Entry x is column {02,01,01,03}*sbox[x] with
+ * row 0 in most significant byte. Tables for other rows are byte rotations of it.
+ */
+static const uint32_t Te0_P[256] PROGMEM = {
+    0xc66363a5, 0xf87c7c84, 0xee777799, 0xf67b7b8d, 0xfff2f20d, 0xd66b6bbd,
+    0xde6f6fb1, 0x91c5c554, 0x60303050, 0x02010103, 0xce6767a9, 0x562b2b7d,
+    0xe7fefe19, 0xb5d7d762, 0x4dababe6, 0xec76769a, 0x8fcaca45, 0x1f82829d,
+    0x89c9c940, 0xfa7d7d87, 0xeffafa15, 0xb25959eb, 0x8e4747c9, 0xfbf0f00b,
+    0x41adadec, 0xb3d4d467, 0x5fa2a2fd, 0x45afafea, 0x239c9cbf, 0x53a4a4f7,
+    0xe4727296, 0x9bc0c05b, 0x75b7b7c2, 0xe1fdfd1c, 0x3d9393ae, 0x4c26266a,
+    0x6c36365a, 0x7e3f3f41, 0xf5f7f702, 0x83cccc4f, 0x6834345c, 0x51a5a5f4,
+    0xd1e5e534, 0xf9f1f108, 0xe2717193, 0xabd8d873, 0x62313153, 0x2a15153f,
+    0x0804040c, 0x95c7c752, 0x46232365, 0x9dc3c35e, 0x30181828, 0x379696a1,
+    0x0a05050f, 0x2f9a9ab5, 0x0e070709, 0x24121236, 0x1b80809b, 0xdfe2e23d,
+    0xcdebeb26, 0x4e272769, 0x7fb2b2cd, 0xea75759f, 0x1209091b, 0x1d83839e,
+    0x582c2c74, 0x341a1a2e, 0x361b1b2d, 0xdc6e6eb2, 0xb45a5aee, 0x5ba0a0fb,
+    0xa45252f6, 0x763b3b4d, 0xb7d6d661, 0x7db3b3ce, 0x5229297b, 0xdde3e33e,
+    0x5e2f2f71, 0x13848497, 0xa65353f5, 0xb9d1d168, 0x00000000, 0xc1eded2c,
+    0x40202060, 0xe3fcfc1f, 0x79b1b1c8, 0xb65b5bed, 0xd46a6abe, 0x8dcbcb46,
+    0x67bebed9, 0x7239394b, 0x944a4ade, 0x984c4cd4, 0xb05858e8, 0x85cfcf4a,
+    0xbbd0d06b, 0xc5efef2a, 0x4faaaae5, 0xedfbfb16, 0x864343c5, 0x9a4d4dd7,
+    0x66333355, 0x11858594, 0x8a4545cf, 0xe9f9f910, 0x04020206, 0xfe7f7f81,
+    0xa05050f0, 0x783c3c44, 0x259f9fba, 0x4ba8a8e3, 0xa25151f3, 0x5da3a3fe,
+    0x804040c0, 0x058f8f8a, 0x3f9292ad, 0x219d9dbc, 0x70383848, 0xf1f5f504,
+    0x63bcbcdf, 0x77b6b6c1, 0xafdada75, 0x42212163, 0x20101030, 0xe5ffff1a,
+    0xfdf3f30e, 0xbfd2d26d, 0x81cdcd4c, 0x180c0c14, 0x26131335, 0xc3ecec2f,
+    0xbe5f5fe1, 0x359797a2, 0x884444cc, 0x2e171739, 0x93c4c457, 0x55a7a7f2,
+    0xfc7e7e82, 0x7a3d3d47, 0xc86464ac, 0xba5d5de7, 0x3219192b, 0xe6737395,
+    0xc06060a0, 0x19818198, 0x9e4f4fd1, 0xa3dcdc7f, 0x44222266, 0x542a2a7e,
+    0x3b9090ab, 0x0b888883, 0x8c4646ca, 0xc7eeee29, 0x6bb8b8d3, 0x2814143c,
+    0xa7dede79, 0xbc5e5ee2, 0x160b0b1d, 0xaddbdb76, 0xdbe0e03b, 0x64323256,
+    0x743a3a4e, 0x140a0a1e, 0x924949db, 0x0c06060a, 0x4824246c, 0xb85c5ce4,
+    0x9fc2c25d, 0xbdd3d36e, 0x43acacef, 0xc46262a6, 0x399191a8, 0x319595a4,
+    0xd3e4e437, 0xf279798b, 0xd5e7e732, 0x8bc8c843, 0x6e373759, 0xda6d6db7,
+    0x018d8d8c, 0xb1d5d564, 0x9c4e4ed2, 0x49a9a9e0, 0xd86c6cb4, 0xac5656fa,
+    0xf3f4f407, 0xcfeaea25, 0xca6565af, 0xf47a7a8e, 0x47aeaee9, 0x10080818,
+    0x6fbabad5, 0xf0787888, 0x4a25256f, 0x5c2e2e72, 0x381c1c24, 0x57a6a6f1,
+    0x73b4b4c7, 0x97c6c651, 0xcbe8e823, 0xa1dddd7c, 0xe874749c, 0x3e1f1f21,
+    0x964b4bdd, 0x61bdbddc, 0x0d8b8b86, 0x0f8a8a85, 0xe0707090, 0x7c3e3e42,
+    0x71b5b5c4, 0xcc6666aa, 0x904848d8, 0x06030305, 0xf7f6f601, 0x1c0e0e12,
+    0xc26161a3, 0x6a35355f, 0xae5757f9, 0x69b9b9d0, 0x17868691, 0x99c1c158,
+    0x3a1d1d27, 0x279e9eb9, 0xd9e1e138, 0xebf8f813, 0x2b9898b3, 0x22111133,
+    0xd26969bb, 0xa9d9d970, 0x078e8e89, 0x339494a7, 0x2d9b9bb6, 0x3c1e1e22,
+    0x15878792, 0xc9e9e920, 0x87cece49, 0xaa5555ff, 0x50282878, 0xa5dfdf7a,
+    0x038c8c8f, 0x59a1a1f8, 0x09898980, 0x1a0d0d17, 0x65bfbfda, 0xd7e6e631,
+    0x844242c6, 0xd06868b8, 0x824141c3, 0x299999b0, 0x5a2d2d77, 0x1e0f0f11,
+    0x7bb0b0cb, 0xa85454fc, 0x6dbbbbd6, 0x2c16163a };
+#endif /* #ifdef FIT_USE_AES_TTABLE */
+
 /* Function definitions ******************************************************/
 
 #ifdef __AVR__
@@ -126,13 +178,8 @@ fit_status_t fit_aes_setup(fit_aes_t *aes,
     }
 
     /* The first round key is the key itself.*/
-    for(i = 0; i < aes->Nk; ++i)
-    {
-        skey[(i * 4) + 0] = key->read_byte(key->data + ((i * 4) + 0));
-        skey[(i * 4) + 1] = key->read_byte(key->data + ((i * 4) + 1));
-        skey[(i * 4) + 2] = key->read_byte(key->data + ((i * 4) + 2));
-        skey[(i * 4) + 3] = key->read_byte(key->data + ((i * 4) + 3));
-    }
+    fitptr_read_block(skey, key->data, aes->keylen, key);
+    i = aes->Nk;
 
     /* All other round keys are found from the previous round keys.*/
     for(; (i < (FIT_AES_NB * (aes->Nr + 1))); ++i)
@@ -295,6 +342,125 @@ void fit_mix_columns(uint8_t *state)
     }
 }
 
+#ifdef FIT_USE_AES_TTABLE
+
+/** Rotate 32 bit word right by given number of bits */
+#define FIT_AES_ROTR(x, n)      (((x) >> (n)) | ((x) << (32 - (n))))
+
+/**
+ * One (full) round on state columns s0..s3: SubBytes, ShiftRows and MixColumns via
+ * T-table lookups followed by AddRoundKey (k is round key column as word).
+ */
+#define FIT_AES_TROUND(d, a, b, c, e, k)                        \
+    (d) = Te0_P[(a) >> 24] ^                                    \
+          FIT_AES_ROTR(Te0_P[((b) >> 16) & 0xFF], 8) ^          \
+          FIT_AES_ROTR(Te0_P[((c) >> 8) & 0xFF], 16) ^          \
+          FIT_AES_ROTR(Te0_P[(e) & 0xFF], 24) ^                 \
+          (k)
+
+/** Last round (no MixColumns) for one output column.*/
+#define FIT_AES_FROUND(d, a, b, c, e, k)                        \
+    (d) = ((uint32_t)get_sbox_value((uint8_t)((a) >> 24)) << 24) ^  \
+          ((uint32_t)get_sbox_value((uint8_t)((b) >> 16)) << 16) ^  \
+          ((uint32_t)get_sbox_value((uint8_t)((c) >> 8)) << 8) ^    \
+          ((uint32_t)get_sbox_value((uint8_t)(e))) ^                \
+          (k)
+
+/** Full round on all four columns of state kept in words s0..s3 (t0..t3 are temporaries).*/
+#define FIT_AES_TROUND4(s0, s1, s2, s3, k)                      \
+    {                                                           \
+        FIT_AES_TROUND(t0, s0, s1, s2, s3, (k)[0]);             \
+        FIT_AES_TROUND(t1, s1, s2, s3, s0, (k)[1]);             \
+        FIT_AES_TROUND(t2, s2, s3, s0, s1, (k)[2]);             \
+        FIT_AES_TROUND(t3, s3, s0, s1, s2, (k)[3]);             \
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;                     \
+    }
+
+/** Last round on all four columns of state, result is stored to out[0..3].*/
+#define FIT_AES_FROUND4(out, s0, s1, s2, s3, k)                 \
+    {                                                           \
+        FIT_AES_FROUND((out)[0], s0, s1, s2, s3, (k)[0]);       \
+        FIT_AES_FROUND((out)[1], s1, s2, s3, s0, (k)[1]);       \
+        FIT_AES_FROUND((out)[2], s2, s3, s0, s1, (k)[2]);       \
+        FIT_AES_FROUND((out)[3], s3, s0, s1, s2, (k)[3]);       \
+    }
+
+/*
+ * Cipher is the main function that encrypts the PlainText. Word (T-table) variant:
+ * each state column is kept in 32 bit word, round keys are in same byte layout as
+ * produced by fit_aes_setup.
+ */
+static void encrypt(fit_aes_t *aes, const uint8_t *skey, uint8_t *state)
+{
+    uint32_t s0, s1, s2, s3;
+    uint32_t t0, t1, t2, t3;
+    const uint8_t *rk = skey;
+    uint16_t round = 0;
+
+    /* Add the First round key to the state before starting the rounds.*/
+    s0 = FIT_AES_GETU32(state     ) ^ FIT_AES_GETU32(rk     );
+    s1 = FIT_AES_GETU32(state +  4) ^ FIT_AES_GETU32(rk +  4);
+    s2 = FIT_AES_GETU32(state +  8) ^ FIT_AES_GETU32(rk +  8);
+    s3 = FIT_AES_GETU32(state + 12) ^ FIT_AES_GETU32(rk + 12);
+
+    /* The first Nr-1 rounds are identical.*/
+    for (round = 1; round < aes->Nr; ++round)
+    {
+        rk += FIT_AES_NB * 4;
+        FIT_AES_TROUND(t0, s0, s1, s2, s3, FIT_AES_GETU32(rk));
+        FIT_AES_TROUND(t1, s1, s2, s3, s0, FIT_AES_GETU32(rk + 4));
+        FIT_AES_TROUND(t2, s2, s3, s0, s1, FIT_AES_GETU32(rk + 8));
+        FIT_AES_TROUND(t3, s3, s0, s1, s2, FIT_AES_GETU32(rk + 12));
+        s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+    }
+
+    /* The last round is without MixColumns.*/
+    rk += FIT_AES_NB * 4;
+    FIT_AES_FROUND(t0, s0, s1, s2, s3, FIT_AES_GETU32(rk));
+    FIT_AES_FROUND(t1, s1, s2, s3, s0, FIT_AES_GETU32(rk + 4));
+    FIT_AES_FROUND(t2, s2, s3, s0, s1, FIT_AES_GETU32(rk + 8));
+    FIT_AES_FROUND(t3, s3, s0, s1, s2, FIT_AES_GETU32(rk + 12));
+
+    FIT_AES_PUTU32(state     , t0);
+    FIT_AES_PUTU32(state +  4, t1);
+    FIT_AES_PUTU32(state +  8, t2);
+    FIT_AES_PUTU32(state + 12, t3);
+}
+
+/* Performs one round (last round if lastround is FIT_TRUE) on state with round key rk.*/
+static void encrypt_round(uint8_t *state, const uint8_t *rk, fit_boolean_t lastround)
+{
+    uint32_t s0, s1, s2, s3;
+    uint32_t t0, t1, t2, t3;
+
+    s0 = FIT_AES_GETU32(state     );
+    s1 = FIT_AES_GETU32(state +  4);
+    s2 = FIT_AES_GETU32(state +  8);
+    s3 = FIT_AES_GETU32(state + 12);
+
+    if (lastround)
+    {
+        FIT_AES_FROUND(t0, s0, s1, s2, s3, FIT_AES_GETU32(rk));
+        FIT_AES_FROUND(t1, s1, s2, s3, s0, FIT_AES_GETU32(rk + 4));
+        FIT_AES_FROUND(t2, s2, s3, s0, s1, FIT_AES_GETU32(rk + 8));
+        FIT_AES_FROUND(t3, s3, s0, s1, s2, FIT_AES_GETU32(rk + 12));
+    }
+    else
+    {
+        FIT_AES_TROUND(t0, s0, s1, s2, s3, FIT_AES_GETU32(rk));
+        FIT_AES_TROUND(t1, s1, s2, s3, s0, FIT_AES_GETU32(rk + 4));
+        FIT_AES_TROUND(t2, s2, s3, s0, s1, FIT_AES_GETU32(rk + 8));
+        FIT_AES_TROUND(t3, s3, s0, s1, s2, FIT_AES_GETU32(rk + 12));
+    }
+
+    FIT_AES_PUTU32(state     , t0);
+    FIT_AES_PUTU32(state +  4, t1);
+    FIT_AES_PUTU32(state +  8, t2);
+    FIT_AES_PUTU32(state + 12, t3);
+}
+
+#else /* #ifdef FIT_USE_AES_TTABLE */
+
 /* Cipher is the main function that encrypts the PlainText.*/
 static void encrypt(fit_aes_t *aes, const uint8_t *skey, uint8_t *state)
 {
@@ -325,6 +491,314 @@ static void encrypt(fit_aes_t *aes, const uint8_t *skey, uint8_t *state)
     add_round_key(state, skey, aes->Nr);
 }
 
+/* Performs one round (last round if lastround is FIT_TRUE) on state with round key rk.*/
+static void encrypt_round(uint8_t *state, const uint8_t *rk, fit_boolean_t lastround)
+{
+    sub_bytes(state);
+    fit_shift_rows(state);
+    if (!lastround)
+    {
+        fit_mix_columns(state);
+    }
+    add_round_key(state, rk, 0);
+}
+
+#endif /* #ifdef FIT_USE_AES_TTABLE */
+
+/**
+ *
+ * fit_aes128_next_key
+ *
+ * Computes next round key of AES-128 key schedule in place.
+ *
+ * @param IO    rk      \n Round key (16 bytes).
+ *
+ * @param IN    rcon    \n Round constant for this expansion step.
+ *
+ */
+static void fit_aes128_next_key(uint8_t *rk, uint8_t rcon)
+{
+    uint8_t i = 0;
+
+    /* w[i] = w[i-4] ^ SubWord(RotWord(w[i-1])) ^ Rcon */
+    rk[0] ^= get_sbox_value(rk[13]) ^ rcon;
+    rk[1] ^= get_sbox_value(rk[14]);
+    rk[2] ^= get_sbox_value(rk[15]);
+    rk[3] ^= get_sbox_value(rk[12]);
+    for (i = 4; i < 16; ++i)
+    {
+        rk[i] ^= rk[i - 4];
+    }
+}
+
+/**
+ *
+ * fit_aes256_next_key
+ *
+ * Computes next 8 words of AES-256 key schedule in place, i.e. on return rk
+ * contains round keys 2n and 2n+1 if it contained round keys 2n-2 and 2n-1.
+ *
+ * @param IO    rk      \n Two consecutive round keys (32 bytes).
+ *
+ * @param IN    rcon    \n Round constant for this expansion step.
+ *
+ */
+static void fit_aes256_next_key(uint8_t *rk, uint8_t rcon)
+{
+    uint8_t i = 0;
+
+    /* w[i] = w[i-8] ^ SubWord(RotWord(w[i-1])) ^ Rcon */
+    rk[0] ^= get_sbox_value(rk[29]) ^ rcon;
+    rk[1] ^= get_sbox_value(rk[30]);
+    rk[2] ^= get_sbox_value(rk[31]);
+    rk[3] ^= get_sbox_value(rk[28]);
+    for (i = 4; i < 16; ++i)
+    {
+        rk[i] ^= rk[i - 4];
+    }
+
+    /* w[i+4] = w[i-4] ^ SubWord(w[i+3]) */
+    for (i = 16; i < 20; ++i)
+    {
+        rk[i] ^= get_sbox_value(rk[i - 4]);
+    }
+    for (i = 20; i < 32; ++i)
+    {
+        rk[i] ^= rk[i - 4];
+    }
+}
+
+/**
+ *
+ * fit_aes128_expand_encrypt
+ *
+ * Encrypts one block with AES-128, expanding key on the fly. Only current round
+ * key (16 bytes) is kept, so no round key buffer is needed. Useful when key changes
+ * for every block (e.g. in Davies Meyer hash).
+ *
+ * @param IN    key     \n AES-128 key (16 bytes, in RAM).
+ *
+ * @param IO    block   \n Data to be encrypted (16 bytes). On return contains
+ *                         encrypted data.
+ *
+ */
+void fit_aes128_expand_encrypt(const uint8_t *key, uint8_t *block)
+{
+    uint8_t rk[FIT_AES_128_KEY_LENGTH];
+    uint8_t round = 0;
+
+    for (round = 0; round < FIT_AES_128_KEY_LENGTH; ++round)
+    {
+        rk[round] = key[round];
+    }
+
+    add_round_key(block, rk, 0);
+    for (round = 1; round <= 10; ++round)
+    {
+        fit_aes128_next_key(rk, get_Rcon_value(round));
+        encrypt_round(block, rk, (round == 10) ? FIT_TRUE : FIT_FALSE);
+    }
+}
+
+/**
+ *
+ * fit_aes256_expand_encrypt
+ *
+ * Encrypts one block with AES-256, expanding key on the fly. Only two round keys
+ * (32 bytes) are kept at a time, so no round key buffer is needed. Useful when
+ * key changes for every block (e.g. in Abreast DM hash).
+ *
+ * @param IN    key     \n AES-256 key (32 bytes, in RAM).
+ *
+ * @param IO    block   \n Data to be encrypted (16 bytes). On return contains
+ *                         encrypted data.
+ *
+ */
+void fit_aes256_expand_encrypt(const uint8_t *key, uint8_t *block)
+{
+    uint8_t rk[FIT_AES_256_KEY_LENGTH];
+    uint8_t round = 0;
+
+    for (round = 0; round < FIT_AES_256_KEY_LENGTH; ++round)
+    {
+        rk[round] = key[round];
+    }
+
+    add_round_key(block, rk, 0);
+    for (round = 1; round < 14; ++round)
+    {
+        /* Even rounds use first round key of new expansion step.*/
+        if ((round & 1) == 0)
+        {
+            fit_aes256_next_key(rk, get_Rcon_value(round >> 1));
+        }
+        encrypt_round(block, rk + (round & 1) * FIT_AES_OUTPUT_DATA_SIZE, FIT_FALSE);
+    }
+    fit_aes256_next_key(rk, get_Rcon_value(7));
+    encrypt_round(block, rk, FIT_TRUE);
+}
+
+#ifdef FIT_USE_AES_TTABLE
+
+/**
+ *
+ * fit_aes256_next_key_words
+ *
+ * Word variant of fit_aes256_next_key: computes next 8 words of AES-256 key
+ * schedule in place (round key columns as big endian words).
+ *
+ * @param IO    k       \n Two consecutive round keys (8 words).
+ *
+ * @param IN    rcon    \n Round constant for this expansion step.
+ *
+ */
+static void fit_aes256_next_key_words(uint32_t *k, uint8_t rcon)
+{
+    uint32_t t = k[7];
+
+    /* w[i] = w[i-8] ^ SubWord(RotWord(w[i-1])) ^ Rcon */
+    k[0] ^= ((uint32_t)(get_sbox_value((uint8_t)(t >> 16)) ^ rcon) << 24) ^
+            ((uint32_t)get_sbox_value((uint8_t)(t >> 8)) << 16) ^
+            ((uint32_t)get_sbox_value((uint8_t)t) << 8) ^
+            ((uint32_t)get_sbox_value((uint8_t)(t >> 24)));
+    k[1] ^= k[0];
+    k[2] ^= k[1];
+    k[3] ^= k[2];
+
+    /* w[i+4] = w[i-4] ^ SubWord(w[i+3]) */
+    t = k[3];
+    k[4] ^= ((uint32_t)get_sbox_value((uint8_t)(t >> 24)) << 24) ^
+            ((uint32_t)get_sbox_value((uint8_t)(t >> 16)) << 16) ^
+            ((uint32_t)get_sbox_value((uint8_t)(t >> 8)) << 8) ^
+            ((uint32_t)get_sbox_value((uint8_t)t));
+    k[5] ^= k[4];
+    k[6] ^= k[5];
+    k[7] ^= k[6];
+}
+
+/**
+ *
+ * fit_aes256_encrypt_words
+ *
+ * Encrypts one or two blocks with the same AES-256 key, expanding key on the fly.
+ * State and round keys are kept in 32 bit words (big endian columns, see
+ * FIT_AES_GETU32), so no byte packing is done between rounds. With two blocks
+ * (lanes) each round key is computed once and rounds of both lanes are done
+ * alternately.
+ *
+ * @param IN    key     \n AES-256 key (8 words).
+ *
+ * @param IO    lane0   \n Data to be encrypted (4 words). On return contains
+ *                         encrypted data.
+ *
+ * @param IO    lane1   \n Second block encrypted with the same key (4 words); NULL
+ *                         if only one block is to be encrypted.
+ *
+ */
+void fit_aes256_encrypt_words(const uint32_t *key, uint32_t *lane0, uint32_t *lane1)
+{
+    uint32_t k[FIT_AES_256_KEY_LENGTH / 4];
+    uint32_t a0, a1, a2, a3;
+    uint32_t b0 = 0, b1 = 0, b2 = 0, b3 = 0;
+    uint32_t t0, t1, t2, t3;
+    uint8_t step = 0;
+
+    for (step = 0; step < FIT_AES_256_KEY_LENGTH / 4; ++step)
+    {
+        k[step] = key[step];
+    }
+
+    /* Add the First round key to the state before starting the rounds.*/
+    a0 = lane0[0] ^ k[0];
+    a1 = lane0[1] ^ k[1];
+    a2 = lane0[2] ^ k[2];
+    a3 = lane0[3] ^ k[3];
+    if (lane1 != NULL)
+    {
+        b0 = lane1[0] ^ k[0];
+        b1 = lane1[1] ^ k[1];
+        b2 = lane1[2] ^ k[2];
+        b3 = lane1[3] ^ k[3];
+    }
+
+    /* Each expansion step gives round keys for one odd and one even round.*/
+    for (step = 1; ; ++step)
+    {
+        FIT_AES_TROUND4(a0, a1, a2, a3, k + 4);
+        if (lane1 != NULL)
+        {
+            FIT_AES_TROUND4(b0, b1, b2, b3, k + 4);
+        }
+
+        fit_aes256_next_key_words(k, get_Rcon_value(step));
+        if (step == 7)
+        {
+            break;
+        }
+
+        FIT_AES_TROUND4(a0, a1, a2, a3, k);
+        if (lane1 != NULL)
+        {
+            FIT_AES_TROUND4(b0, b1, b2, b3, k);
+        }
+    }
+
+    /* The last round is without MixColumns.*/
+    FIT_AES_FROUND4(lane0, a0, a1, a2, a3, k);
+    if (lane1 != NULL)
+    {
+        FIT_AES_FROUND4(lane1, b0, b1, b2, b3, k);
+    }
+}
+
+#else /* #ifdef FIT_USE_AES_TTABLE */
+
+/**
+ *
+ * fit_aes256_encrypt_words
+ *
+ * Encrypts one or two blocks with the same AES-256 key, expanding key on the fly.
+ * Byte oriented variant: blocks are converted to bytes and encrypted by
+ * fit_aes256_expand_encrypt.
+ *
+ * @param IN    key     \n AES-256 key (8 words).
+ *
+ * @param IO    lane0   \n Data to be encrypted (4 words). On return contains
+ *                         encrypted data.
+ *
+ * @param IO    lane1   \n Second block encrypted with the same key (4 words); NULL
+ *                         if only one block is to be encrypted.
+ *
+ */
+void fit_aes256_encrypt_words(const uint32_t *key, uint32_t *lane0, uint32_t *lane1)
+{
+    uint8_t k[FIT_AES_256_KEY_LENGTH];
+    uint8_t block[FIT_AES_OUTPUT_DATA_SIZE];
+    uint32_t *lane = lane0;
+    uint8_t i = 0;
+
+    for (i = 0; i < FIT_AES_256_KEY_LENGTH / 4; ++i)
+    {
+        FIT_AES_PUTU32(k + 4 * i, key[i]);
+    }
+
+    while (lane != NULL)
+    {
+        for (i = 0; i < 4; ++i)
+        {
+            FIT_AES_PUTU32(block + 4 * i, lane[i]);
+        }
+        fit_aes256_expand_encrypt(k, block);
+        for (i = 0; i < 4; ++i)
+        {
+            lane[i] = FIT_AES_GETU32(block + 4 * i);
+        }
+        lane = (lane == lane0) ? lane1 : NULL;
+    }
+}
+
+#endif /* #ifdef FIT_USE_AES_TTABLE */
+
 void fit_block_copy(uint8_t *output, uint8_t *input)
 {
     uint8_t i = 0;
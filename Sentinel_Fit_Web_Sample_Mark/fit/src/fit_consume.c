@@ -23,6 +23,13 @@
 #include "fit_hwdep.h"
 #include "fit_debug.h"
 #include "fit_mem_read.h"
+#include "fit_consume.h"
+
+#ifdef FIT_USE_FEATURE_INDEX
+/** Slot of feature table where lookup for feature id starts (multiplicative hashing).*/
+#define FIT_FEATURE_INDEX_SLOT(featid)  \
+    ((uint16_t)(((uint32_t)(featid)*0x9E3779B1UL) >> 16) & (FIT_FEATURE_INDEX_SIZE-1))
+#endif /* #ifdef FIT_USE_FEATURE_INDEX */
 
 /**
  *
@@ -74,9 +81,9 @@ fit_status_t fit_find_feature_id(fit_pointer_t *pdata,
     {
         /* Get integer value. Integer value can be 16 bit value or 32 bit value.*/
         if (length == sizeof(uint16_t))
-            integer = (read_word(pdata->data, pdata->read_byte)/2)-1;
+            integer = (fitptr_read_word(pdata->data, pdata)/2)-1;
         else if (length == sizeof(uint32_t))
-            integer = read_dword(pdata->data, pdata->read_byte);
+            integer = fitptr_read_dword(pdata->data, pdata);
 
         /* Check if this feature id is what we are looking for.*/
         if (((fit_context_data_t *)pcontext)->parserdata.id == integer)
@@ -167,7 +174,7 @@ fit_status_t fit_get_license_sign_algid(fit_pointer_t *license, uint32_t *algid)
     if (status == FIT_STATUS_OK && context.parserstatus == FIT_INFO_STOP_PARSE &&
             context.status == FIT_STATUS_LIC_FIELD_PRESENT)
     {
-        *algid = (uint32_t)(read_word(context.parserdata.addr, license->read_byte)/2)-1;
+        *algid = (uint32_t)(fitptr_read_word(context.parserdata.addr, license)/2)-1;
         status = FIT_STATUS_OK;
     }
     else
@@ -193,7 +200,7 @@ fit_status_t fit_get_license_sign_algid(fit_pointer_t *license, uint32_t *algid)
  *                             data against data passed in.
  *
  */
-static fit_status_t fit_get_lic_prop_data(fit_pointer_t *pdata, fit_licensemodel_t *licmodel)
+fit_status_t fit_get_lic_prop_data(fit_pointer_t *pdata, fit_licensemodel_t *licmodel)
 {
     uint16_t cntr       = 0;
     /*
@@ -205,7 +212,7 @@ static fit_status_t fit_get_lic_prop_data(fit_pointer_t *pdata, fit_licensemodel
     uint8_t index       = 0;
     uint8_t *temp       = pdata->data;
     /* Get the number of fields present in license property data */
-    uint16_t num_fields = read_word(pdata->data, pdata->read_byte);
+    uint16_t num_fields = fitptr_read_word(pdata->data, pdata);
     uint16_t field_data = 0;
     uint16_t struct_offset  = (num_fields+1)*FIT_PFIELD_SIZE;
 
@@ -220,7 +227,7 @@ static fit_status_t fit_get_lic_prop_data(fit_pointer_t *pdata, fit_licensemodel
     /* Parse all fields data in a structure.*/
     for( cntr = 0; cntr < num_fields; cntr++)
     {
-        field_data = read_word(pdata->data, pdata->read_byte);
+        field_data = fitptr_read_word(pdata->data, pdata);
         /* If field_data is zero, that means the field data is encoded in data part.*/
         if( field_data == 0 )
         {
@@ -251,29 +258,29 @@ static fit_status_t fit_get_lic_prop_data(fit_pointer_t *pdata, fit_licensemodel
         {
             /* Skip the data part as we are not interested in feature data here */
             struct_offset   = (uint16_t)(struct_offset +
-                (uint16_t)read_dword(temp+struct_offset, pdata->read_byte) +
+                (uint16_t)fitptr_read_dword(temp+struct_offset, pdata) +
                 sizeof(uint32_t));
         }
         else if (index == FIT_PERPETUAL_FIELD)
         {
             /* Get the perpetual value */
             licmodel->isperpetual = 
-                (fit_boolean_t)(read_word(pdata->data, pdata->read_byte)/2 - 1);
+                (fit_boolean_t)(fitptr_read_word(pdata->data, pdata)/2 - 1);
         }
         else if (index == FIT_START_DATE_FIELD)
         {
             /* Start date is present in license string */
             licmodel->isstartdate = FIT_TRUE;
             /* Get the time when license is generated i.e. date when license is created */
-            licmodel->startdate = read_dword((temp+struct_offset)+sizeof(uint32_t),
-                pdata->read_byte);
+            licmodel->startdate = fitptr_read_dword((temp+struct_offset)+sizeof(uint32_t),
+                pdata);
 
             /* 
              * Get to next field data value (for those fields for which field data
              * is encoded in data part.
              */
             struct_offset   = (uint16_t)(struct_offset +
-                (uint16_t)read_dword(temp+struct_offset, pdata->read_byte) +
+                (uint16_t)fitptr_read_dword(temp+struct_offset, pdata) +
                 sizeof(uint32_t));
         }
         else if (index == FIT_END_DATE_FIELD)
@@ -281,15 +288,15 @@ static fit_status_t fit_get_lic_prop_data(fit_pointer_t *pdata, fit_licensemodel
             /* license is time expiration based license */
             licmodel->isenddate = FIT_TRUE;
             /* Get the expiration time i..e time by which license would get expired. */
-            licmodel->enddate = read_dword((temp+struct_offset)+sizeof(uint32_t),
-                pdata->read_byte);
+            licmodel->enddate = fitptr_read_dword((temp+struct_offset)+sizeof(uint32_t),
+                pdata);
 
             /* 
              * Get to next field data value (for those fields for which field data
              * is encoded in data part.
              */
             struct_offset   = (uint16_t)(struct_offset +
-                (uint16_t)read_dword(temp+struct_offset, pdata->read_byte) +
+                (uint16_t)fitptr_read_dword(temp+struct_offset, pdata) +
                 sizeof(uint32_t));
         }
 
@@ -302,122 +309,244 @@ static fit_status_t fit_get_lic_prop_data(fit_pointer_t *pdata, fit_licensemodel
     return FIT_STATUS_OK;
 }
 
+#ifdef FIT_USE_FEATURE_INDEX
+
 /**
  *
- * \skip fit_licenf_consume_license
+ * \skip fit_feature_index_add
  *
- * This function is used to grant or deny access to different areas of functionality
- * in the software. This feature is similar to login type operation on licenses. It
- * will look for presence of feature id in the license binary.
+ * This function is used for adding feature id to feature table of license index.
+ * If feature id is already present in table then first entry is kept, as lookup
+ * by parsing license also returns first license property block containing feature
+ * id. If table is full then feature_overflow is set in license index.
  *
- * @param IN  \b  license       \n  Start address of the license in binary format,
- *                                  depending on your READ_LICENSE_BYTE definition
- *                                  e.g. in case of RAM, this can just be the memory
- *                                  address of the license variable 
+ * @param IO    licindex    \n Pointer to license index.
  *
- * @param IN  \b  feature_id    \n  feature id which will be consumed/used for login
- *                                  operation.
+ * @param IN    featid      \n feature id to be added.
  *
- * @param IN  \b  keys          \n  Pointer to array of key data. Also contains
- *                                  callback function to read key data in different
- *                                  types of memory(FLASH, E2, RAM).
+ * @param IN    lic_prop    \n Position+1 of license property block (in lic_prop of
+ *                             license index) that contains feature id.
  *
- * @return FIT_STATUS_FEATURE_EXPIRED if feature_if got expired
- * @return FIT_STATUS_INVALID_V2C if Invalid liocense binary data format.
- * @return FIT_STATUS_FEATURE_NOT_FOUND if feature id is not present in license binary.
- * @return FIT_STATUS_INVALID_LICENSE_TYPE if license type is not recognized.
- * @return FIT_STATUS_INACTIVE_LICENSE if license is not active yet.
- * @return FIT_STATUS_NO_CLOCK_SUPPORT if clock support is not present.
- * @return FIT_STATUS_INVALID_VALUE if Invalid value is found for license string passed in.
- * @return FIT_STATUS_RTC_NOT_PRESENT if real time clock is not present on hardware board
- * @return FIT_STATUS_INVALID_PARAM_1 if license string is NULL or not readable.
- * @return FIT_STATUS_INVALID_PARAM_2 if feature id is out of range.
- * @return FIT_STATUS_INVALID_PARAM_4 if rsa public key is NULL or not readable.
+ */
+void fit_feature_index_add(fit_license_index_t *licindex, uint32_t featid, uint8_t lic_prop)
+{
+    uint16_t slot   = FIT_FEATURE_INDEX_SLOT(featid);
+    uint16_t cntr   = 0;
+
+    for (cntr = 0; cntr < FIT_FEATURE_INDEX_SIZE; cntr++)
+    {
+        if (licindex->features[slot].lic_prop == 0)
+        {
+            licindex->features[slot].featid = featid;
+            licindex->features[slot].lic_prop = lic_prop;
+            return;
+        }
+        if (licindex->features[slot].featid == featid)
+            return;
+
+        /* Linear probing.*/
+        slot = (uint16_t)((slot+1) & (FIT_FEATURE_INDEX_SIZE-1));
+    }
+
+    licindex->feature_overflow = FIT_TRUE;
+}
+
+/**
+ *
+ * \skip fit_feature_index_find
+ *
+ * This function is used for looking up feature id in feature table of license
+ * index.
+ *
+ * @param IN    licindex    \n Pointer to license index.
+ *
+ * @param IN    featid      \n feature id to look for.
+ *
+ * @return Position+1 of license property block (in lic_prop of license index) that
+ *         contains feature id; 0 if feature id is not present in table.
  *
  */
-fit_status_t fit_licenf_consume_license(fit_pointer_t *license,
-                                        uint32_t feature_id,
-                                        fit_key_array_t *keys)
+uint8_t fit_feature_index_find(fit_license_index_t *licindex, uint32_t featid)
+{
+    uint16_t slot   = FIT_FEATURE_INDEX_SLOT(featid);
+    uint16_t cntr   = 0;
+
+    for (cntr = 0; cntr < FIT_FEATURE_INDEX_SIZE; cntr++)
+    {
+        if (licindex->features[slot].lic_prop == 0)
+            break;
+        if (licindex->features[slot].featid == featid)
+            return licindex->features[slot].lic_prop;
+
+        slot = (uint16_t)((slot+1) & (FIT_FEATURE_INDEX_SIZE-1));
+    }
+
+    return 0;
+}
+
+#endif /* #ifdef FIT_USE_FEATURE_INDEX */
+
+/**
+ *
+ * \skip fit_lookup_feature_id
+ *
+ * This function is used for getting licensing model of license property block that
+ * contains the feature id passed in. If license index is passed then feature table
+ * of license index is used, or only license property blocks recorded in license
+ * index are parsed; otherwise complete license binary is parsed.
+ *
+ * @param IN    license     \n Pointer to fit_pointer_t structure containing license
+ *                             data.
+ *
+ * @param IN    feature_id  \n feature id to look for.
+ *
+ * @param IN    licindex    \n Pointer to license index for license passed in. Can be
+ *                             NULL.
+ *
+ * @param OUT   licmodel    \n On return this will contain licensing model of license
+ *                             property block that contains the feature id.
+ *
+ * @return FIT_STATUS_OK if feature id is found; otherwise appropriate error code.
+ *
+ */
+static fit_status_t fit_lookup_feature_id(fit_pointer_t *license,
+                                          uint32_t feature_id,
+                                          fit_license_index_t *licindex,
+                                          fit_licensemodel_t *licmodel)
 {
-    uint8_t *lic_addr       = NULL;
-    uint32_t curtime = 0;
-    fit_pointer_t fitptr;
-    fit_licensemodel_t licensemodel;
-    fit_context_data_t context;
     fit_status_t status     = FIT_STATUS_UNKNOWN_ERROR;
+    fit_context_data_t context;
+    fit_pointer_t fitptr;
+    uint8_t cntr            = 0;
 
-    DBG(FIT_TRACE_INFO, "[fit_licenf_consume_license]: feature_id=%d, pdata=0x%p \n",
-        feature_id, license->data);
+#ifdef FIT_USE_FEATURE_INDEX
+    if (licindex != NULL && licindex->feature_overflow == FIT_FALSE)
+    {
+        /* All features of license are present in feature table.*/
+        cntr = fit_feature_index_find(licindex, feature_id);
+        if (cntr == 0)
+        {
+            DBG(FIT_TRACE_ERROR, "Requested Feature ID NOT found in license index\n");
+            return FIT_STATUS_FEATURE_NOT_FOUND;
+        }
 
-    /* Validate parameters.*/
-    if (license->read_byte == NULL)
-        return FIT_STATUS_INVALID_PARAM_1;
-    if (feature_id > FIT_MAX_FEATURE_ID_VALUE)
-        return FIT_STATUS_INVALID_PARAM_2;
-    if (keys->read_byte == NULL)
-        return FIT_STATUS_INVALID_PARAM_4;
+        *licmodel = licindex->lic_model[cntr-1];
+        return FIT_STATUS_OK;
+    }
+#endif /* #ifdef FIT_USE_FEATURE_INDEX */
 
     fit_memset((uint8_t *)&context, 0 , sizeof(fit_context_data_t));
-    fit_memset((uint8_t *)&licensemodel, 0, sizeof(fit_licensemodel_t));
     fit_memset((uint8_t *)&fitptr, 0, sizeof(fit_pointer_t));
     fitptr.read_byte = license->read_byte;
 
-    /** Verify the license string against signing key data present in keys array
-      * and node locking 
-      */
-    status = fit_verify_license(license, keys, FIT_TRUE);
-    if (status != FIT_STATUS_OK)
-        return status;
-
-    DBG(FIT_TRACE_INFO, "See the presence of feature id ((%d) in license binary \n",
-        feature_id );
     /* fill the requested operation type and its related data.*/
     context.operation = (uint8_t)FIT_OP_FIND_FEATURE_ID;
     context.parserdata.id = feature_id;
     context.status = FIT_STATUS_INVALID_VALUE;
 
-    /*
-     * Parse the license data to look for Feature id that will be used for
-     * login type operation.
-     */
-    status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license,
-        &context);
-
-    if (status == FIT_STATUS_OK && (context.parserstatus == FIT_INFO_STOP_PARSE ||
-            context.parserstatus == FIT_INFO_CONTINUE_PARSE))
+    if (licindex != NULL && licindex->lic_prop_overflow == FIT_FALSE)
     {
-        /* Set the consume license status value.*/
-        status = (fit_status_t)context.status;
+        /* Parse only license property blocks recorded in license index.*/
+        for (cntr = 0; cntr < licindex->num_lic_props; cntr++)
+        {
+            fitptr.data = licindex->lic_prop[cntr];
+            status = fit_parse_object(FIT_STRUCT_LIC_PROP_LEVEL, FIT_FEATURE_FIELD,
+                &fitptr, &context);
+            if (status != FIT_STATUS_OK)
+                return FIT_STATUS_INVALID_V2C;
+            if (context.status == FIT_INFO_FEATURE_ID_FOUND)
+            {
+                /* Licensing model is already decoded in license index.*/
+                *licmodel = licindex->lic_model[cntr];
+                return FIT_STATUS_OK;
+            }
+        }
     }
     else
     {
         /*
-         *If there is any error during lookup of feature ID then license string is
-         * not valid.
+         * Parse the license data to look for Feature id that will be used for
+         * login type operation.
          */
-        return FIT_STATUS_INVALID_V2C;
+        status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license,
+            &context);
+        if (!(status == FIT_STATUS_OK && (context.parserstatus == FIT_INFO_STOP_PARSE ||
+                context.parserstatus == FIT_INFO_CONTINUE_PARSE)))
+        {
+            /*
+             *If there is any error during lookup of feature ID then license string is
+             * not valid.
+             */
+            return FIT_STATUS_INVALID_V2C;
+        }
     }
 
-    if (status != FIT_INFO_FEATURE_ID_FOUND)
+    if (context.status != FIT_INFO_FEATURE_ID_FOUND)
     {
-        DBG(FIT_TRACE_ERROR, "Requested Feature ID NOT found error = %d\n", status);
+        DBG(FIT_TRACE_ERROR, "Requested Feature ID NOT found error = %d\n", context.status);
         return FIT_STATUS_FEATURE_NOT_FOUND;
     }
-    else
-    {
-        lic_addr = context.parserdata.addr;
-        if (lic_addr == NULL)
-            return FIT_STATUS_INVALID_V2C;
-    }
 
-    DBG(FIT_TRACE_INFO, "Requested Feature ID found with status = %d\n", status);
+    if (context.parserdata.addr == NULL)
+        return FIT_STATUS_INVALID_V2C;
 
-    fitptr.data = lic_addr;
+    fitptr.data = context.parserdata.addr;
     /* Get the license property data for feature ID found in license string.*/
-    status = fit_get_lic_prop_data(&fitptr, &licensemodel);
+    status = fit_get_lic_prop_data(&fitptr, licmodel);
     if (status != FIT_STATUS_OK)
         return FIT_STATUS_INVALID_VALUE;
 
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * \skip fit_consume_license
+ *
+ * This function is used to grant or deny access to different areas of functionality
+ * in the software. Common implementation of fit_licenf_consume_license and
+ * fit_licenf_consume_license_idx.
+ *
+ * @param IN    license     \n Pointer to fit_pointer_t structure containing license
+ *                             data.
+ *
+ * @param IN    feature_id  \n feature id which will be consumed/used for login
+ *                             operation.
+ *
+ * @param IN    keys        \n Pointer to array of key data.
+ *
+ * @param IN    licindex    \n Pointer to license index for license passed in. NULL if
+ *                             license binary is to be parsed for getting field data.
+ *
+ * @return FIT_STATUS_OK on success; otherwise appropriate error code.
+ *
+ */
+static fit_status_t fit_consume_license(fit_pointer_t *license,
+                                        uint32_t feature_id,
+                                        fit_key_array_t *keys,
+                                        fit_license_index_t *licindex)
+{
+    uint32_t curtime = 0;
+    fit_licensemodel_t licensemodel;
+    fit_status_t status     = FIT_STATUS_UNKNOWN_ERROR;
+
+    fit_memset((uint8_t *)&licensemodel, 0, sizeof(fit_licensemodel_t));
+
+    /** Verify the license string against signing key data present in keys array
+      * and node locking 
+      */
+    status = fit_verify_license(license, keys, FIT_TRUE, licindex);
+    if (status != FIT_STATUS_OK)
+        return status;
+
+    DBG(FIT_TRACE_INFO, "See the presence of feature id ((%d) in license binary \n",
+        feature_id );
+    status = fit_lookup_feature_id(license, feature_id, licindex, &licensemodel);
+    if (status != FIT_STATUS_OK)
+        return status;
+
+    DBG(FIT_TRACE_INFO, "Requested Feature ID found with status = %d\n", status);
+
     /* Get the current time in unixtime for time based licenses. */
     if (licensemodel.isstartdate == FIT_TRUE || licensemodel.isenddate == FIT_TRUE)
     {
@@ -480,3 +609,104 @@ fit_status_t fit_licenf_consume_license(fit_pointer_t *license,
 
     return FIT_STATUS_INVALID_LICENSE_TYPE;
 }
+
+/**
+ *
+ * \skip fit_licenf_consume_license
+ *
+ * This function is used to grant or deny access to different areas of functionality
+ * in the software. This feature is similar to login type operation on licenses. It
+ * will look for presence of feature id in the license binary.
+ *
+ * @param IN  \b  license       \n  Start address of the license in binary format,
+ *                                  depending on your READ_LICENSE_BYTE definition
+ *                                  e.g. in case of RAM, this can just be the memory
+ *                                  address of the license variable 
+ *
+ * @param IN  \b  feature_id    \n  feature id which will be consumed/used for login
+ *                                  operation.
+ *
+ * @param IN  \b  keys          \n  Pointer to array of key data. Also contains
+ *                                  callback function to read key data in different
+ *                                  types of memory(FLASH, E2, RAM).
+ *
+ * @return FIT_STATUS_FEATURE_EXPIRED if feature_if got expired
+ * @return FIT_STATUS_INVALID_V2C if Invalid liocense binary data format.
+ * @return FIT_STATUS_FEATURE_NOT_FOUND if feature id is not present in license binary.
+ * @return FIT_STATUS_INVALID_LICENSE_TYPE if license type is not recognized.
+ * @return FIT_STATUS_INACTIVE_LICENSE if license is not active yet.
+ * @return FIT_STATUS_NO_CLOCK_SUPPORT if clock support is not present.
+ * @return FIT_STATUS_INVALID_VALUE if Invalid value is found for license string passed in.
+ * @return FIT_STATUS_RTC_NOT_PRESENT if real time clock is not present on hardware board
+ * @return FIT_STATUS_INVALID_PARAM_1 if license string is NULL or not readable.
+ * @return FIT_STATUS_INVALID_PARAM_2 if feature id is out of range.
+ * @return FIT_STATUS_INVALID_PARAM_4 if rsa public key is NULL or not readable.
+ *
+ */
+fit_status_t fit_licenf_consume_license(fit_pointer_t *license,
+                                        uint32_t feature_id,
+                                        fit_key_array_t *keys)
+{
+    DBG(FIT_TRACE_INFO, "[fit_licenf_consume_license]: feature_id=%d, pdata=0x%p \n",
+        feature_id, license->data);
+
+    /* Validate parameters.*/
+    if (license->read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+    if (feature_id > FIT_MAX_FEATURE_ID_VALUE)
+        return FIT_STATUS_INVALID_PARAM_2;
+    if (keys->read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM_4;
+
+    return fit_consume_license(license, feature_id, keys, NULL);
+}
+
+/**
+ *
+ * \skip fit_licenf_consume_license_idx
+ *
+ * This function is same as fit_licenf_consume_license except that addresses of
+ * license fields (signature, fingerprint, license property blocks etc.) are taken
+ * from license index instead of parsing complete license binary.
+ *
+ * @param IN  \b  license       \n  Start address of the license in binary format,
+ *                                  depending on your READ_LICENSE_BYTE definition
+ *                                  e.g. in case of RAM, this can just be the memory
+ *                                  address of the license variable 
+ *
+ * @param IN  \b  feature_id    \n  feature id which will be consumed/used for login
+ *                                  operation.
+ *
+ * @param IN  \b  keys          \n  Pointer to array of key data. Also contains
+ *                                  callback function to read key data in different
+ *                                  types of memory(FLASH, E2, RAM).
+ *
+ * @param IN  \b  licindex      \n  Pointer to license index built by
+ *                                  fit_licenf_build_license_index for license
+ *                                  passed in.
+ *
+ * @return same values as fit_licenf_consume_license.
+ * @return FIT_STATUS_INVALID_PARAM_3 if license index is not valid for license
+ *                                    passed in.
+ *
+ */
+fit_status_t fit_licenf_consume_license_idx(fit_pointer_t *license,
+                                            uint32_t feature_id,
+                                            fit_key_array_t *keys,
+                                            fit_license_index_t *licindex)
+{
+    DBG(FIT_TRACE_INFO, "[fit_licenf_consume_license_idx]: feature_id=%d, pdata=0x%p \n",
+        feature_id, license->data);
+
+    /* Validate parameters.*/
+    if (license->read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+    if (feature_id > FIT_MAX_FEATURE_ID_VALUE)
+        return FIT_STATUS_INVALID_PARAM_2;
+    if (fit_license_index_ok(license, licindex) != FIT_TRUE)
+        return FIT_STATUS_INVALID_PARAM_3;
+    if (keys->read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM_4;
+
+    return fit_consume_license(license, feature_id, keys, licindex);
+}
@@ -25,11 +25,10 @@
 #include "fit_internal.h"
 #include "fit_debug.h"
 #include "fit_hwdep.h"
+#include "fit_mem_read.h"
 
 /* Constants ****************************************************************/
 
-#define FIT_DM_CIPHER_BLOCK_SIZE            0x10
-#define FIT_ROUNDS_128BIT_KEY_LENGTH        0xB0
 #define FIT_BITS_PER_BYTE                   8
 
 /* Global variables *********************************************************/
@@ -38,7 +37,7 @@
 
 /**
  *
- * \skip fit_dm_hash_init
+ * \skip fit_dm_hash_pad
  *
  * This function will be used to pad the data to make its length be an even multiple
  * of the block size and include a length encoding. This is done by padding with zeros
@@ -55,14 +54,14 @@
  *                             of stack size for long messages)
  *
  */
-void fit_dm_hash_init(uint8_t *pdata, uint16_t *pdatalen, uint16_t msgfulllen)
+void fit_dm_hash_pad(uint8_t *pdata, uint16_t *pdatalen, uint16_t msgfulllen)
 {
     uint16_t length         = 0;
     uint16_t sizeinbits     = 0;
     uint16_t cntr           = 0;
     uint8_t zeropads        = 0;
 
-    DBG(FIT_TRACE_INFO, "\nfit_dm_hash_init..\n");
+    DBG(FIT_TRACE_INFO, "\nfit_dm_hash_pad..\n");
 
     length = *pdatalen;
     sizeinbits= msgfulllen*FIT_BITS_PER_BYTE;
@@ -97,155 +96,181 @@ void fit_dm_hash_init(uint8_t *pdata, uint16_t *pdatalen, uint16_t msgfulllen)
 
 /**
  *
- * \skip fit_davies_meyer_hash
+ * \skip fit_dm_hash_block
  *
- * This function will be used to get the davies meyer hash of the data passed in.
- * This is performed by first splitting the data (message m) into 128 bits (m1  mn)
- * For each of the 128 bit sub-block, calculate
+ * Hashes one 128 bit sub-block of message:
  *      Hi = AES (Hi-1, mi)  XOR Hi-1
- * The final Hash is calculated as:
- *      H = AES (Hn, Hn) XOR Hn
  *
- * @param IN    pdata   \n Pointer to data for which davies meyer hash to be calculated
+ * @param IO    hash    \n Intermediate hash value (Hi-1 on input, Hi on return).
  *
- * @param OUT   dmhash  \n On return this will contain the davies mayer hash of data
- *                         passed in.
+ * @param IN    msg     \n Message sub-block (16 bytes), used as AES-128 key.
  *
  */
-fit_status_t fit_davies_meyer_hash(fit_pointer_t *pdata, uint8_t *dmhash)
+static void fit_dm_hash_block(uint8_t *hash, const uint8_t *msg)
 {
-    fit_status_t  status            = FIT_STATUS_OK;
-    uint8_t aes_state[4][4];
-    uint16_t cntr                   = 0;
-    uint16_t cntr2                  = 0;
     uint8_t output[FIT_AES_OUTPUT_DATA_SIZE];
-    uint8_t prev_hash[FIT_DM_HASH_SIZE];
-    fit_aes_t aes;
-    uint8_t tempmsg[32];
-    uint16_t msglen         = 0;
-    fit_pointer_t fitptr;
-    fit_pointer_t fitkey;
-    fit_pointer_t fittempptr;
-    uint8_t *skey;
-
-    skey = fit_calloc(1, FIT_ROUNDS_128BIT_KEY_LENGTH);
-    if (NULL == skey) {
-        status = FIT_STATUS_INSUFFICIENT_MEMORY;
-        DBG(FIT_TRACE_ERROR, "failed to initialize aes error =%d\n", status);
-        goto bail;
-    }
+    uint8_t cntr = 0;
 
-    fit_memset((uint8_t *)&fitkey, 0, sizeof(fit_pointer_t));
-    fit_memset(tempmsg, 0, sizeof(tempmsg));
-    fit_memset((uint8_t *)&fitptr, 0, sizeof(fit_pointer_t));
-    fit_memset((uint8_t *)&fittempptr, 0, sizeof(fit_pointer_t));
-    fit_memset(prev_hash, 0xFF, FIT_DM_HASH_SIZE);
-    /* Initialize the read pointer.*/
-    fitptr.read_byte = pdata->read_byte;
-    fitkey.read_byte = (fit_read_byte_callback_t) FIT_READ_BYTE_RAM;
-
-    /*
-     * For each of the 128 bit sub-block, calculate
-     *      Hi = AES (Hi-1, mi)  XOR Hi-1
-     */
-    for (cntr = 0; cntr < pdata->length; cntr+=16)
+    for (cntr = 0; cntr < FIT_DM_CIPHER_BLOCK_SIZE; cntr++)
     {
-        if ((cntr+16) < pdata->length)
-        {
-            /* Initialize the aes context */
-            fittempptr.data = (pdata->data)+cntr;
-            fittempptr.length = FIT_AES_128_KEY_LENGTH;
-            fittempptr.read_byte = pdata->read_byte;
-
-            fitptr_memcpy(tempmsg, &fittempptr);
-            fitkey.data = (uint8_t *)tempmsg;
-            fitkey.length = FIT_AES_128_KEY_LENGTH;
-            status = fit_aes_setup(&aes, &fitkey, skey);
-            if (status != FIT_STATUS_OK)
-            {
-                DBG(FIT_TRACE_ERROR, "failed to initialize aes setup error =%d\n",
-                    status);
-                goto bail;
-            }
-
-            fit_memset((uint8_t*)aes_state, 0, sizeof(aes_state));
-            fit_memset((uint8_t*)output, 0, sizeof(output));
-            /* Encrypt data (AES 128) */
-            fit_aes_encrypt(&aes, prev_hash, output, skey, (uint8_t*)aes_state);
-            for (cntr2 = 0; cntr2 < 16; cntr2++)
-            {
-                dmhash[cntr2] = output[cntr2] ^ prev_hash[cntr2];
-            }
-            fit_memcpy(prev_hash, dmhash, 16);
-        }
+        output[cntr] = hash[cntr];
     }
-    cntr -= 16;
+    /* Encrypt data (AES 128) */
+    fit_aes128_expand_encrypt(msg, output);
+    for (cntr = 0; cntr < FIT_DM_CIPHER_BLOCK_SIZE; cntr++)
+    {
+        hash[cntr] ^= output[cntr];
+    }
+}
 
-    fit_memset(tempmsg, 0, sizeof(tempmsg));
-    /*
-     * Pad the last block of data (last block will always be less than 16 bytes)
-     * and calculate Hi = AES (Hi-1, mi)  XOR Hi-1 
-     */
-    fitptr.data = pdata->data+cntr;
-    fitptr.length = pdata->length-cntr;
-    msglen = fitptr.length;
-    fitptr_memcpy(tempmsg, &fitptr);
-
-    /* Do padding for the last block of data.*/
-    fit_dm_hash_init(tempmsg, &msglen, pdata->length);
-    /*
-     * For each of the 128 bit sub-block, calculate
-     *      Hi = AES (Hi-1, mi)  XOR Hi-1
-     */
-    for (cntr = 0; cntr < msglen; cntr+=16)
+/**
+ *
+ * \skip fit_dm_hash_init
+ *
+ * This function initializes context for incremental davies meyer hash calculation.
+ * Data is then passed by one or more fit_dm_hash_update calls, and the hash is
+ * returned by fit_dm_hash_final. No memory is allocated.
+ *
+ * @param OUT   ctx     \n Pointer to davies meyer hash context.
+ *
+ */
+void fit_dm_hash_init(fit_dm_hash_ctx_t *ctx)
+{
+    fit_memset(ctx->hash, 0xFF, sizeof(ctx->hash));
+    fit_memset(ctx->buf, 0, sizeof(ctx->buf));
+    ctx->buflen = 0;
+    ctx->msglen = 0;
+}
+
+/**
+ *
+ * \skip fit_dm_hash_update
+ *
+ * This function adds data to davies meyer hash calculation. Data can be passed in
+ * chunks of any size; complete 128 bit sub-blocks are hashed immediately, remaining
+ * bytes are kept in context.
+ *
+ * @param IO    ctx     \n Pointer to davies meyer hash context.
+ *
+ * @param IN    data    \n Pointer to data (in RAM) to be hashed.
+ *
+ * @param IN    len     \n Length of data.
+ *
+ */
+void fit_dm_hash_update(fit_dm_hash_ctx_t *ctx, const uint8_t *data, uint16_t len)
+{
+    uint16_t cnt = 0;
+
+    ctx->msglen += len;
+
+    /* Complete sub-block kept from previous call */
+    if (ctx->buflen != 0)
     {
-        /* Initialize the aes context */
-        fitkey.data = tempmsg+cntr;
-        fitkey.length = FIT_AES_128_KEY_LENGTH;
-        status = fit_aes_setup(&aes, &fitkey, skey);
-        if (status != FIT_STATUS_OK)
+        cnt = FIT_DM_CIPHER_BLOCK_SIZE - ctx->buflen;
+        if (cnt > len)
         {
-            DBG(FIT_TRACE_ERROR, "failed to initialize aes setup error =%d\n",
-                status);
-            goto bail;
+            cnt = len;
         }
+        fit_memcpy(ctx->buf + ctx->buflen, (uint8_t *)data, cnt);
+        ctx->buflen += (uint8_t)cnt;
+        data += cnt;
+        len -= cnt;
 
-        fit_memset((uint8_t*)aes_state, 0, sizeof(aes_state));
-        fit_memset((uint8_t*)output, 0, sizeof(output));
-        /* Encrypt data (AES 128) */
-        fit_aes_encrypt(&aes, prev_hash, output, skey, (uint8_t*)aes_state);
-        for (cntr2 = 0; cntr2 < 16; cntr2++)
+        if (ctx->buflen < FIT_DM_CIPHER_BLOCK_SIZE)
         {
-            dmhash[cntr2] = output[cntr2] ^ prev_hash[cntr2];
+            return;
         }
-        fit_memcpy(prev_hash, dmhash, 16);
+        fit_dm_hash_block(ctx->hash, ctx->buf);
+        ctx->buflen = 0;
     }
 
-    /*
-     * The final Hash is calculated as:
-     *      H = AES (Hn, Hn) XOR Hn
-     * Initialize the aes context
-     */
-    fitkey.data = prev_hash;
-    fitkey.length = FIT_AES_128_KEY_LENGTH;
-    status = fit_aes_setup(&aes, &fitkey, skey);
-    if (status != FIT_STATUS_OK)
+    /* Hash complete sub-blocks directly from data */
+    while (len >= FIT_DM_CIPHER_BLOCK_SIZE)
     {
-        DBG(FIT_TRACE_ERROR, "failed to initialize aes setup error =%d\n", status);
-        goto bail;
+        fit_dm_hash_block(ctx->hash, data);
+        data += FIT_DM_CIPHER_BLOCK_SIZE;
+        len -= FIT_DM_CIPHER_BLOCK_SIZE;
     }
 
-    fit_memset((uint8_t*)aes_state, 0, sizeof(aes_state));
-    fit_memset((uint8_t*)output, 0, sizeof(output));
-    /* Encrypt data (AES 128) */
-    fit_aes_encrypt(&aes, prev_hash, output, skey, (uint8_t*)aes_state);
-    for (cntr2 = 0; cntr2 < 16; cntr2++)
+    if (len != 0)
     {
-        dmhash[cntr2] = output[cntr2] ^ prev_hash[cntr2];
+        fit_memcpy(ctx->buf, (uint8_t *)data, len);
+        ctx->buflen = (uint8_t)len;
     }
+}
 
-bail:
-    if (skey) fit_free(skey);
-    return status;
+/**
+ *
+ * \skip fit_dm_hash_final
+ *
+ * This function pads the data kept in context, hashes it and calculates the final
+ * hash as:
+ *      H = AES (Hn, Hn) XOR Hn
+ *
+ * @param IO    ctx     \n Pointer to davies meyer hash context.
+ *
+ * @param OUT   dmhash  \n On return this will contain the davies mayer hash of data
+ *                         passed to fit_dm_hash_update.
+ *
+ */
+void fit_dm_hash_final(fit_dm_hash_ctx_t *ctx, uint8_t *dmhash)
+{
+    uint8_t tempmsg[32];
+    uint16_t msglen = ctx->buflen;
+    uint16_t cntr = 0;
+
+    fit_memset(tempmsg, 0, sizeof(tempmsg));
+    fit_memcpy(tempmsg, ctx->buf, ctx->buflen);
+
+    /* Do padding for the last block of data (length is encoded on 16 bits).*/
+    fit_dm_hash_pad(tempmsg, &msglen, (uint16_t)ctx->msglen);
+    for (cntr = 0; cntr < msglen; cntr += FIT_DM_CIPHER_BLOCK_SIZE)
+    {
+        fit_dm_hash_block(ctx->hash, tempmsg + cntr);
+    }
+
+    /* H = AES (Hn, Hn) XOR Hn */
+    fit_memcpy(tempmsg, ctx->hash, FIT_DM_CIPHER_BLOCK_SIZE);
+    fit_dm_hash_block(ctx->hash, tempmsg);
+    fit_memcpy(dmhash, ctx->hash, FIT_DM_CIPHER_BLOCK_SIZE);
 }
 
+/**
+ *
+ * \skip fit_davies_meyer_hash
+ *
+ * This function will be used to get the davies meyer hash of the data passed in.
+ * This is performed by first splitting the data (message m) into 128 bits (m1  mn)
+ * For each of the 128 bit sub-block, calculate
+ *      Hi = AES (Hi-1, mi)  XOR Hi-1
+ * The final Hash is calculated as:
+ *      H = AES (Hn, Hn) XOR Hn
+ *
+ * @param IN    pdata   \n Pointer to data for which davies meyer hash to be calculated
+ *
+ * @param OUT   dmhash  \n On return this will contain the davies mayer hash of data
+ *                         passed in.
+ *
+ */
+fit_status_t fit_davies_meyer_hash(fit_pointer_t *pdata, uint8_t *dmhash)
+{
+    fit_dm_hash_ctx_t ctx;
+    uint8_t tempmsg[FIT_DM_CIPHER_BLOCK_SIZE];
+    uint16_t cntr   = 0;
+    uint16_t len    = 0;
+
+    fit_dm_hash_init(&ctx);
+    for (cntr = 0; cntr < pdata->length; cntr += len)
+    {
+        len = pdata->length - cntr;
+        if (len > FIT_DM_CIPHER_BLOCK_SIZE)
+        {
+            len = FIT_DM_CIPHER_BLOCK_SIZE;
+        }
+        fitptr_read_block(tempmsg, pdata->data + cntr, len, pdata);
+        fit_dm_hash_update(&ctx, tempmsg, len);
+    }
+    fit_dm_hash_final(&ctx, dmhash);
+
+    return FIT_STATUS_OK;
+}
@@ -16,13 +16,402 @@
 #include FIT_CONFIG_FILE
 #endif
 
-#include "fit_alloc.h"
 #include "fit_parser.h"
 #include "fit_internal.h"
 #include "fit_debug.h"
+#include "fit_mem_read.h"
+
+/* Types ********************************************************************/
+
+/* State of fit_licenf_get_license_info while walking license data. */
+typedef struct fit_license_info_state {
+    /** Structure to be filled in.*/
+    fit_license_info_t  *info;
+    /** FIT_FALSE while counting records; FIT_TRUE while filling arena.*/
+    fit_boolean_t       fill;
+    /** Number of records found by counting pass (limits filling pass).*/
+    uint16_t            max_prodparts;
+    uint16_t            max_features;
+    uint16_t            max_counters;
+    /** Current product part and counter; NULL if none.*/
+    fit_lic_prodpart_t  *prodpart;
+    fit_lic_counter_t   *counter;
+    /** Array element numbers of current product part and counter.*/
+    uint16_t            partelem;
+    uint16_t            counterelem;
+    /** Records written to while counting (arena is not there yet).*/
+    fit_lic_prodpart_t  scratchpart;
+    fit_lic_counter_t   scratchcounter;
+} fit_license_info_state_t;
 
 /* Function Definitions *****************************************************/
 
+/**
+ *
+ * fit_info_get_uint
+ *
+ * Returns integer field value; either stored in field header (length is
+ * FIT_PFIELD_SIZE) or in data part (length is FIT_PARRAY_SIZE).
+ *
+ */
+static uint32_t fit_info_get_uint(fit_pointer_t *pdata, uint16_t length)
+{
+    if (length == FIT_PFIELD_SIZE)
+        return (uint32_t)(read_word(pdata->data, pdata->read_byte)/2 - 1);
+    else if (length == FIT_PARRAY_SIZE)
+        return read_dword(pdata->data, pdata->read_byte);
+
+    return 0;
+}
+
+/**
+ *
+ * fit_info_new_prodpart
+ *
+ * Starts new product part record.
+ *
+ */
+static fit_status_t fit_info_new_prodpart(fit_license_info_state_t *state)
+{
+    fit_license_info_t *info = state->info;
+
+    if (state->fill) {
+        if (info->num_prodparts >= state->max_prodparts)
+            return FIT_STATUS_INVALID_V2C;
+        state->prodpart = &info->prodparts[info->num_prodparts];
+    } else {
+        if (info->num_prodparts == 0xFFFF)
+            return FIT_STATUS_INVALID_V2C;
+        state->prodpart = &state->scratchpart;
+    }
+    info->num_prodparts++;
+
+    fit_memset((uint8_t *)state->prodpart, 0, sizeof(fit_lic_prodpart_t));
+    state->prodpart->firstfeat = info->num_features;
+    state->prodpart->firstcounter = info->num_counters;
+    state->counter = NULL;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_info_new_counter
+ *
+ * Starts new counter record in current product part.
+ *
+ */
+static fit_status_t fit_info_new_counter(fit_license_info_state_t *state)
+{
+    fit_license_info_t *info = state->info;
+
+    if (state->fill) {
+        if (info->num_counters >= state->max_counters)
+            return FIT_STATUS_INVALID_V2C;
+        state->counter = &info->counters[info->num_counters];
+    } else {
+        if (info->num_counters == 0xFFFF)
+            return FIT_STATUS_INVALID_V2C;
+        state->counter = &state->scratchcounter;
+    }
+    info->num_counters++;
+    state->prodpart->numcounters++;
+
+    fit_memset((uint8_t *)state->counter, 0, sizeof(fit_lic_counter_t));
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_license_info_cb
+ *
+ * Get info callback of fit_licenf_get_license_info. Stores every field of license
+ * into flat license structure.
+ *
+ */
+static fit_status_t fit_license_info_cb(const fit_info_cursor_t *cursor,
+                                        fit_pointer_t *pdata,
+                                        uint16_t length,
+                                        fit_boolean_t *stop_parse,
+                                        void *context)
+{
+    fit_license_info_state_t *state = (fit_license_info_state_t *)context;
+    fit_license_info_t *info        = state->info;
+    fit_status_t status             = FIT_STATUS_OK;
+    uint8_t tagid                   = cursor->tagid;
+    fit_pointer_t fitptr;
+
+    *stop_parse = FIT_FALSE;
+
+    /* First field of next product part or counter array element starts new record.*/
+    if (cursor->level >= FIT_STRUCT_PRODUCT_PART_LEVEL &&
+        cursor->parent[FIT_STRUCT_PRODUCT_PART_LEVEL] == FIT_PRODUCT_PART_ARRAY_TAG_ID &&
+        (state->prodpart == NULL ||
+         cursor->element[FIT_STRUCT_PRODUCT_PART_LEVEL] != state->partelem)) {
+        status = fit_info_new_prodpart(state);
+        if (status != FIT_STATUS_OK)
+            return status;
+        state->partelem = cursor->element[FIT_STRUCT_PRODUCT_PART_LEVEL];
+    }
+    if (cursor->level >= FIT_STRUCT_COUNTER_LEVEL &&
+        cursor->parent[FIT_STRUCT_COUNTER_LEVEL] == FIT_COUNTER_ARRAY_TAG_ID &&
+        state->prodpart != NULL &&
+        (state->counter == NULL ||
+         cursor->element[FIT_STRUCT_COUNTER_LEVEL] != state->counterelem)) {
+        status = fit_info_new_counter(state);
+        if (status != FIT_STATUS_OK)
+            return status;
+        state->counterelem = cursor->element[FIT_STRUCT_COUNTER_LEVEL];
+    }
+
+    switch (tagid) {
+
+    case FIT_ALGORITHM_TAG_ID:
+        info->algid = (uint16_t)fit_info_get_uint(pdata, length);
+        break;
+
+    case FIT_LICGEN_VERSION_TAG_ID:
+        info->header.licgen_version = (uint16_t)fit_info_get_uint(pdata, length);
+        break;
+
+    case FIT_LM_VERSION_TAG_ID:
+        info->header.lm_version = (uint16_t)fit_info_get_uint(pdata, length);
+        break;
+
+    case FIT_UID_TAG_ID:
+        fit_memset((uint8_t *)&fitptr, 0, sizeof(fit_pointer_t));
+        fitptr.data = pdata->data;
+        fitptr.length = (length < FIT_UID_LEN) ? length : FIT_UID_LEN;
+        fitptr.read_byte = pdata->read_byte;
+        fitptr_memcpy(info->header.uid, &fitptr);
+        break;
+
+#ifdef FIT_USE_NODE_LOCKING
+    case FIT_FP_TAG_ID:
+        fit_get_fingerprint(pdata, &(info->header.licensefp));
+        break;
+#endif /* ifdef FIT_USE_NODE_LOCKING */
+
+    case FIT_ID_LC_TAG_ID:
+        info->containerid = fit_info_get_uint(pdata, length);
+        break;
+
+    case FIT_VENDOR_ID_TAG_ID:
+        info->vendorid = fit_info_get_uint(pdata, length);
+        break;
+
+    case FIT_PRODUCT_TAG_ID:
+        /* Product parts of next product are numbered from 0 again.*/
+        state->prodpart = NULL;
+        state->counter = NULL;
+        break;
+
+    case FIT_PRODUCT_ID_TAG_ID:
+        info->prodid = fit_info_get_uint(pdata, length);
+        break;
+
+    case FIT_VERSION_REGEX_TAG_ID:
+        fit_memset((uint8_t *)&fitptr, 0, sizeof(fit_pointer_t));
+        fitptr.data = pdata->data;
+        fitptr.length = (length < FIT_VER_REGEX_LEN) ? length : FIT_VER_REGEX_LEN - 1;
+        fitptr.read_byte = pdata->read_byte;
+        fit_memset((uint8_t *)info->verregex, 0, FIT_VER_REGEX_LEN);
+        fitptr_memcpy((uint8_t *)info->verregex, &fitptr);
+        break;
+
+    case FIT_PRODUCT_PART_ID_TAG_ID:
+        if (state->prodpart == NULL)
+            return FIT_STATUS_INVALID_V2C;
+        state->prodpart->partid = fit_info_get_uint(pdata, length);
+        break;
+
+    case FIT_FEATURE_TAG_ID:
+        if (state->prodpart == NULL)
+            return FIT_STATUS_INVALID_V2C;
+        if (state->fill) {
+            if (info->num_features >= state->max_features)
+                return FIT_STATUS_INVALID_V2C;
+            info->features[info->num_features] = fit_info_get_uint(pdata, length);
+        } else if (info->num_features == 0xFFFF) {
+            return FIT_STATUS_INVALID_V2C;
+        }
+        info->num_features++;
+        state->prodpart->numfeat++;
+        break;
+
+    case FIT_PERPETUAL_TAG_ID:
+        if (state->prodpart == NULL)
+            return FIT_STATUS_INVALID_V2C;
+        state->prodpart->perpetual = (uint8_t)fit_info_get_uint(pdata, length);
+        state->prodpart->lictype = FIT_LIC_PERPETUAL;
+        break;
+
+    case FIT_START_DATE_TAG_ID:
+        if (state->prodpart == NULL)
+            return FIT_STATUS_INVALID_V2C;
+        state->prodpart->startdate = fit_info_get_uint(pdata, length);
+        break;
+
+    case FIT_END_DATE_TAG_ID:
+        if (state->prodpart == NULL)
+            return FIT_STATUS_INVALID_V2C;
+        state->prodpart->enddate = fit_info_get_uint(pdata, length);
+        state->prodpart->lictype = FIT_LIC_EXPIRATION_BASED;
+        break;
+
+    case FIT_DURATION_FROM_FIRST_USE_TAG_ID:
+        if (state->prodpart == NULL)
+            return FIT_STATUS_INVALID_V2C;
+        state->prodpart->lictype = FIT_LIC_TIME_BASED;
+        break;
+
+    case FIT_COUNTER_TAG_ID:
+    case FIT_LIMIT_TAG_ID:
+    case FIT_SOFT_LIMIT_TAG_ID:
+    case FIT_IS_FIELD_TAG_ID:
+        if (state->counter == NULL)
+            return FIT_STATUS_INVALID_V2C;
+        if (tagid == FIT_COUNTER_TAG_ID)
+            state->counter->counterid = fit_info_get_uint(pdata, length);
+        else if (tagid == FIT_LIMIT_TAG_ID)
+            state->counter->limit = fit_info_get_uint(pdata, length);
+        else if (tagid == FIT_SOFT_LIMIT_TAG_ID)
+            state->counter->softlimit = fit_info_get_uint(pdata, length);
+        else
+            state->counter->isfield = (uint8_t)fit_info_get_uint(pdata, length);
+        break;
+
+    default:
+        break;
+    }
+
+    return status;
+}
+
+/**
+ *
+ * fit_license_info_pass
+ *
+ * Parses license once, calling fit_license_info_cb for every field.
+ *
+ */
+static fit_status_t fit_license_info_pass(fit_pointer_t *license,
+                                          fit_license_info_state_t *state)
+{
+    fit_context_data_t getinfo;
+
+    fit_memset((uint8_t *)&getinfo, 0, sizeof(fit_context_data_t));
+    getinfo.operation = (uint8_t)FIT_OP_GET_LICENSE_INFO_DATA;
+    getinfo.parserdata.getinfodata.cursor_fn = fit_license_info_cb;
+    getinfo.parserdata.getinfodata.get_info_data = state;
+
+    state->info->num_prodparts = 0;
+    state->info->num_features = 0;
+    state->info->num_counters = 0;
+    state->prodpart = NULL;
+    state->counter = NULL;
+
+    return fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license, (void *)&getinfo);
+}
+
+/**
+ *
+ * \skip fit_licenf_get_license_info
+ *
+ * This function decodes license binary into flat structure. Product parts, features
+ * and counters are stored in arrays carved from caller provided arena, so no memory
+ * is allocated.
+ *
+ * @param IN    license     \n Start address of the license in binary format.
+ *
+ * @param OUT   info        \n On return contains decoded license data.
+ *
+ * @param IN    arena       \n Buffer for product parts, features and counters. Can be
+ *                             NULL to query the needed size. If not dword aligned,
+ *                             up to 3 more bytes are needed.
+ *
+ * @param IO    arenasize   \n On input size of arena in bytes; on return number of
+ *                             bytes needed.
+ *
+ * @return FIT_STATUS_OK on success; FIT_STATUS_INSUFFICIENT_MEMORY if arena is too
+ *         small; otherwise appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_get_license_info(fit_pointer_t *license,
+                                         fit_license_info_t *info,
+                                         void *arena,
+                                         uint16_t *arenasize)
+{
+    fit_license_info_state_t state;
+    fit_status_t status = FIT_STATUS_UNKNOWN_ERROR;
+    uint32_t needed     = 0;
+    uint8_t *start      = NULL;
+
+    DBG(FIT_TRACE_INFO, "[fit_licenf_get_license_info]: pdata=0x%p \n", license);
+
+    /* Validate parameters */
+    if (license == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+    if (info == NULL)
+        return FIT_STATUS_INVALID_PARAM_2;
+    if (arenasize == NULL)
+        return FIT_STATUS_INVALID_PARAM_4;
+
+    fit_memset((uint8_t *)info, 0, sizeof(fit_license_info_t));
+    fit_memset((uint8_t *)&state, 0, sizeof(fit_license_info_state_t));
+    state.info = info;
+
+    /* First pass: count product parts, features and counters. */
+    state.fill = FIT_FALSE;
+    status = fit_license_info_pass(license, &state);
+    if (status != FIT_STATUS_OK)
+        goto bail;
+
+    state.max_prodparts = info->num_prodparts;
+    state.max_features = info->num_features;
+    state.max_counters = info->num_counters;
+
+    /* Arena layout: product parts, counters, features (all dword aligned). */
+    start = (uint8_t *)arena;
+    if (((uintptr_t)start & (sizeof(uint32_t) - 1)) != 0)
+        needed = sizeof(uint32_t) - ((uintptr_t)start & (sizeof(uint32_t) - 1));
+    needed += (uint32_t)state.max_prodparts * sizeof(fit_lic_prodpart_t);
+    needed += (uint32_t)state.max_counters * sizeof(fit_lic_counter_t);
+    needed += (uint32_t)state.max_features * sizeof(uint32_t);
+
+    if (arena == NULL || needed > *arenasize) {
+        *arenasize = (needed > 0xFFFF) ? 0xFFFF : (uint16_t)needed;
+        status = FIT_STATUS_INSUFFICIENT_MEMORY;
+        goto bail;
+    }
+    *arenasize = (uint16_t)needed;
+
+    if (((uintptr_t)start & (sizeof(uint32_t) - 1)) != 0)
+        start += sizeof(uint32_t) - ((uintptr_t)start & (sizeof(uint32_t) - 1));
+    info->prodparts = (fit_lic_prodpart_t *)start;
+    start += state.max_prodparts * sizeof(fit_lic_prodpart_t);
+    info->counters = (fit_lic_counter_t *)start;
+    start += state.max_counters * sizeof(fit_lic_counter_t);
+    info->features = (uint32_t *)start;
+
+    /* Second pass: fill in the arrays. */
+    state.fill = FIT_TRUE;
+    status = fit_license_info_pass(license, &state);
+    if (status == FIT_STATUS_OK)
+        return FIT_STATUS_OK;
+
+bail:
+    DBG(FIT_TRACE_ERROR, "[fit_licenf_get_license_info]: return with error code %d \n", status);
+    info->num_prodparts = 0;
+    info->num_features = 0;
+    info->num_counters = 0;
+    info->prodparts = NULL;
+    info->features = NULL;
+    info->counters = NULL;
+    return status;
+}
+
 /**
  *
  * \skip fit_licenf_get_info
@@ -49,7 +438,7 @@ fit_status_t fit_licenf_get_info(fit_pointer_t *license,
                                  fit_get_info_callback callback_fn,
                                  void *context)
 {
-    fit_context_data_t  *getinfo;
+    fit_context_data_t  getinfo;
     fit_status_t         status = FIT_STATUS_UNKNOWN_ERROR;
 
     DBG(FIT_TRACE_INFO, "[fit_licenf_get_info]: pdata=0x%p \n", license);
@@ -62,15 +451,14 @@ fit_status_t fit_licenf_get_info(fit_pointer_t *license,
         return FIT_STATUS_INVALID_PARAM_3;
     }
 
-    getinfo = fit_calloc(1, sizeof(fit_context_data_t));
     /* Initialize context for get info operation. */
-    getinfo->operation = (uint8_t)FIT_OP_GET_LICENSE_INFO_DATA;
-    getinfo->parserdata.getinfodata.callback_fn = callback_fn;
-    getinfo->parserdata.getinfodata.get_info_data = context;
+    fit_memset((uint8_t *)&getinfo, 0, sizeof(fit_context_data_t));
+    getinfo.operation = (uint8_t)FIT_OP_GET_LICENSE_INFO_DATA;
+    getinfo.parserdata.getinfodata.callback_fn = callback_fn;
+    getinfo.parserdata.getinfodata.get_info_data = context;
 
     /* Parse license data and call the user provided callback fn for each field. */
-    status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license, (void *)getinfo);
-    fit_free(getinfo);
+    status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license, (void *)&getinfo);
 
     if (status != FIT_STATUS_OK) {
         DBG(FIT_TRACE_ERROR, "[fit_licenf_get_info]: return with error code %d \n", status);
@@ -79,3 +467,55 @@ fit_status_t fit_licenf_get_info(fit_pointer_t *license,
 
     return FIT_STATUS_OK;
 }
+
+/**
+ *
+ * \skip fit_licenf_get_info_cursor
+ *
+ * Same as fit_licenf_get_info, but callback function also receives position of
+ * every field (see fit_info_cursor_t). Cursor lives in parser context on stack of
+ * this call, so several licenses can be traversed at the same time.
+ *
+ * @param IN    license     \n Start address of the license in binary format.
+ *
+ * @param IN    callback_fn     \n User provided callback function to be called by fit
+ *                                 core.
+ *
+ * @param IN    context     \n Pointer to user provided data structure.
+ *
+ * @return FIT_STATUS_OK on success; otherwise appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_get_info_cursor(fit_pointer_t *license,
+                                        fit_get_info_cursor_callback callback_fn,
+                                        void *context)
+{
+    fit_context_data_t  getinfo;
+    fit_status_t         status = FIT_STATUS_UNKNOWN_ERROR;
+
+    DBG(FIT_TRACE_INFO, "[fit_licenf_get_info_cursor]: pdata=0x%p \n", license);
+
+    /* Validate parameters */
+    if (callback_fn == NULL) {
+        return FIT_STATUS_INVALID_PARAM_2;
+    }
+    if (context == NULL) {
+        return FIT_STATUS_INVALID_PARAM_3;
+    }
+
+    /* Initialize context (and cursor) for get info operation. */
+    fit_memset((uint8_t *)&getinfo, 0, sizeof(fit_context_data_t));
+    getinfo.operation = (uint8_t)FIT_OP_GET_LICENSE_INFO_DATA;
+    getinfo.parserdata.getinfodata.cursor_fn = callback_fn;
+    getinfo.parserdata.getinfodata.get_info_data = context;
+
+    /* Parse license data and call the user provided callback fn for each field. */
+    status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license, (void *)&getinfo);
+
+    if (status != FIT_STATUS_OK) {
+        DBG(FIT_TRACE_ERROR, "[fit_licenf_get_info_cursor]: return with error code %d \n", status);
+        return status;
+    }
+
+    return FIT_STATUS_OK;
+}
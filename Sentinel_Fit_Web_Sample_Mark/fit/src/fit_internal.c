@@ -125,12 +125,16 @@ key_found:
  * @param IN    check_cache \n FIT_TRUE if signing verification is already done; FIT_FALSE
  *                             otherwise.
  *
+ * @param IN    licindex    \n Pointer to license index for license passed in. NULL if
+ *                             license binary is to be parsed for getting field data.
+ *
  * @return FIT_STATUS_OK on success; otherwise appropriate error code.
  *
  */
 fit_status_t fit_verify_license(fit_pointer_t *license,
                                 fit_key_array_t *keys,
-                                fit_boolean_t check_cache)
+                                fit_boolean_t check_cache,
+                                fit_license_index_t *licindex)
 {
     fit_status_t status = FIT_STATUS_UNKNOWN_ERROR;
     uint32_t signalgid  = 0;
@@ -138,9 +142,16 @@ fit_status_t fit_verify_license(fit_pointer_t *license,
 
     DBG(FIT_TRACE_INFO, "[fit_verify_license]: Entry");
     /* Get the algorithm id used for signing the license from the license binary */
-    status = fit_get_license_sign_algid(license, &signalgid);
-    if (status != FIT_STATUS_OK)
-        return status;
+    if (licindex != NULL)
+    {
+        signalgid = licindex->algid;
+    }
+    else
+    {
+        status = fit_get_license_sign_algid(license, &signalgid);
+        if (status != FIT_STATUS_OK)
+            return status;
+    }
 
     /* Get key data corresponding to algid used in signing license binary */
     fit_memset((uint8_t *)&key_data, 0, sizeof(fit_pointer_t));
@@ -152,7 +163,7 @@ fit_status_t fit_verify_license(fit_pointer_t *license,
     {
 #ifdef FIT_USE_RSA_SIGNING
         /* Verify the license string against RSA signing and node locking */
-        status = fit_verify_rsa_signature(license, &key_data, check_cache);
+        status = fit_verify_rsa_signature(license, &key_data, check_cache, licindex);
         if (status != FIT_STATUS_OK)
             return status;
 #else
@@ -163,7 +174,7 @@ fit_status_t fit_verify_license(fit_pointer_t *license,
     {
 #ifdef FIT_USE_AES_SIGNING
         /* Verify the license string against AES signing and node locking */
-        status = fit_validate_omac_signature(license, &key_data);
+        status = fit_validate_omac_signature(license, &key_data, licindex);
         if (status != FIT_STATUS_OK)
             return status;
 #else
@@ -175,6 +186,76 @@ fit_status_t fit_verify_license(fit_pointer_t *license,
     return status;
 }
 
+/**
+ *
+ * \skip fit_license_index_ok
+ *
+ * This function is used to check whether license index passed in is built for
+ * license data passed in. Besides license address, length of license data and
+ * checksum of leading signature bytes must match, so that a different license
+ * written to same location is not parsed through stale index. Any other change of
+ * license data is caught by signature verification.
+ *
+ * @param IN    license     \n Pointer to fit_pointer_t structure containing license
+ *                             data.
+ *
+ * @param IN    licindex    \n Pointer to license index.
+ *
+ * @return FIT_TRUE if license index can be used for license data; FIT_FALSE otherwise.
+ *
+ */
+fit_boolean_t fit_license_index_ok(fit_pointer_t *license,
+                                   fit_license_index_t *licindex)
+{
+    if (licindex == NULL || licindex->valid != FIT_TRUE)
+        return FIT_FALSE;
+
+    if (licindex->license != license->data ||
+        licindex->datalength != license->length)
+    {
+        return FIT_FALSE;
+    }
+
+    if (fit_license_index_checksum(license, licindex) != licindex->checksum)
+        return FIT_FALSE;
+
+    return FIT_TRUE;
+}
+
+/**
+ *
+ * \skip fit_license_index_checksum
+ *
+ * This function computes checksum (FNV-1a) of first FIT_LIC_INDEX_CHECK_SIZE bytes
+ * of signature data recorded in license index. Signature of every license is
+ * different, so checksum identifies license data cheaply.
+ *
+ * @param IN    license     \n Pointer to fit_pointer_t structure containing license
+ *                             data.
+ *
+ * @param IN    licindex    \n Pointer to license index.
+ *
+ * @return checksum of leading signature bytes.
+ *
+ */
+uint32_t fit_license_index_checksum(fit_pointer_t *license,
+                                    fit_license_index_t *licindex)
+{
+    uint8_t buf[FIT_LIC_INDEX_CHECK_SIZE];
+    uint32_t checksum = 0x811C9DC5;
+    uint16_t len = licindex->siglength;
+    uint16_t cntr = 0;
+
+    if (len > sizeof(buf))
+        len = sizeof(buf);
+
+    fitptr_read_block(buf, licindex->signature, len, license);
+    for (cntr = 0; cntr < len; cntr++)
+        checksum = (checksum ^ buf[cntr]) * 0x01000193;
+
+    return checksum;
+}
+
 /**
  *
  * \skip fit_memcpy
@@ -213,10 +294,7 @@ void fit_memcpy(uint8_t *dst, uint8_t *src, uint16_t srclen)
  */
 void fitptr_memcpy(uint8_t *dst, fit_pointer_t *src)
 {
-    uint16_t cntr = 0;
-
-    for (cntr = 0; cntr < src->length; ++cntr)
-        *dst++ = src->read_byte(src->data + cntr);
+    fitptr_read_block(dst, src->data, src->length, src);
 }
 
 /**
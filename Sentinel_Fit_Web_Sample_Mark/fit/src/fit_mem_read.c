@@ -17,6 +17,14 @@
 #endif
 
 #include "fit_mem_read.h"
+#include "fit_internal.h"
+#include "fit_api.h"
+
+/* Global Data **************************************************************/
+
+/** Block read functions registered by fit_licenf_register_read_block.*/
+static fit_read_byte_callback_t fit_rb_read_byte[FIT_MAX_READ_BLOCK_CALLBACKS];
+static fit_read_block_callback_t fit_rb_read_block[FIT_MAX_READ_BLOCK_CALLBACKS];
 
 /* Function Definitions *****************************************************/
 
@@ -91,3 +99,160 @@ uint8_t fit_read_ram_u8 (const uint8_t *datap)
 {
     return (uint8_t)*datap;
 }
+
+/**
+ *
+ * \skip fit_licenf_register_read_block
+ *
+ * This function registers block read function for read byte callback passed in.
+ * Registering same read byte callback again replaces its block read function;
+ * NULL read_block removes it.
+ *
+ * @param IN    read_byte   \n Read byte callback used in fit_pointer_t or
+ *                             fit_key_array_t.
+ *
+ * @param IN    read_block  \n Function reading len bytes of same memory.
+ *
+ * @return FIT_STATUS_OK on success; FIT_STATUS_INSUFFICIENT_MEMORY if
+ *         FIT_MAX_READ_BLOCK_CALLBACKS functions are registered already; otherwise
+ *         appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_register_read_block(fit_read_byte_callback_t read_byte,
+                                            fit_read_block_callback_t read_block)
+{
+    uint8_t i = 0;
+    uint8_t freeslot = FIT_MAX_READ_BLOCK_CALLBACKS;
+
+    if (read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+
+    for (i = 0; i < FIT_MAX_READ_BLOCK_CALLBACKS; ++i)
+    {
+        if (fit_rb_read_byte[i] == read_byte)
+        {
+            freeslot = i;
+            break;
+        }
+        if (fit_rb_read_byte[i] == NULL && freeslot == FIT_MAX_READ_BLOCK_CALLBACKS)
+            freeslot = i;
+    }
+
+    if (read_block == NULL)
+    {
+        if (freeslot < FIT_MAX_READ_BLOCK_CALLBACKS && fit_rb_read_byte[freeslot] == read_byte)
+        {
+            fit_rb_read_byte[freeslot] = NULL;
+            fit_rb_read_block[freeslot] = NULL;
+        }
+        return FIT_STATUS_OK;
+    }
+
+    if (freeslot == FIT_MAX_READ_BLOCK_CALLBACKS)
+        return FIT_STATUS_INSUFFICIENT_MEMORY;
+
+    fit_rb_read_byte[freeslot] = read_byte;
+    fit_rb_read_block[freeslot] = read_block;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_get_read_block
+ *
+ * Returns block read function registered for read byte function passed in, or
+ * NULL if none is registered (data is then read byte by byte).
+ *
+ * @param   clbk_read_byte --> function pointer to read byte.
+ *
+ */
+static fit_read_block_callback_t fit_get_read_block(fit_read_byte_callback_t clbk_read_byte)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < FIT_MAX_READ_BLOCK_CALLBACKS; ++i)
+    {
+        if (fit_rb_read_byte[i] == clbk_read_byte)
+            return fit_rb_read_block[i];
+    }
+
+    return NULL;
+}
+
+/**
+ *
+ * fitptr_read_block
+ *
+ * Reads len bytes of data from address passed in. Uses block read function
+ * registered for read_byte callback of pdata (see fit_licenf_register_read_block);
+ * otherwise read_byte callback is called for every byte.
+ *
+ * @param   dst --> pointer to destination buffer.
+ * @param   address --> pointer to data.
+ * @param   len --> number of bytes to read.
+ * @param   pdata --> fit_pointer_t containing read callback functions.
+ *
+ */
+void fitptr_read_block(uint8_t *dst,
+                       const uint8_t *address,
+                       uint16_t len,
+                       const fit_pointer_t *pdata)
+{
+    fit_read_block_callback_t read_block = fit_get_read_block(pdata->read_byte);
+    uint16_t cntr = 0;
+
+    if (read_block != NULL)
+    {
+        read_block(dst, address, len);
+        return;
+    }
+
+    for (cntr = 0; cntr < len; ++cntr)
+        *dst++ = pdata->read_byte(address + cntr);
+}
+
+/**
+ *
+ * fitptr_read_word
+ *
+ * Reads 2 byte data from address passed in using read callbacks of pdata.
+ *
+ * @param   address --> pointer to data.
+ * @param   pdata --> fit_pointer_t containing read callback functions.
+ *
+ */
+uint16_t fitptr_read_word(const uint8_t *address, const fit_pointer_t *pdata)
+{
+    fit_read_block_callback_t read_block = fit_get_read_block(pdata->read_byte);
+    uint8_t x[sizeof(uint16_t)];
+
+    if (read_block == NULL)
+        return read_word(address, pdata->read_byte);
+
+    read_block(x, address, sizeof(x));
+    return (uint16_t)(x[0] | ((uint16_t)x[1] << 8));
+}
+
+/**
+ *
+ * fitptr_read_dword
+ *
+ * Reads 4 byte data (1 dword) from address passed in using read callbacks of pdata.
+ *
+ * @param   address --> pointer to data.
+ * @param   pdata --> fit_pointer_t containing read callback functions.
+ *
+ */
+uint32_t fitptr_read_dword(const uint8_t *address, const fit_pointer_t *pdata)
+{
+    fit_read_block_callback_t read_block = fit_get_read_block(pdata->read_byte);
+    uint8_t x[sizeof(uint32_t)];
+
+    if (read_block == NULL)
+        return read_dword(address, pdata->read_byte);
+
+    read_block(x, address, sizeof(x));
+    return (uint32_t)x[0] | ((uint32_t)x[1] << 8) | ((uint32_t)x[2] << 16) |
+        ((uint32_t)x[3] << 24);
+}
@@ -43,10 +43,14 @@
  *                             data. To access the license data in different types of
  *                             memory (FLASH, E2, RAM), fit_pointer_t is used.
  *
+ * @param IN    licindex    \n Pointer to license index for license passed in. NULL if
+ *                             license binary is to be parsed for getting field data.
+ *
  * @return FIT_STATUS_OK on success; otherwise appropriate error code.
  *
  */
-fit_status_t fit_validate_fp_data(fit_pointer_t *license)
+fit_status_t fit_validate_fp_data(fit_pointer_t *license,
+                                  fit_license_index_t *licindex)
 {
     fit_status_t status             = FIT_STATUS_UNKNOWN_ERROR;
     fit_context_data_t context;
@@ -70,13 +74,27 @@ fit_status_t fit_validate_fp_data(fit_pointer_t *license)
     fitptr.read_byte = license->read_byte;
 
     /* Check the presence of fingerprint in the license data.*/
-    context.level = FIT_STRUCT_HEADER_LEVEL;
-    context.index = FIT_FINGERPRINT_FIELD;
-    context.operation = (uint8_t)FIT_OP_GET_DATA_ADDRESS;
-    context.status = FIT_STATUS_OK;
-    status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license, &context);
-    if (status != FIT_STATUS_OK)
-        goto bail;
+    if (licindex != NULL)
+    {
+        /* Fingerprint address (if present) is already known from license index.*/
+        context.parserdata.addr = licindex->fingerprint;
+        if (licindex->fingerprint != NULL)
+        {
+            context.parserstatus = FIT_INFO_STOP_PARSE;
+            context.status = FIT_STATUS_LIC_FIELD_PRESENT;
+        }
+        status = FIT_STATUS_OK;
+    }
+    else
+    {
+        context.level = FIT_STRUCT_HEADER_LEVEL;
+        context.index = FIT_FINGERPRINT_FIELD;
+        context.operation = (uint8_t)FIT_OP_GET_DATA_ADDRESS;
+        context.status = FIT_STATUS_OK;
+        status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license, &context);
+        if (status != FIT_STATUS_OK)
+            goto bail;
+    }
 
     if (context.parserstatus == FIT_INFO_STOP_PARSE && context.status == FIT_STATUS_LIC_FIELD_PRESENT)
     {
@@ -173,9 +191,9 @@ void fit_get_fingerprint(fit_pointer_t *fpdata, fit_fingerprint_t *fpstruct)
 
     fit_memset((uint8_t *)&fitptr, 0, sizeof(fit_pointer_t));
     /* Get first four bytes of fingerprint data. This will represent magic id.*/
-    fpstruct->magic = read_dword(fpdata->data, fpdata->read_byte);
+    fpstruct->magic = fitptr_read_dword(fpdata->data, fpdata);
     /* Read algorith id value.*/
-    fpstruct->algid = (uint8_t)read_dword(fpdata->data + sizeof(uint32_t), fpdata->read_byte);
+    fpstruct->algid = (uint8_t)fitptr_read_dword(fpdata->data + sizeof(uint32_t), fpdata);
 
     /* Get device id hash value*/
     fitptr.data = fpdata->data+sizeof(uint32_t)+sizeof(uint32_t);
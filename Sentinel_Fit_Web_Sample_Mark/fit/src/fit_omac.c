@@ -32,88 +32,119 @@ void done(uint8_t *skey)
     return;
 }
 
+#ifdef FIT_USE_AES_KEY_CACHE
+/** Expanded AES key and OMAC subkeys kept between OMAC calculations.*/
+static omac_key_t fit_omac_key;
+/** FIT_TRUE if fit_omac_key contains expanded AES key.*/
+static fit_boolean_t fit_omac_key_ok = FIT_FALSE;
+#endif /* #ifdef FIT_USE_AES_KEY_CACHE */
+
 /**
  *
- * \skip fit_omac_init
+ * \skip fit_omac_xor_block
  *
- * Initialize an OMAC state (One-key Message Authentication Code)
- * http://en.wikipedia.org/wiki/OMAC_%28cryptography%29
+ * XOR one OMAC block into another, 32 bits at a time.
  *
- * @param IN    omac    \n The OMAC state to initialize.
+ * @param IO    dst     \n Block that gets XORed with src.
+ *
+ * @param IN    src     \n Block to XOR in.
  *
- * @param IN    aes     \n AES state.
+ */
+static void fit_omac_xor_block(uint32_t *dst, const uint32_t *src)
+{
+    dst[0] ^= src[0];
+    dst[1] ^= src[1];
+    dst[2] ^= src[2];
+    dst[3] ^= src[3];
+}
+
+/**
  *
- * @param IN    cipher  \n The index of the desired cipher
+ * \skip fit_omac_key_setup
+ *
+ * Expand AES key and compute OMAC subkeys L.u and L.u^2 (One-key Message
+ * Authentication Code) http://en.wikipedia.org/wiki/OMAC_%28cryptography%29
+ *
+ * @param OUT   okey    \n The OMAC key to initialize.
  *
  * @param IN    key     \n Start address of the signing key in binary format.
  *
  * @return FIT_STATUS_OK on success; otherwise appropriate error code.
  *
  */
-static fit_status_t fit_omac_init(omac_state_t *omac,
-                           fit_aes_t *aes,
-                           uint16_t blocklength,
-                           const fit_pointer_t *key)
+static fit_status_t fit_omac_key_setup(omac_key_t *okey, const fit_pointer_t *key)
 {
     fit_status_t result = FIT_STATUS_UNKNOWN_ERROR;
-    uint8_t x = 0, y = 0, len = 0;
-    uint16_t mask = 0, msb = 0;
+    uint8_t x = 0, y = 0, msb = 0;
+    uint8_t *Lu = NULL;
 
-    if(key->read_byte == NULL || omac == NULL)
-        return FIT_STATUS_INVALID_PARAM;
-
-    /* now setup the system */
-    switch (blocklength)
+    /* round keys of AES-128 only fit in okey->key */
+    if (key->length != FIT_AES_128_KEY_LENGTH)
     {
-        case 8:
-            mask = 0x1B;
-            len = 8;
-            break;
-
-        case 16:
-            mask = 0x87;
-            len = 16;
-            break;
-
-        default:
-            return FIT_STATUS_INVALID_PARAM;
+        DBG(FIT_TRACE_ERROR, "fit_omac_key_setup - Invalid Keysize %d", key->length);
+        return FIT_STATUS_INVALID_KEYSIZE;
     }
 
-    if((result = fit_aes_setup(aes, key, omac->key)) != FIT_STATUS_OK)
+    if((result = fit_aes_setup(&okey->aes, key, okey->key)) != FIT_STATUS_OK)
     {
         return result;
     }
 
-    fit_memset((uint8_t *)omac->Lu[0], 0, blocklength);
+    fit_memset((uint8_t *)okey->Lu[0], 0, OMAC_BLOCK_LENGTH);
 
-    fit_aes_encrypt(aes, omac->Lu[0], omac->Lu[0], omac->key, (uint8_t*)omac->state);
+    fit_aes_encrypt(&okey->aes, (uint8_t *)okey->Lu[0], (uint8_t *)okey->Lu[0],
+        okey->key, (uint8_t *)okey->Lu[0]);
 
     /* now do the mults, whoopy! */
     for (x = 0; x < 2; x++)
     {
+        Lu = (uint8_t *)okey->Lu[x];
+
         /* if msb(L * u^(x+1)) = 0 then just shift, otherwise shift and xor constant mask */
-        msb = omac->Lu[x][0] >> 7;
+        msb = Lu[0] >> 7;
 
         /* shift left */
-        for (y = 0; y < (len - 1); y++)
+        for (y = 0; y < (OMAC_BLOCK_LENGTH - 1); y++)
         {
-            omac->Lu[x][y] = ((omac->Lu[x][y] << 1) | (omac->Lu[x][y + 1] >> 7)) & 255;
+            Lu[y] = ((Lu[y] << 1) | (Lu[y + 1] >> 7)) & 255;
         }
-        omac->Lu[x][len - 1] = ((omac->Lu[x][len - 1] << 1) ^ (msb ? mask : 0)) & 255;
+        Lu[OMAC_BLOCK_LENGTH - 1] = ((Lu[OMAC_BLOCK_LENGTH - 1] << 1) ^ (msb ? 0x87 : 0)) & 255;
 
         /* copy up as require */
         if (x == 0)
         {
-            fit_memcpy(omac->Lu[1], omac->Lu[0], sizeof(omac->Lu[0]));
+            fit_memcpy((uint8_t *)okey->Lu[1], (uint8_t *)okey->Lu[0], sizeof(okey->Lu[0]));
         }
     }
 
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * \skip fit_omac_init
+ *
+ * Initialize an OMAC state (One-key Message Authentication Code)
+ * http://en.wikipedia.org/wiki/OMAC_%28cryptography%29
+ *
+ * @param IN    omac    \n The OMAC state to initialize.
+ *
+ * @param IN    okey    \n OMAC key prepared by fit_omac_key_setup.
+ *
+ * @return FIT_STATUS_OK on success; otherwise appropriate error code.
+ *
+ */
+static fit_status_t fit_omac_init(omac_state_t *omac, omac_key_t *okey)
+{
+    if (omac == NULL || okey == NULL)
+        return FIT_STATUS_INVALID_PARAM;
+
     /* setup state */
     omac->buflen = 0;
-    omac->blklen = len;
+    omac->key = okey;
 
-    fit_memset(omac->prev, 0, sizeof(omac->prev));
-    fit_memset(omac->block, 0, sizeof(omac->block));
+    fit_memset((uint8_t *)omac->prev, 0, sizeof(omac->prev));
+    fit_memset((uint8_t *)omac->block, 0, sizeof(omac->block));
 
     return FIT_STATUS_OK;
 
@@ -123,12 +154,12 @@ static fit_status_t fit_omac_init(omac_state_t *omac,
  *
  * \skip fit_omac_process
  *
- * Process data through OMAC.
+ * Process data through OMAC. Input is read block by block; each full block that is
+ * followed by more data is XORed into previous cipher block and encrypted. Last
+ * block is kept in omac->block for fit_omac_done.
  *
  * @param IN    omac    \n The OMAC state obtained via fit_omac_init.
  *
- * @param IN    aes     \n AES state.
- *
  * @param IN    indata  \n Start address of the input data for which OMAC to be
  *                         calculated in binary format.
  *
@@ -136,49 +167,35 @@ static fit_status_t fit_omac_init(omac_state_t *omac,
  *
  */
 static fit_status_t fit_omac_process(omac_state_t *omac,
-                              fit_aes_t *aes,
                               const fit_pointer_t *indata)
 {
     uint16_t n = 0;
-    uint8_t x = 0;
-    fit_pointer_t input;
+    const uint8_t *addr = indata->data;
     uint16_t inlen = indata->length;
 
-    if ((omac->buflen > (uint8_t)sizeof(omac->block)) ||
-        (omac->blklen > (uint8_t)sizeof(omac->block)) ||
-        (omac->buflen > omac->blklen))
+    if (omac->buflen > OMAC_BLOCK_LENGTH)
     {
         return FIT_STATUS_INVALID_PARAM;
     }
-    fit_memset((uint8_t *)&input, 0, sizeof(fit_pointer_t));
-    input.data = indata->data;
-    input.length = indata->length;
-    input.read_byte = indata->read_byte;
 
     while (inlen != 0)
     {
-        /* ok if the block is full we xor in prev, encrypt and replace prev */
-        if (omac->buflen == omac->blklen)
+        /* ok if the block is full we xor it into prev and encrypt prev */
+        if (omac->buflen == OMAC_BLOCK_LENGTH)
         {
-            for (x = 0; x < (uint8_t)omac->blklen; x++)
-            {
-                omac->block[x] ^= omac->prev[x];
-            }
-
-            fit_aes_encrypt(aes, omac->block, omac->prev, omac->key,
-                (uint8_t*)omac->state);
+            fit_omac_xor_block(omac->prev, omac->block);
+            fit_aes_encrypt(&omac->key->aes, (uint8_t *)omac->prev, (uint8_t *)omac->prev,
+                omac->key->key, (uint8_t*)omac->state);
             omac->buflen = 0;
         }
 
         /* add bytes */
-
-        n = fit_math_min(inlen, (uint8_t)(omac->blklen - omac->buflen));
-        input.length = n;
-        fitptr_memcpy(omac->block + omac->buflen, &input);
+        n = fit_math_min(inlen, (uint8_t)(OMAC_BLOCK_LENGTH - omac->buflen));
+        fitptr_read_block((uint8_t *)omac->block + omac->buflen, addr, n, indata);
 
         omac->buflen  += (uint8_t)n;
         inlen -= n;
-        input.data += n;
+        addr += n;
     }
 
     return FIT_STATUS_OK;
@@ -192,8 +209,6 @@ static fit_status_t fit_omac_process(omac_state_t *omac,
  *
  * @param IN    omac    \n The OMAC state obtained via fit_omac_init.
  *
- * @param IN    aes     \n AES state.
- *
  * @param OUT   out     \n Contains OMAC value out of data.
  *
  * @param OUT   outlen  \n The max size and resulting size of the OMAC data.
@@ -202,30 +217,28 @@ static fit_status_t fit_omac_process(omac_state_t *omac,
  *
  */
 static fit_status_t fit_omac_done(omac_state_t *omac,
-                           fit_aes_t *aes,
                            uint8_t *out,
                            uint32_t *outlen)
-        {
+{
     uint8_t mode        = 0;
     uint8_t x           = 0;
-    
-    if((omac->buflen > (uint8_t)sizeof(omac->block)) ||
-      (omac->blklen > (uint8_t)sizeof(omac->block)) ||
-      (omac->buflen > omac->blklen))
+    uint8_t *block      = (uint8_t *)omac->block;
+
+    if (omac->buflen > OMAC_BLOCK_LENGTH)
     {
         return FIT_STATUS_INVALID_PARAM;
     }
 
     /* figure out mode */
-    if(omac->buflen != omac->blklen)
+    if(omac->buflen != OMAC_BLOCK_LENGTH)
     {
         /* add the 0x80 byte */
-        omac->block[omac->buflen++] = 0x80;
+        block[omac->buflen++] = 0x80;
 
         /* pad with 0x00 */
-        while (omac->buflen < omac->blklen)
+        while (omac->buflen < OMAC_BLOCK_LENGTH)
         {
-            omac->block[omac->buflen++] = 0x00;
+            block[omac->buflen++] = 0x00;
         }
         mode = 1;
     }
@@ -235,19 +248,17 @@ static fit_status_t fit_omac_done(omac_state_t *omac,
     }
 
     /* now xor prev + Lu[mode] */
-    for (x = 0; x < (unsigned)omac->blklen; x++)
-    {
-        omac->block[x] ^= omac->prev[x] ^ omac->Lu[mode][x];
-    }
+    fit_omac_xor_block(omac->block, omac->prev);
+    fit_omac_xor_block(omac->block, omac->key->Lu[mode]);
 
     /* encrypt it */
-    fit_aes_encrypt(aes, omac->block, omac->block, omac->key, (uint8_t*)omac->state);
+    fit_aes_encrypt(&omac->key->aes, block, block, omac->key->key, (uint8_t*)omac->state);
     done((uint8_t *)&omac->key);
 
     /* output it */
-    for (x = 0; x < (uint8_t)omac->blklen && x < *outlen; x++)
+    for (x = 0; x < OMAC_BLOCK_LENGTH && x < *outlen; x++)
     {
-        out[x] = omac->block[x];
+        out[x] = block[x];
     }
     *outlen = x;
 
@@ -259,9 +270,10 @@ static fit_status_t fit_omac_done(omac_state_t *omac,
  *
  * \skip fit_omac_memory
  *
- * Get OMAC of data passed in. OMAC will internally use AES 128 encryption.
+ * Get OMAC of data passed in. OMAC will internally use AES 128 encryption. With
+ * FIT_USE_AES_KEY_CACHE expanded key is kept and reused while key data is the same.
  *
- * @param IN    blocklength    \n The index of the desired cipher.
+ * @param IN    blocklength    \n Cipher block length; must be OMAC_BLOCK_LENGTH.
  *
  * @param IN    key     \n Start address of the signing key in binary format,
  *                         depending on your READ_LICENSE_BYTE definition
@@ -285,22 +297,64 @@ fit_status_t fit_omac_memory(uint16_t blocklength,
 {
     fit_status_t result = FIT_STATUS_UNKNOWN_ERROR;
     omac_state_t omac = {0};
-    fit_aes_t aes;
+    omac_key_t *okey = NULL;
+#ifdef FIT_USE_AES_KEY_CACHE
+    uint8_t keydata[FIT_AES_128_KEY_LENGTH];
+#else
+    omac_key_t omackey;
+#endif
+
+    if (blocklength != OMAC_BLOCK_LENGTH || key->read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM;
+
+#ifdef FIT_USE_AES_KEY_CACHE
+    okey = &fit_omac_key;
+    /* first round key is the key itself, so it identifies cached key */
+    if (fit_omac_key_ok == FIT_TRUE && key->length != FIT_AES_128_KEY_LENGTH)
+    {
+        fit_omac_key_ok = FIT_FALSE;
+    }
+    else if (fit_omac_key_ok == FIT_TRUE)
+    {
+        fitptr_read_block(keydata, key->data, FIT_AES_128_KEY_LENGTH, key);
+        if (fit_memcmp(keydata, okey->key, FIT_AES_128_KEY_LENGTH) != 0)
+            fit_omac_key_ok = FIT_FALSE;
+        fit_memset(keydata, 0, sizeof(keydata));
+    }
+    if (fit_omac_key_ok != FIT_TRUE)
+    {
+        result = fit_omac_key_setup(okey, key);
+        if (result != FIT_STATUS_OK)
+        {
+            DBG(FIT_TRACE_ERROR, "fit_omac_key_setup fails with error code %ld", result);
+            fit_licenf_aes_key_cache_invalidate();
+            goto bail;
+        }
+        fit_omac_key_ok = FIT_TRUE;
+    }
+#else
+    okey = &omackey;
+    if ((result = fit_omac_key_setup(okey, key)) != FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "fit_omac_key_setup fails with error code %ld", result);
+        goto bail;
+    }
+#endif /* #ifdef FIT_USE_AES_KEY_CACHE */
 
     /* omac process the data */
-    if ((result = fit_omac_init(&omac, &aes, blocklength, key)) != FIT_STATUS_OK)
+    if ((result = fit_omac_init(&omac, okey)) != FIT_STATUS_OK)
     {
         DBG(FIT_TRACE_ERROR, "fit_omac_init fails with error code %ld", result);
         goto bail;
     }
 
-    if ((result = fit_omac_process(&omac, &aes, indata)) != FIT_STATUS_OK)
+    if ((result = fit_omac_process(&omac, indata)) != FIT_STATUS_OK)
     {
         DBG(FIT_TRACE_ERROR, "fit_omac_process fails with error code %ld", result);
         goto bail;
     }
 
-    if ((result = fit_omac_done(&omac, &aes, out, outlen)) != FIT_STATUS_OK)
+    if ((result = fit_omac_done(&omac, out, outlen)) != FIT_STATUS_OK)
     {
         DBG(FIT_TRACE_ERROR, "fit_omac_done fails with error code %ld", result);
         goto bail;
@@ -330,11 +384,15 @@ bail:
  * @param IN    aeskey      \n Start address of the signing key in binary format,
  *                             depending on your READ_LICENSE_BYTE definition
  *
+ * @param IN    licindex    \n Pointer to license index for license passed in. NULL if
+ *                             license binary is to be parsed for getting field data.
+ *
  * @return FIT_STATUS_OK on success; otherwise appropriate error code.
  *
  */
 fit_status_t fit_validate_omac_signature(fit_pointer_t* license,
-                                         fit_pointer_t* aeskey)
+                                         fit_pointer_t* aeskey,
+                                         fit_license_index_t *licindex)
 {
     fit_status_t status             = FIT_STATUS_UNKNOWN_ERROR;
     fit_context_data_t context;
@@ -363,15 +421,22 @@ fit_status_t fit_validate_omac_signature(fit_pointer_t* license,
     //         it with stored OMAC.
 
     // Step 1: Get the data address in license binary where signature is stored
-    context.level = FIT_STRUCT_SIGNATURE_LEVEL;
-    context.index = FIT_SIGNATURE_DATA_FIELD;
-    context.operation = (uint8_t)FIT_OP_GET_DATA_ADDRESS;
-    // Parse license data.
-    status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license, &context);
-    if (!(status == FIT_STATUS_OK && context.parserstatus == FIT_INFO_STOP_PARSE))
+    if (licindex != NULL)
     {
-        DBG(FIT_TRACE_ERROR, "Not able to get OMAC data %d\n", status);
-        goto bail;
+        context.parserdata.addr = licindex->signature;
+    }
+    else
+    {
+        context.level = FIT_STRUCT_SIGNATURE_LEVEL;
+        context.index = FIT_SIGNATURE_DATA_FIELD;
+        context.operation = (uint8_t)FIT_OP_GET_DATA_ADDRESS;
+        // Parse license data.
+        status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license, &context);
+        if (!(status == FIT_STATUS_OK && context.parserstatus == FIT_INFO_STOP_PARSE))
+        {
+            DBG(FIT_TRACE_ERROR, "Not able to get OMAC data %d\n", status);
+            goto bail;
+        }
     }
     if (context.parserdata.addr == NULL)
         return FIT_STATUS_INVALID_V2C;
@@ -382,11 +447,19 @@ fit_status_t fit_validate_omac_signature(fit_pointer_t* license,
     fitptr_memcpy(licenseomac, &licdata);
 
     // Get address and length of license part in binary.
-    num_fields  = read_word(license->data, license->read_byte);
-    licenselen  = (uint16_t)(read_dword(license->data +
-            (num_fields*FIT_PFIELD_SIZE)+FIT_PFIELD_SIZE, license->read_byte));
-    licaddr     = (uint8_t *)license->data +
-            ((num_fields*FIT_PFIELD_SIZE)+FIT_PFIELD_SIZE+FIT_PARRAY_SIZE);
+    if (licindex != NULL)
+    {
+        licenselen  = licindex->liclength;
+        licaddr     = licindex->licdata;
+    }
+    else
+    {
+        num_fields  = fitptr_read_word(license->data, license);
+        licenselen  = (uint16_t)(fitptr_read_dword(license->data +
+                (num_fields*FIT_PFIELD_SIZE)+FIT_PFIELD_SIZE, license));
+        licaddr     = (uint8_t *)license->data +
+                ((num_fields*FIT_PFIELD_SIZE)+FIT_PFIELD_SIZE+FIT_PARRAY_SIZE);
+    }
     licdata.data = licaddr;
     licdata.length = licenselen;
 
@@ -417,7 +490,7 @@ fit_status_t fit_validate_omac_signature(fit_pointer_t* license,
     }
 
     /* Validate fingerprint information present in the license */
-    status = fit_validate_fp_data(license);
+    status = fit_validate_fp_data(license, licindex);
      if (status != FIT_STATUS_OK)
     {
         DBG(FIT_TRACE_CRITICAL, "fit_validate_fp_data failed with error code %d\n",
@@ -432,3 +505,20 @@ bail:
 }
 
 #endif // ifdef FIT_USE_AES_SIGNING
+
+/**
+ *
+ * \skip fit_licenf_aes_key_cache_invalidate
+ *
+ * This function is used to drop expanded AES key kept between OMAC verifications
+ * (FIT_USE_AES_KEY_CACHE). Should be called when AES key data is changed; round keys
+ * of old key are cleared from RAM.
+ *
+ */
+void fit_licenf_aes_key_cache_invalidate(void)
+{
+#ifdef FIT_USE_AES_KEY_CACHE
+    fit_omac_key_ok = FIT_FALSE;
+    fit_memset((uint8_t *)&fit_omac_key, 0, sizeof(fit_omac_key));
+#endif
+}
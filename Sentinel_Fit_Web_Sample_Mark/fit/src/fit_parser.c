@@ -52,10 +52,20 @@ static fit_status_t fit_get_data_address(fit_pointer_t *pdata,
                                          uint16_t length,
                                          void *context);
 
+/*
+ * This function will be used to record addresses of license fields in license
+ * index while parsing license binary.
+ */
+static fit_status_t fit_build_license_index(fit_pointer_t *pdata,
+                                            uint8_t level,
+                                            uint8_t index,
+                                            uint16_t length,
+                                            void *context);
+
 /* Global Data **************************************************************/
 
 /* This will contain data related to whether RSA verification is done or not.*/
-fit_cache_data_t fit_cache = {FIT_FALSE, {0}};
+fit_cache_data_t fit_cache;
 
 /* Function Prototypes ******************************************************/
 
@@ -74,6 +84,11 @@ static fit_status_t parsercallbacks(uint8_t level,
                                     uint16_t length,
                                     void *context);
 
+/* This function updates get info cursor when parser descends into object or array.*/
+static void fit_info_cursor_enter(fit_context_data_t *pcontext,
+                                  uint8_t level,
+                                  uint8_t index);
+
 #ifdef FIT_USE_UNIT_TESTS
 static fit_status_t fieldcallbackfn(uint8_t level, uint8_t index, fit_pointer_t *pdata, void *context);
 #endif /* #ifdef FIT_USE_UNIT_TESTS */
@@ -82,7 +97,8 @@ static fit_status_t fieldcallbackfn(uint8_t level, uint8_t index, fit_pointer_t
 /* Callback function registered against each fit based operation.*/
 struct fit_parse_callbacks fct[] = {{FIT_OP_FIND_FEATURE_ID, fit_find_feature_id},
                                     {FIT_OP_PARSE_LICENSE, fit_parse_field_data},
-                                    {FIT_OP_GET_DATA_ADDRESS, fit_get_data_address}
+                                    {FIT_OP_GET_DATA_ADDRESS, fit_get_data_address},
+                                    {FIT_OP_BUILD_LICENSE_INDEX, fit_build_license_index}
 #ifdef FIT_USE_UNIT_TESTS
               ,
                           {FIT_OP_GET_VENDORID, fit_get_vendor_id},
@@ -170,7 +186,7 @@ fit_status_t fit_parse_object(uint8_t level,
     fit_pointer_t fitptr; 
     fit_context_data_t *pcontext  = (fit_context_data_t *)context;
     /* Header is a 16bit integer. It represents number of fields.*/
-    uint16_t num_fields     = read_word(pdata->data, pdata->read_byte);
+    uint16_t num_fields     = fitptr_read_word(pdata->data, pdata);
     /*
      * struct_offset contains value that represents start of field data(all except
      * integer data) i.e. number of bytes after which field data will start. If field
@@ -211,7 +227,7 @@ fit_status_t fit_parse_object(uint8_t level,
          * Each field in field part is a 16bit integer  Value of this field will
          * tell what type of data it contains.
          */
-        field_data = read_word(pdata->data, pdata->read_byte);
+        field_data = fitptr_read_word(pdata->data, pdata);
         /*
          * If field_data is zero, that means the field data is encoded in data part.
          * This field data can be in form of string or array or an object itself.
@@ -251,7 +267,7 @@ fit_status_t fit_parse_object(uint8_t level,
 
             status = fit_parse_data (level, cur_index, &fitptr, context);
             struct_offset   = (uint16_t)(struct_offset +
-                (uint16_t)read_dword(parserdata+struct_offset, pdata->read_byte) +
+                (uint16_t)fitptr_read_dword(parserdata+struct_offset, pdata) +
                 sizeof(uint32_t));
             /* Move data pointer to next field.*/
             pdata->data     = pdata->data + FIT_PFIELD_SIZE;
@@ -380,6 +396,7 @@ static fit_status_t fit_parse_data(uint8_t level,
             status = parsercallbacks(level, index, pdata, FIT_POBJECT_SIZE, context);
             if (status != FIT_STATUS_OK)
                 break;
+            fit_info_cursor_enter(pcontext, level, index);
 
             /* Field value in data part represents an array.*/
             status = fit_parse_array(level+1, startindex, pdata, context);
@@ -397,6 +414,7 @@ static fit_status_t fit_parse_data(uint8_t level,
             status = parsercallbacks(level, index, pdata, FIT_POBJECT_SIZE, context);
             if (status != FIT_STATUS_OK)
                 break;
+            fit_info_cursor_enter(pcontext, level, index);
 
             /* Field value in data part represents an object.*/
             fitptr.data = pdata->data+FIT_POBJECT_SIZE;
@@ -428,7 +446,7 @@ static fit_status_t fit_parse_data(uint8_t level,
                  */
                 fitptr.data = pdata->data+FIT_PSTRING_SIZE;
                 status = parsercallbacks(level, index, &fitptr,
-                    (uint16_t)read_dword(pdata->data, pdata->read_byte), context);
+                    (uint16_t)fitptr_read_dword(pdata->data, pdata), context);
 #ifdef FIT_USE_UNIT_TESTS
             }
 #endif /* #ifdef FIT_USE_UNIT_TESTS */
@@ -486,13 +504,15 @@ static fit_status_t fit_parse_data(uint8_t level,
 fit_status_t fit_parse_array(uint8_t level, uint8_t index, fit_pointer_t *pdata, void *context)
 {
     /* Get the total size of array in bytes.*/
-    uint32_t arraysize  = read_dword(pdata->data, pdata->read_byte);
+    uint32_t arraysize  = fitptr_read_dword(pdata->data, pdata);
     /* Get the size of first structure in that array.*/
     uint8_t *dataoffset = pdata->data + FIT_PARRAY_SIZE;
     uint16_t cntr       = 0;
+    uint16_t element    = 0;
     fit_pointer_t fitptr; 
     /* contains success or error code.*/
     fit_status_t status = FIT_STATUS_OK;
+    fit_context_data_t *pcontext  = (fit_context_data_t *)context;
 
     fit_memset((uint8_t *)&fitptr, 0, sizeof(fit_pointer_t));
     fitptr.length = 0;
@@ -507,12 +527,20 @@ fit_status_t fit_parse_array(uint8_t level, uint8_t index, fit_pointer_t *pdata,
          */
         fitptr.data = dataoffset+FIT_POBJECT_SIZE;
 
+        /* Keep track of array element being parsed for get info cursor.*/
+        if (pcontext->operation == (uint8_t)FIT_OP_GET_LICENSE_INFO_DATA &&
+            level < FIT_INFO_MAX_DEPTH)
+        {
+            pcontext->parserdata.getinfodata.cursor.element[level] = element;
+        }
+        element++;
+
         status = fit_parse_object(level, index, &fitptr, context);
         if (status != FIT_STATUS_OK)
             break;
-        cntr += (uint16_t)(FIT_POBJECT_SIZE + read_dword(dataoffset, pdata->read_byte));
+        cntr += (uint16_t)(FIT_POBJECT_SIZE + fitptr_read_dword(dataoffset, pdata));
         /* Get to the next structure data in the array.*/
-        dataoffset += FIT_POBJECT_SIZE + read_dword(dataoffset, pdata->read_byte);
+        dataoffset += FIT_POBJECT_SIZE + fitptr_read_dword(dataoffset, pdata);
     }
 
     return status;
@@ -578,6 +606,33 @@ static uint8_t get_tag_id(uint8_t level, uint8_t index)
 #endif
 }
 
+/**
+ *
+ * fit_info_cursor_enter
+ *
+ * Records object or array at passed in level and index as parent of fields at next
+ * level in get info cursor. Does nothing for other operations.
+ *
+ * @param IN    pcontext    \n Pointer to fit context structure.
+ *
+ * @param IN    level       \n level/depth of object or array field.
+ *
+ * @param IN    index       \n Structure index of object or array field.
+ *
+ */
+static void fit_info_cursor_enter(fit_context_data_t *pcontext,
+                                  uint8_t level,
+                                  uint8_t index)
+{
+    if (pcontext->operation != (uint8_t)FIT_OP_GET_LICENSE_INFO_DATA)
+        return;
+    if (level+1 >= FIT_INFO_MAX_DEPTH)
+        return;
+
+    pcontext->parserdata.getinfodata.cursor.parent[level+1] = get_tag_id(level, index);
+    pcontext->parserdata.getinfodata.cursor.element[level+1] = 0;
+}
+
 /**
  *
  * fit_parse_field_data
@@ -637,14 +692,14 @@ fit_status_t fit_parse_field_data(fit_pointer_t *pdata,
         /* Get the 16 bit field value.*/
         if (length == sizeof(uint16_t))
         {
-            integer = (read_word(pdata->data, pdata->read_byte)/2)-1;
+            integer = (fitptr_read_word(pdata->data, pdata)/2)-1;
             DBG(FIT_TRACE_INFO, "Integer Value = %ld\n", integer);
         }
         /* Get the 32 bit field value.*/
         else if (length == sizeof(uint32_t))
         {
             /* This represents integer data in form of string, so need to do calculations.*/
-            integer = read_dword(pdata->data, pdata->read_byte);
+            integer = fitptr_read_dword(pdata->data, pdata);
             DBG(FIT_TRACE_INFO, "Integer Value = %ld\n", integer);
         }
     }
@@ -783,6 +838,107 @@ fit_status_t fit_get_data_address(fit_pointer_t *pdata,
     return status;
 }
 
+/**
+ *
+ * fit_build_license_index
+ *
+ * This function will be used to record addresses of license fields (signature,
+ * algorithm id, header, fingerprint, license container and license property
+ * blocks) and feature ids in license index. Field values are validated the same
+ * way as for FIT_OP_PARSE_LICENSE operation.
+ *
+ * @param IN    pdata   \n Pointer to fit_pointer_t structure containing license
+ *                         data at a given level and index.
+ *
+ * @param IN    level   \n level/depth of license schema.
+ *
+ * @param IN    index   \n structure index whose value is to be fetched.
+ *
+ * @param IN    length  \n Length of the data to be get.
+ *
+ * @param IN    context \n Pointer to fit context structure.
+ *
+ */
+fit_status_t fit_build_license_index(fit_pointer_t *pdata,
+                                     uint8_t level,
+                                     uint8_t index,
+                                     uint16_t length,
+                                     void *context)
+{
+    fit_context_data_t *pcontext    = (fit_context_data_t *)context;
+    fit_license_index_t *licindex   = pcontext->parserdata.licindex;
+
+    DBG(FIT_TRACE_INFO, "[fit_build_license_index]: for Level=%d, Index=%d, pdata=0x%X \n",
+        level, index, pdata->data);
+
+    /* Algorithm used for signing license data.*/
+    if (level == FIT_STRUCT_SIGNATURE_LEVEL && index == FIT_ALGORITHM_ID_FIELD)
+    {
+        if (length == sizeof(uint16_t))
+            licindex->algid = (uint32_t)(fitptr_read_word(pdata->data, pdata)/2)-1;
+        else
+            licindex->algid = fitptr_read_dword(pdata->data, pdata);
+    }
+    /* RSA signature or OMAC value.*/
+    else if (level == FIT_STRUCT_SIGNATURE_LEVEL && index == FIT_SIGNATURE_DATA_FIELD)
+    {
+        licindex->signature = pdata->data;
+        licindex->siglength = length;
+    }
+    /* License header object.*/
+    else if (level == FIT_STRUCT_LICENSE_LEVEL && index == FIT_HEADER_FIELD)
+    {
+        licindex->header = pdata->data+FIT_POBJECT_SIZE;
+    }
+    /* License container object.*/
+    else if (level == FIT_STRUCT_LICENSE_LEVEL && index == FIT_LICENSE_CONTAINER_FIELD)
+    {
+        licindex->container = pdata->data+FIT_POBJECT_SIZE;
+    }
+    /* Fingerprint data (only present for node locked licenses).*/
+    else if (level == FIT_STRUCT_HEADER_LEVEL && index == FIT_FINGERPRINT_FIELD)
+    {
+        licindex->fingerprint = pdata->data;
+    }
+    /* License property object. Contains features and licensing model.*/
+    else if (level == FIT_STRUCT_PRODUCT_PART_LEVEL && index == FIT_LIC_PROP_FIELD)
+    {
+        if (licindex->num_lic_props < FIT_LIC_INDEX_MAX_LIC_PROPS)
+        {
+            licindex->lic_prop[licindex->num_lic_props] = pdata->data+FIT_POBJECT_SIZE;
+            licindex->num_lic_props++;
+        }
+        else
+        {
+            licindex->lic_prop_overflow = FIT_TRUE;
+        }
+    }
+#ifdef FIT_USE_FEATURE_INDEX
+    /* Feature id. Belongs to license property block recorded last.*/
+    else if (level == FIT_STRUCT_FEATURE_LEVEL && index == FIT_ID_FEATURE_FIELD)
+    {
+        if (licindex->lic_prop_overflow == FIT_TRUE || licindex->num_lic_props == 0)
+        {
+            licindex->feature_overflow = FIT_TRUE;
+        }
+        else if (length == sizeof(uint16_t))
+        {
+            fit_feature_index_add(licindex,
+                (uint32_t)(fitptr_read_word(pdata->data, pdata)/2)-1,
+                licindex->num_lic_props);
+        }
+        else if (length == sizeof(uint32_t))
+        {
+            fit_feature_index_add(licindex, fitptr_read_dword(pdata->data, pdata),
+                licindex->num_lic_props);
+        }
+    }
+#endif /* #ifdef FIT_USE_FEATURE_INDEX */
+
+    /* Validate field data.*/
+    return fit_parse_field_data(pdata, level, index, length, context);
+}
+
 #ifdef FIT_USE_UNIT_TESTS
 
 /**
@@ -894,10 +1050,23 @@ fit_status_t parsercallbacks(uint8_t level,
     {
         /* Get the tagid corresponding to level and index.*/
         uint8_t tagid = get_tag_id(level, index);
-        fit_v2c_data_t *v2c = (fit_v2c_data_t *)pcontext->parserdata.getinfodata.get_info_data;
+        void *userdata = pcontext->parserdata.getinfodata.get_info_data;
 
         DBG(FIT_TRACE_INFO, "Calling user provided callback function\n");
-        status = pcontext->parserdata.getinfodata.callback_fn(tagid, pdata, length, &stop_parse, v2c);
+        if (pcontext->parserdata.getinfodata.cursor_fn != NULL)
+        {
+            fit_info_cursor_t *cursor = &(pcontext->parserdata.getinfodata.cursor);
+
+            cursor->tagid = tagid;
+            cursor->level = level;
+            status = pcontext->parserdata.getinfodata.cursor_fn(cursor, pdata, length,
+                &stop_parse, userdata);
+        }
+        else
+        {
+            status = pcontext->parserdata.getinfodata.callback_fn(tagid, pdata, length,
+                &stop_parse, userdata);
+        }
         if (stop_parse == FIT_TRUE)
             pcontext->parserstatus = FIT_INFO_STOP_PARSE;
     }
@@ -18,23 +18,763 @@
 
 #include <string.h>
 
+#include "fit_types.h"
+#include "fit_version.h"
+
 #ifdef FIT_USE_RSA_SIGNING
 
-#include "fit_rsa.h"
-#include "fit_debug.h"
-#include "fit_internal.h"
-#include "fit_mem_read.h"
-#include "fit_dm_hash.h"
-#include "fit_abreast_dm.h"
-#include "fit_parser.h"
-#include "mbedtls/pk.h"
+#include "fit_rsa.h"
+#include "fit_debug.h"
+#include "fit_internal.h"
+#include "fit_hwdep.h"
+#include "fit_mem_read.h"
+#include "fit_dm_hash.h"
+#include "fit_abreast_dm.h"
+#include "fit_parser.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/asn1.h"
+#include "mbedtls/bignum.h"
+#ifdef FIT_USE_RSA_FIXED_VERIFY
+#include "mbedtls/bn_mul.h"
+#endif
+
+/* Constants ****************************************************************/
+
+/** Number of license bytes read at once during single pass license verification */
+#define FIT_RSA_VERIFY_CHUNK_SIZE       0x40
+
+#ifdef FIT_USE_RSA_FIXED_VERIFY
+/* limb sizes as in bignum.c, needed by bn_mul.h macros */
+#define ciL                             (sizeof(mbedtls_mpi_uint))
+#define biL                             (ciL << 3)
+#define biH                             (ciL << 2)
+/** Number of limbs of RSA-2048 modulus and signature */
+#define FIT_RSA_LIMBS                   (FIT_RSA_SIG_SIZE / ciL)
+/** Doublings of R mod N before squaring it into R^2 mod N (5 squarings) */
+#define FIT_RSA_RR_DOUBLINGS            ((FIT_RSA_SIG_SIZE * 8) >> 5)
+/** Length of DER encoded DigestInfo (SHA-256 OID) preceding hash in signature */
+#define FIT_RSA_DIGEST_INFO_SIZE        19
+
+/*
+ * Compiled RSA public key record (fit_licenf_compile_rsa_key); numbers are little
+ * endian:
+ *      0   magic "FITK"
+ *      4   record version (16 bit)
+ *      6   modulus size in bytes (16 bit)
+ *      8   public exponent (32 bit)
+ *     12   -N^-1 mod 2^32
+ *     16   modulus N
+ *    272   R^2 mod N
+ *    528   Davies Meyer hash of all preceding bytes
+ */
+#define FIT_RSA_REC_VERSION             1
+#define FIT_RSA_REC_HEADER_SIZE         0x10
+#define FIT_RSA_REC_N_OFFSET            FIT_RSA_REC_HEADER_SIZE
+#define FIT_RSA_REC_RR_OFFSET           (FIT_RSA_REC_N_OFFSET + FIT_RSA_SIG_SIZE)
+#define FIT_RSA_REC_HASH_OFFSET         (FIT_RSA_REC_RR_OFFSET + FIT_RSA_SIG_SIZE)
+
+#if FIT_RSA_REC_HASH_OFFSET + FIT_DM_HASH_SIZE != FIT_RSA_KEY_RECORD_SIZE
+#error "FIT_RSA_KEY_RECORD_SIZE does not match layout of compiled RSA key"
+#endif
+#endif /* #ifdef FIT_USE_RSA_FIXED_VERIFY */
+
+/* Types ********************************************************************/
+
+/*
+ * Location of license parts used in RSA verification. All offsets are relative to
+ * start of license binary (V2C data).
+ */
+typedef struct fit_rsa_lic_layout {
+    /** Length of complete license binary.*/
+    uint16_t length;
+    /** Offset of license part (signed data).*/
+    uint16_t licoffset;
+    /** Length of license part (signed data).*/
+    uint16_t liclength;
+    /** Offset of RSA signature data.*/
+    uint16_t sigoffset;
+} fit_rsa_lic_layout_t;
+
+#ifdef FIT_USE_RSA_FIXED_VERIFY
+/** RSA-2048 public key prepared for Montgomery arithmetic (little endian limbs).*/
+typedef struct fit_rsa_fixed_key {
+    /** Modulus N.*/
+    mbedtls_mpi_uint n[FIT_RSA_LIMBS];
+    /** R^2 mod N, R = 2^2048.*/
+    mbedtls_mpi_uint rr[FIT_RSA_LIMBS];
+    /** -N^-1 mod 2^biL.*/
+    mbedtls_mpi_uint mm;
+    /** Public exponent.*/
+    uint32_t e;
+} fit_rsa_fixed_key_t;
+
+/** Working numbers of fixed size RSA verification.*/
+typedef struct fit_rsa_fixed_work {
+    /** Accumulator of modular exponentiation.*/
+    mbedtls_mpi_uint a[FIT_RSA_LIMBS];
+    /** Signature.*/
+    mbedtls_mpi_uint s[FIT_RSA_LIMBS];
+    /** Signature in Montgomery form (s * R mod N).*/
+    mbedtls_mpi_uint sr[FIT_RSA_LIMBS];
+    /** Montgomery multiplication temporary; also used for signature bytes.*/
+    mbedtls_mpi_uint t[2 * FIT_RSA_LIMBS + 2];
+} fit_rsa_fixed_work_t;
+#endif /* #ifdef FIT_USE_RSA_FIXED_VERIFY */
+
+/* Global Data  *************************************************************/
+
+extern fit_cache_data_t fit_cache;
+
+#ifdef FIT_USE_RSA_KEY_CACHE
+/** Parsed RSA public key kept between signature verifications.*/
+static mbedtls_pk_context fit_rsa_key_pk;
+/** Davies Meyer hash of RSA public key data fit_rsa_key_pk is parsed from.*/
+static uint8_t fit_rsa_key_hash[FIT_DM_HASH_SIZE];
+/** FIT_TRUE if fit_rsa_key_pk contains parsed RSA public key.*/
+static fit_boolean_t fit_rsa_key_cached = FIT_FALSE;
+#endif /* #ifdef FIT_USE_RSA_KEY_CACHE */
+
+#ifdef FIT_USE_RSA_FIXED_VERIFY
+/** Public key used by fixed size RSA verification.*/
+static fit_rsa_fixed_key_t fit_rsa_fixed_key;
+/** FIT_TRUE if fit_rsa_fixed_key is prepared from cached RSA public key.*/
+static fit_boolean_t fit_rsa_fixed_key_ok = FIT_FALSE;
+/** Working numbers of fixed size RSA verification (kept off the stack).*/
+static fit_rsa_fixed_work_t fit_rsa_work;
+
+/** DER encoded DigestInfo of SHA-256 (algorithm id with NULL parameters).*/
+static const uint8_t fit_rsa_digest_info[FIT_RSA_DIGEST_INFO_SIZE] = {
+    0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+    0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+};
+
+/** Magic number starting compiled RSA public key record.*/
+static const uint8_t fit_rsa_rec_magic[4] = { 'F', 'I', 'T', 'K' };
+#endif /* #ifdef FIT_USE_RSA_FIXED_VERIFY */
+
+/* Function Definitions *****************************************************/
+
+/**
+ *
+ * fit_rsa_error_status
+ *
+ * This function maps mbedtls error code of key parsing or signature verification to
+ * fit status. Memory allocation failure is not reported as invalid signature, as
+ * result of signature check is kept in RSA validation cache.
+ *
+ * @param   ret         --> mbedtls error code (negative, high and low level part)
+ *
+ */
+static fit_status_t fit_rsa_error_status(int ret)
+{
+    if (ret == MBEDTLS_ERR_PK_ALLOC_FAILED ||
+        ((-ret) & 0x7F) == -MBEDTLS_ERR_MPI_ALLOC_FAILED ||
+        ((-ret) & 0x7F) == -MBEDTLS_ERR_ASN1_ALLOC_FAILED)
+    {
+        return FIT_STATUS_INSUFFICIENT_MEMORY;
+    }
+
+    return FIT_STATUS_INVALID_SIGNATURE;
+}
+
+/**
+ *
+ * fit_parse_rsa_key
+ *
+ * This function is used for parsing RSA public key data (PEM or binary format)
+ * into mbedtls pk context.
+ *
+ * @param   pk          --> pk context to be filled in. Must be initialized.
+ * @param   key         --> fit_pointer to RSA public key
+ *
+ */
+static fit_status_t fit_parse_rsa_key(mbedtls_pk_context *pk, fit_pointer_t *key)
+{
+    uint8_t *temp;
+    int ret = 0;
+
+    /* read pubkey into RAM */
+    temp = fit_calloc(1, key->length+1);
+    if (!temp) {
+        return FIT_STATUS_INSUFFICIENT_MEMORY;
+    }
+
+    fitptr_read_block(temp, key->data, key->length, key);
+
+#ifdef FIT_USE_PEM
+    ret = mbedtls_pk_parse_public_key( pk, (const unsigned char *)temp,
+                key->length + 1);
+#else
+    {
+      unsigned char *p = temp;
+      ret = mbedtls_pk_parse_subpubkey( &p, p + key->length, pk );
+    }
+#endif
+
+    fit_free(temp);
+    if (ret)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_validate_rsa_signature] parsing public key "
+            "FAILED -0x%04x\n", -ret);
+        return fit_rsa_error_status(ret);
+    }
+    DBG(FIT_TRACE_INFO, "[fit_validate_rsa_signature] public key is accepted\n" );
+
+    return FIT_STATUS_OK;
+}
+
+#ifdef FIT_USE_RSA_KEY_CACHE
+/**
+ *
+ * fit_get_cached_rsa_key
+ *
+ * This function is used for getting parsed RSA public key. Key is parsed only if
+ * Davies Meyer hash of key data differs from hash of key parsed last time.
+ *
+ * @param   key         --> fit_pointer to RSA public key
+ * @param   pk          --> On return, pointer to parsed RSA public key.
+ *
+ */
+static fit_status_t fit_get_cached_rsa_key(fit_pointer_t *key, mbedtls_pk_context **pk)
+{
+    fit_status_t status = FIT_STATUS_UNKNOWN_ERROR;
+    uint8_t keyhash[FIT_DM_HASH_SIZE];
+
+    status = fit_davies_meyer_hash(key, keyhash);
+    if (status != FIT_STATUS_OK)
+        return status;
+
+    if (fit_rsa_key_cached == FIT_TRUE &&
+        fit_memcmp(fit_rsa_key_hash, keyhash, FIT_DM_HASH_SIZE) == 0)
+    {
+        DBG(FIT_TRACE_INFO, "[fit_validate_rsa_signature] using cached public key\n" );
+        *pk = &fit_rsa_key_pk;
+        return FIT_STATUS_OK;
+    }
+
+    fit_licenf_rsa_key_cache_invalidate();
+    mbedtls_pk_init( &fit_rsa_key_pk );
+    status = fit_parse_rsa_key(&fit_rsa_key_pk, key);
+    if (status != FIT_STATUS_OK)
+    {
+        mbedtls_pk_free( &fit_rsa_key_pk );
+        return status;
+    }
+
+    fit_memcpy(fit_rsa_key_hash, keyhash, FIT_DM_HASH_SIZE);
+    fit_rsa_key_cached = FIT_TRUE;
+    *pk = &fit_rsa_key_pk;
+
+    return FIT_STATUS_OK;
+}
+#endif /* #ifdef FIT_USE_RSA_KEY_CACHE */
+
+#ifdef FIT_USE_RSA_FIXED_VERIFY
+/**
+ *
+ * fit_rsa_mul_hlp
+ *
+ * d += s * b for i limbs of s, carry propagated into d (mpi_mul_hlp of bignum.c).
+ * Uses multiply-accumulate kernel of bn_mul.h.
+ *
+ */
+static void fit_rsa_mul_hlp(size_t i, mbedtls_mpi_uint *s, mbedtls_mpi_uint *d,
+                            mbedtls_mpi_uint b)
+{
+    mbedtls_mpi_uint c = 0, t = 0;
+
+#if defined(MULADDC_HUIT)
+    for( ; i >= 8; i -= 8 )
+    {
+        MULADDC_INIT
+        MULADDC_HUIT
+        MULADDC_STOP
+    }
+#else
+    for( ; i >= 8; i -= 8 )
+    {
+        MULADDC_INIT
+        MULADDC_CORE   MULADDC_CORE
+        MULADDC_CORE   MULADDC_CORE
+        MULADDC_CORE   MULADDC_CORE
+        MULADDC_CORE   MULADDC_CORE
+        MULADDC_STOP
+    }
+#endif
+    for( ; i > 0; i-- )
+    {
+        MULADDC_INIT
+        MULADDC_CORE
+        MULADDC_STOP
+    }
+
+    t++;
+
+    do {
+        *d += c; c = ( *d < c ); d++;
+    }
+    while( c != 0 );
+}
+
+/**
+ *
+ * fit_rsa_cmp
+ *
+ * Compares FIT_RSA_LIMBS long numbers; returns 1, 0 or -1 if a > b, a == b, a < b.
+ *
+ */
+static int fit_rsa_cmp(const mbedtls_mpi_uint *a, const mbedtls_mpi_uint *b)
+{
+    size_t i;
+
+    for (i = FIT_RSA_LIMBS; i > 0; i--)
+    {
+        if (a[i - 1] != b[i - 1])
+            return (a[i - 1] > b[i - 1]) ? 1 : -1;
+    }
+
+    return 0;
+}
+
+/**
+ *
+ * fit_rsa_sub_n
+ *
+ * a -= b for FIT_RSA_LIMBS long numbers (modulo R).
+ *
+ */
+static void fit_rsa_sub_n(mbedtls_mpi_uint *a, const mbedtls_mpi_uint *b)
+{
+    mbedtls_mpi_uint c = 0, z;
+    size_t i;
+
+    for (i = 0; i < FIT_RSA_LIMBS; i++)
+    {
+        z = (a[i] < c);
+        a[i] -= c;
+        c = (a[i] < b[i]) + z;
+        a[i] -= b[i];
+    }
+}
+
+/**
+ *
+ * fit_rsa_montmul
+ *
+ * Montgomery multiplication a = a * b * R^-1 mod N (mpi_montmul of bignum.c).
+ * a and b are less than N and may be the same number.
+ *
+ * @param   a           --> first factor; on return contains result
+ * @param   b           --> second factor
+ *
+ */
+static void fit_rsa_montmul(mbedtls_mpi_uint *a, mbedtls_mpi_uint *b)
+{
+    fit_rsa_fixed_key_t *key = &fit_rsa_fixed_key;
+    mbedtls_mpi_uint u0, u1, *d;
+    size_t i;
+
+    fit_memset((uint8_t *)fit_rsa_work.t, 0, sizeof(fit_rsa_work.t));
+    d = fit_rsa_work.t;
+
+    for (i = 0; i < FIT_RSA_LIMBS; i++)
+    {
+        /* T = (T + u0*B + u1*N) / 2^biL */
+        u0 = a[i];
+        u1 = (d[0] + u0 * b[0]) * key->mm;
+
+        fit_rsa_mul_hlp(FIT_RSA_LIMBS, b, d, u0);
+        fit_rsa_mul_hlp(FIT_RSA_LIMBS, key->n, d, u1);
+
+        d++; d[FIT_RSA_LIMBS + 1] = 0;
+    }
+
+    /* result is less than 2N; top limb is d[FIT_RSA_LIMBS] */
+    if (d[FIT_RSA_LIMBS] != 0 || fit_rsa_cmp(d, key->n) >= 0)
+        fit_rsa_sub_n(d, key->n);
+    fit_memcpy((uint8_t *)a, (uint8_t *)d, FIT_RSA_LIMBS * ciL);
+}
+
+/**
+ *
+ * fit_rsa_montg_init
+ *
+ * mm = -N^-1 mod 2^biL for fit_rsa_fixed_key (mpi_montg_init of bignum.c).
+ *
+ */
+static void fit_rsa_montg_init(void)
+{
+    mbedtls_mpi_uint x, m0 = fit_rsa_fixed_key.n[0];
+    size_t i;
+
+    x = m0;
+    x += ((m0 + 2) & 4) << 1;
+    for (i = biL; i >= 8; i /= 2)
+        x *= (2 - (m0 * x));
+    fit_rsa_fixed_key.mm = ~x + 1;
+}
+
+/**
+ *
+ * fit_rsa_fixed_key_load
+ *
+ * This function prepares parsed RSA public key for fixed size verification:
+ * modulus limbs, Montgomery constant and R^2 mod N. Returns FIT_FALSE if key is
+ * not RSA-2048 with odd public exponent less than 2^32; mbedtls is used then.
+ *
+ * @param   pk          --> parsed RSA public key
+ *
+ */
+static fit_boolean_t fit_rsa_fixed_key_load(mbedtls_pk_context *pk)
+{
+    fit_rsa_fixed_key_t *key = &fit_rsa_fixed_key;
+    mbedtls_rsa_context *rsa = NULL;
+    mbedtls_mpi_uint c;
+    size_t i, j;
+
+#ifdef FIT_USE_RSA_KEY_CACHE
+    if (fit_rsa_fixed_key_ok == FIT_TRUE)
+        return FIT_TRUE;
+#endif
+
+    if (mbedtls_pk_get_type(pk) != MBEDTLS_PK_RSA)
+        return FIT_FALSE;
+    rsa = mbedtls_pk_rsa(*pk);
+    if (mbedtls_mpi_bitlen(&rsa->N) != FIT_RSA_SIG_SIZE * 8 ||
+        mbedtls_mpi_bitlen(&rsa->E) > 32 || mbedtls_mpi_get_bit(&rsa->E, 0) != 1 ||
+        mbedtls_mpi_cmp_int(&rsa->E, 1) <= 0)
+    {
+        DBG(FIT_TRACE_INFO, "[fit_rsa_fixed_key_load] key not supported\n");
+        return FIT_FALSE;
+    }
+
+    fit_memset((uint8_t *)key, 0, sizeof(fit_rsa_fixed_key_t));
+    for (i = 0; i < FIT_RSA_LIMBS; i++)
+        key->n[i] = rsa->N.p[i];
+    for (i = 0; i < 32 / biL + 1 && i < rsa->E.n; i++)
+        key->e |= (uint32_t)((uint64_t)rsa->E.p[i] << (i * biL));
+
+    fit_rsa_montg_init();
+
+    /* R mod N = R - N (N has top bit set); double it, then square into R^2 mod N */
+    fit_memset((uint8_t *)key->rr, 0, sizeof(key->rr));
+    fit_rsa_sub_n(key->rr, key->n);
+    for (j = 0; j < FIT_RSA_RR_DOUBLINGS; j++)
+    {
+        c = key->rr[FIT_RSA_LIMBS - 1] >> (biL - 1);
+        for (i = FIT_RSA_LIMBS - 1; i > 0; i--)
+            key->rr[i] = (key->rr[i] << 1) | (key->rr[i - 1] >> (biL - 1));
+        key->rr[0] <<= 1;
+        if (c != 0 || fit_rsa_cmp(key->rr, key->n) >= 0)
+            fit_rsa_sub_n(key->rr, key->n);
+    }
+    for (j = FIT_RSA_RR_DOUBLINGS; j < FIT_RSA_SIG_SIZE * 8; j *= 2)
+        fit_rsa_montmul(key->rr, key->rr);
+
+#ifdef FIT_USE_RSA_KEY_CACHE
+    fit_rsa_fixed_key_ok = FIT_TRUE;
+#endif
+
+    return FIT_TRUE;
+}
+
+/**
+ *
+ * fit_rsa_is_key_record
+ *
+ * This function checks if RSA public key data is compiled key record (see
+ * fit_licenf_compile_rsa_key) instead of PEM or DER encoded key.
+ *
+ * @param   key         --> fit_pointer to RSA public key
+ *
+ */
+static fit_boolean_t fit_rsa_is_key_record(fit_pointer_t *key)
+{
+    uint8_t magic[sizeof(fit_rsa_rec_magic)];
+
+    if (key->length != FIT_RSA_KEY_RECORD_SIZE)
+        return FIT_FALSE;
+
+    fitptr_read_block(magic, key->data, sizeof(magic), key);
+
+    return (fit_memcmp(magic, (uint8_t *)fit_rsa_rec_magic, sizeof(magic)) == 0) ?
+        FIT_TRUE : FIT_FALSE;
+}
+
+/**
+ *
+ * fit_rsa_fixed_key_record_load
+ *
+ * This function loads compiled RSA public key record into fit_rsa_fixed_key. Record
+ * is read once, without copying it to RAM as a whole. Returns
+ * FIT_STATUS_INVALID_RSA_PUBKEY if checksum or any of key values is not valid.
+ * Record is loaded and checksummed on every verification, so key replaced at the
+ * same address is never mistaken for previous one.
+ *
+ * @param   key         --> fit_pointer to compiled RSA public key record
+ *
+ */
+static fit_status_t fit_rsa_fixed_key_record_load(fit_pointer_t *key)
+{
+    fit_rsa_fixed_key_t *k = &fit_rsa_fixed_key;
+    uint8_t *buf = (uint8_t *)fit_rsa_work.t;
+    uint8_t dmhash[FIT_DM_HASH_SIZE];
+    fit_dm_hash_ctx_t dmctx;
+    uint32_t mm32;
+    size_t i, j;
+
+    /* fit_rsa_fixed_key no longer holds key prepared from cached RSA public key */
+    fit_rsa_fixed_key_ok = FIT_FALSE;
+
+    fit_dm_hash_init(&dmctx);
+    fitptr_read_block(buf, key->data, FIT_RSA_REC_HEADER_SIZE, key);
+    fit_dm_hash_update(&dmctx, buf, FIT_RSA_REC_HEADER_SIZE);
+    if (fit_memcmp(buf, (uint8_t *)fit_rsa_rec_magic, sizeof(fit_rsa_rec_magic)) != 0 ||
+        (buf[4] | (buf[5] << 8)) != FIT_RSA_REC_VERSION ||
+        (buf[6] | (buf[7] << 8)) != FIT_RSA_SIG_SIZE)
+    {
+        return FIT_STATUS_INVALID_RSA_PUBKEY;
+    }
+    k->e = (uint32_t)buf[8] | ((uint32_t)buf[9] << 8) | ((uint32_t)buf[10] << 16) |
+        ((uint32_t)buf[11] << 24);
+    mm32 = (uint32_t)buf[12] | ((uint32_t)buf[13] << 8) | ((uint32_t)buf[14] << 16) |
+        ((uint32_t)buf[15] << 24);
+
+    /* modulus and R^2 mod N: little endian bytes into limbs */
+    fitptr_read_block(buf, key->data + FIT_RSA_REC_N_OFFSET, FIT_RSA_SIG_SIZE, key);
+    fit_dm_hash_update(&dmctx, buf, FIT_RSA_SIG_SIZE);
+    for (i = 0; i < FIT_RSA_LIMBS; i++)
+    {
+        for (k->n[i] = 0, j = ciL; j > 0; j--)
+            k->n[i] = (k->n[i] << 8) | buf[i * ciL + j - 1];
+    }
+    fitptr_read_block(buf, key->data + FIT_RSA_REC_RR_OFFSET, FIT_RSA_SIG_SIZE, key);
+    fit_dm_hash_update(&dmctx, buf, FIT_RSA_SIG_SIZE);
+    for (i = 0; i < FIT_RSA_LIMBS; i++)
+    {
+        for (k->rr[i] = 0, j = ciL; j > 0; j--)
+            k->rr[i] = (k->rr[i] << 8) | buf[i * ciL + j - 1];
+    }
+
+    fit_dm_hash_final(&dmctx, dmhash);
+    fitptr_read_block(buf, key->data + FIT_RSA_REC_HASH_OFFSET, FIT_DM_HASH_SIZE, key);
+    if (fit_memcmp(buf, dmhash, FIT_DM_HASH_SIZE) != 0)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_rsa_fixed_key_record_load] checksum mismatch\n");
+        return FIT_STATUS_INVALID_RSA_PUBKEY;
+    }
+
+    /* stored Montgomery constant is enough for 32 bit limbs */
+    if (ciL == sizeof(uint32_t))
+        k->mm = (mbedtls_mpi_uint)mm32;
+    else
+        fit_rsa_montg_init();
+
+    if ((uint32_t)(k->n[0] * k->mm) != 0xFFFFFFFFu || (uint32_t)k->mm != mm32 ||
+        (k->n[FIT_RSA_LIMBS - 1] >> (biL - 1)) == 0 || (k->e & 1) == 0 || k->e == 1 ||
+        fit_rsa_cmp(k->rr, k->n) >= 0)
+    {
+        return FIT_STATUS_INVALID_RSA_PUBKEY;
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_rsa_fixed_key_record_store
+ *
+ * This function writes fit_rsa_fixed_key as compiled RSA public key record.
+ *
+ * @param   record      --> buffer of FIT_RSA_KEY_RECORD_SIZE bytes
+ *
+ */
+static void fit_rsa_fixed_key_record_store(uint8_t *record)
+{
+    fit_rsa_fixed_key_t *k = &fit_rsa_fixed_key;
+    fit_dm_hash_ctx_t dmctx;
+    uint32_t mm32 = (uint32_t)k->mm;
+    size_t i, j;
+
+    fit_memset(record, 0, FIT_RSA_KEY_RECORD_SIZE);
+    fit_memcpy(record, (uint8_t *)fit_rsa_rec_magic, sizeof(fit_rsa_rec_magic));
+    record[4] = (uint8_t)FIT_RSA_REC_VERSION;
+    record[5] = (uint8_t)(FIT_RSA_REC_VERSION >> 8);
+    record[6] = (uint8_t)FIT_RSA_SIG_SIZE;
+    record[7] = (uint8_t)(FIT_RSA_SIG_SIZE >> 8);
+    for (i = 0; i < 4; i++)
+    {
+        record[8 + i] = (uint8_t)(k->e >> (i * 8));
+        record[12 + i] = (uint8_t)(mm32 >> (i * 8));
+    }
+    for (i = 0; i < FIT_RSA_LIMBS; i++)
+    {
+        for (j = 0; j < ciL; j++)
+        {
+            record[FIT_RSA_REC_N_OFFSET + i * ciL + j] = (uint8_t)(k->n[i] >> (j * 8));
+            record[FIT_RSA_REC_RR_OFFSET + i * ciL + j] = (uint8_t)(k->rr[i] >> (j * 8));
+        }
+    }
+
+    fit_dm_hash_init(&dmctx);
+    fit_dm_hash_update(&dmctx, record, FIT_RSA_REC_HASH_OFFSET);
+    fit_dm_hash_final(&dmctx, record + FIT_RSA_REC_HASH_OFFSET);
+}
+
+/**
+ *
+ * fit_rsa_fixed_verify
+ *
+ * This function verifies PKCS#1 v1.5 RSA-2048 signature of Abreast-DM hash with
+ * key prepared by fit_rsa_fixed_key_load. Only statically allocated memory is
+ * used. s^e mod N is computed in Montgomery form; for e = 65537 it takes
+ * 17 squarings (including conversion by R^2) and one multiplication.
+ *
+ * @param   signature   --> fit_pointer to the signature
+ * @param   hash        --> RAM pointer to Abreast-DM hash
+ *
+ */
+static fit_status_t fit_rsa_fixed_verify(fit_pointer_t *signature, uint8_t *hash)
+{
+    fit_rsa_fixed_work_t *w = &fit_rsa_work;
+    uint8_t *em = (uint8_t *)w->t;
+    mbedtls_mpi_uint x;
+    uint16_t i, j;
+    int bit;
+
+    /* signature (big endian) into limbs; signature must be less than N */
+    fitptr_read_block(em, signature->data, FIT_RSA_SIG_SIZE, signature);
+    for (i = 0; i < FIT_RSA_LIMBS; i++)
+    {
+        x = 0;
+        for (j = 0; j < ciL; j++)
+            x = (x << 8) | em[FIT_RSA_SIG_SIZE - (i + 1) * ciL + j];
+        w->s[i] = x;
+    }
+    if (fit_rsa_cmp(w->s, fit_rsa_fixed_key.n) >= 0)
+        return FIT_STATUS_INVALID_SIGNATURE;
+
+    /* a = s^e mod N: last multiplication by s (not s*R) leaves Montgomery form */
+    fit_memcpy((uint8_t *)w->sr, (uint8_t *)w->s, sizeof(w->sr));
+    fit_rsa_montmul(w->sr, fit_rsa_fixed_key.rr);
+    fit_memcpy((uint8_t *)w->a, (uint8_t *)w->sr, sizeof(w->a));
+    for (bit = 30; bit >= 0 && (fit_rsa_fixed_key.e >> (bit + 1)) == 0; bit--)
+        ;
+    for ( ; bit > 0; bit--)
+    {
+        fit_rsa_montmul(w->a, w->a);
+        if ((fit_rsa_fixed_key.e >> bit) & 1)
+            fit_rsa_montmul(w->a, w->sr);
+    }
+    fit_rsa_montmul(w->a, w->a);
+    fit_rsa_montmul(w->a, w->s);
+
+    /* encoded message: 00 01 FF..FF 00 DigestInfo hash */
+    for (i = 0; i < FIT_RSA_LIMBS; i++)
+    {
+        x = w->a[i];
+        for (j = 0; j < ciL; j++, x >>= 8)
+            em[FIT_RSA_SIG_SIZE - 1 - i * ciL - j] = (uint8_t)x;
+    }
+    j = FIT_RSA_SIG_SIZE - FIT_ABREAST_DM_HASH_SIZE - FIT_RSA_DIGEST_INFO_SIZE - 1;
+    if (em[0] != 0x00 || em[1] != 0x01 || em[j] != 0x00)
+        return FIT_STATUS_INVALID_SIGNATURE;
+    for (i = 2; i < j; i++)
+    {
+        if (em[i] != 0xFF)
+            return FIT_STATUS_INVALID_SIGNATURE;
+    }
+    if (fit_memcmp(em + j + 1, (uint8_t *)fit_rsa_digest_info,
+                   FIT_RSA_DIGEST_INFO_SIZE) != 0 ||
+        fit_memcmp(em + j + 1 + FIT_RSA_DIGEST_INFO_SIZE, hash,
+                   FIT_ABREAST_DM_HASH_SIZE) != 0)
+    {
+        return FIT_STATUS_INVALID_SIGNATURE;
+    }
+
+    return FIT_STATUS_OK;
+}
+#endif /* #ifdef FIT_USE_RSA_FIXED_VERIFY */
+
+/**
+ *
+ * fit_cache_get_key_hash
+ *
+ * This function is used for getting Davies Meyer hash (key id) of RSA public key
+ * into fit_cache.key_hash. Hash is always calculated from key data, so a key that
+ * is replaced at the same address and length is not taken for the old one.
+ *
+ * @param   key         --> fit_pointer to RSA public key
+ *
+ */
+static fit_status_t fit_cache_get_key_hash(fit_pointer_t *key)
+{
+    return fit_davies_meyer_hash(key, fit_cache.key_hash);
+}
+
+/**
+ *
+ * fit_cache_find
+ *
+ * This function is used for looking up verification result of license and key
+ * identified by their Davies Meyer hashes. Returns NULL if not cached.
+ *
+ * @param   dmhash      --> Davies Meyer hash of license data
+ * @param   keyhash     --> Davies Meyer hash of RSA public key data
+ *
+ */
+static fit_cache_entry_t *fit_cache_find(uint8_t *dmhash, uint8_t *keyhash)
+{
+    fit_cache_entry_t *entry = NULL;
+    uint8_t cntr = 0;
+
+    for (cntr = 0; cntr < FIT_VERIFY_CACHE_SIZE; cntr++)
+    {
+        entry = &fit_cache.entry[cntr];
+        if (entry->stamp != 0 &&
+            fit_memcmp(entry->dm_hash, dmhash, FIT_DM_HASH_SIZE) == 0 &&
+            fit_memcmp(entry->key_hash, keyhash, FIT_DM_HASH_SIZE) == 0)
+        {
+            return entry;
+        }
+    }
 
+    return NULL;
+}
 
-/* Global Data  *************************************************************/
+/**
+ *
+ * fit_cache_store
+ *
+ * This function is used to record verification result of license and key. Entry of
+ * same license and key, otherwise free or least recently used entry is taken.
+ *
+ * @param   dmhash      --> Davies Meyer hash of license data
+ * @param   keyhash     --> Davies Meyer hash of RSA public key data
+ * @param   status      --> result of RSA verification
+ *
+ */
+static void fit_cache_store(uint8_t *dmhash, uint8_t *keyhash, fit_status_t status)
+{
+    fit_cache_entry_t *entry = NULL;
+    uint8_t cntr = 0;
 
-extern fit_cache_data_t fit_cache;
+    entry = fit_cache_find(dmhash, keyhash);
+    if (entry == NULL)
+    {
+        entry = &fit_cache.entry[0];
+        for (cntr = 1; cntr < FIT_VERIFY_CACHE_SIZE; cntr++)
+        {
+            if (fit_cache.entry[cntr].stamp < entry->stamp)
+                entry = &fit_cache.entry[cntr];
+        }
+        fit_memcpy(entry->dm_hash, dmhash, FIT_DM_HASH_SIZE);
+        fit_memcpy(entry->key_hash, keyhash, FIT_DM_HASH_SIZE);
+    }
 
-/* Function Definitions *****************************************************/
+    entry->status = status;
+    entry->stamp = ++fit_cache.clock;
+}
 
 /**
  *
@@ -54,69 +794,231 @@ fit_status_t fit_validate_rsa_signature(fit_pointer_t *signature,
 {
 #ifdef FIT_USE_RSA_SIGNING
     uint8_t *temp;
-    int i;
     int ret = 0;
-    mbedtls_pk_context pk;
+    fit_status_t status = FIT_STATUS_UNKNOWN_ERROR;
+    mbedtls_pk_context *pk = NULL;
+#ifndef FIT_USE_RSA_KEY_CACHE
+    mbedtls_pk_context pkctx;
+#endif
 
-    /* read pubkey into RAM */
-    temp = fit_calloc(1, key->length+1);
-    if (!temp) {
-        return FIT_STATUS_INSUFFICIENT_MEMORY;
+#ifdef FIT_USE_RSA_FIXED_VERIFY
+    /* compiled key: no key parsing or Montgomery setup needed */
+    if (fit_rsa_is_key_record(key) == FIT_TRUE)
+    {
+        status = fit_rsa_fixed_key_record_load(key);
+        if (status == FIT_STATUS_OK)
+            status = fit_rsa_fixed_verify(signature, hash);
+        DBG(FIT_TRACE_INFO, "[fit_validate_rsa_signature] compiled key verify %d\n",
+            status);
+        return status;
     }
+#endif
 
-    for (i = 0; i < key->length; i++) 
-        temp[i] = key->read_byte(key->data + i);
-
-    mbedtls_pk_init( &pk );
-
-#ifdef FIT_USE_PEM
-    ret = mbedtls_pk_parse_public_key( &pk, (const unsigned char *)temp,
-                key->length + 1);
+#ifndef FIT_USE_RSA_KEY_CACHE
+    pk = &pkctx;
+    mbedtls_pk_init( pk );
+    status = fit_parse_rsa_key(pk, key);
 #else
-    {
-      unsigned char *p = temp;
-      ret = mbedtls_pk_parse_subpubkey( &p, p + key->length, &pk );
-    }
+    status = fit_get_cached_rsa_key(key, &pk);
 #endif
+    if (status != FIT_STATUS_OK)
+        goto exit;
 
-    fit_free(temp);
-    if (ret)
+#ifdef FIT_USE_RSA_FIXED_VERIFY
+    if (fit_rsa_fixed_key_load(pk) == FIT_TRUE)
     {
-        DBG(FIT_TRACE_ERROR, "[fit_validate_rsa_signature] parsing public key "
-            "FAILED -0x%04x\n", -ret);
+        status = fit_rsa_fixed_verify(signature, hash);
+        DBG(FIT_TRACE_INFO, "[fit_validate_rsa_signature] fixed size verify %d\n",
+            status);
         goto exit;
     }
-    DBG(FIT_TRACE_INFO, "[fit_validate_rsa_signature] public key is accepted\n" );
+#endif
 
     /* read signature from license memory */
     temp = fit_calloc(1, FIT_RSA_SIG_SIZE);
     if (!temp) {
-        return FIT_STATUS_INSUFFICIENT_MEMORY;
+        status = FIT_STATUS_INSUFFICIENT_MEMORY;
+        goto exit;
     }
-    for (i = 0; i < FIT_RSA_SIG_SIZE; i++)
-        temp[i] = signature->read_byte(signature->data + i);
+    fitptr_read_block(temp, signature->data, FIT_RSA_SIG_SIZE, signature);
 
-    ret = mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, hash, FIT_ABREAST_DM_HASH_SIZE,
+    ret = mbedtls_pk_verify(pk, MBEDTLS_MD_SHA256, hash, FIT_ABREAST_DM_HASH_SIZE,
                 temp, FIT_RSA_SIG_SIZE);
     fit_free(temp);
     if (ret)
     {
         DBG(FIT_TRACE_ERROR, "[fit_validate_rsa_signature] verify FAILED -0x%04x\n", -ret);
+        status = fit_rsa_error_status(ret);
         goto exit;
     }
 
     DBG(FIT_TRACE_INFO, "[fit_validate_rsa_signature] verify OK\n" );
-    ret = 0;
+    status = FIT_STATUS_OK;
 
  exit:
-    mbedtls_pk_free( &pk );
+#ifndef FIT_USE_RSA_KEY_CACHE
+    mbedtls_pk_free( pk );
+#endif
 
-    if (ret) return FIT_STATUS_INVALID_SIGNATURE;
+    return status;
 #endif
     return FIT_STATUS_OK;
 
 }
 
+/**
+ *
+ * fit_get_rsa_lic_layout
+ *
+ * This function gets location of license part, RSA signature and length of license
+ * binary. If license index is not available, only top level fields of license
+ * binary and signature objects are read, i.e. license part itself is not parsed.
+ *
+ * @param IN    license     \n Pointer to fit_pointer_t structure containing license
+ *                             data.
+ *
+ * @param IN    licindex    \n Pointer to license index for license passed in. NULL if
+ *                             license binary is to be read for getting layout.
+ *
+ * @param OUT   layout      \n On return contains location of license parts.
+ *
+ */
+static fit_status_t fit_get_rsa_lic_layout(fit_pointer_t *license,
+                                           fit_license_index_t *licindex,
+                                           fit_rsa_lic_layout_t *layout)
+{
+    fit_status_t status         = FIT_STATUS_OK;
+    fit_context_data_t context;
+    fit_pointer_t sigarray;
+    uint16_t num_fields         = 0;
+    uint16_t field_data         = 0;
+    uint16_t cntr               = 0;
+    uint8_t cur_index           = 0;
+    uint32_t struct_offset      = 0;
+    uint32_t datalen            = 0;
+
+    fit_memset((uint8_t *)layout, 0, sizeof(fit_rsa_lic_layout_t));
+
+    if (licindex != NULL)
+    {
+        layout->length = licindex->length;
+        layout->licoffset = (uint16_t)(licindex->licdata - license->data);
+        layout->liclength = licindex->liclength;
+        layout->sigoffset = (uint16_t)(licindex->signature - license->data);
+    }
+    else
+    {
+        fit_memset((uint8_t *)&sigarray, 0, sizeof(fit_pointer_t));
+        sigarray.read_byte = license->read_byte;
+
+        /* Walk top level fields (license and signature) without descending into them.*/
+        num_fields = fitptr_read_word(license->data, license);
+        struct_offset = (uint32_t)(num_fields+1)*FIT_PFIELD_SIZE;
+        for (cntr = 0; cntr < num_fields; cntr++)
+        {
+            field_data = fitptr_read_word(license->data+(cntr+1)*FIT_PFIELD_SIZE, license);
+            if (field_data == 0)
+            {
+                if (struct_offset + FIT_PSTRING_SIZE > license->length)
+                    return FIT_STATUS_INVALID_V2C;
+
+                datalen = fitptr_read_dword(license->data+struct_offset, license);
+                if (cur_index == FIT_LICENSE_FIELD)
+                {
+                    layout->licoffset = (uint16_t)(struct_offset + FIT_PARRAY_SIZE);
+                    layout->liclength = (uint16_t)datalen;
+                }
+                else if (cur_index == FIT_SIGNATURE_FIELD)
+                {
+                    sigarray.data = license->data + struct_offset;
+                }
+                struct_offset += datalen + FIT_PSTRING_SIZE;
+                if (struct_offset > license->length)
+                    return FIT_STATUS_INVALID_V2C;
+                cur_index++;
+            }
+            else if (field_data & 1)
+            {
+                cur_index = cur_index + (uint8_t)((field_data+1)/2);
+            }
+            else
+            {
+                cur_index++;
+            }
+        }
+        layout->length = (uint16_t)struct_offset;
+        if (sigarray.data == NULL)
+            return FIT_STATUS_INVALID_V2C;
+
+        /* Get RSA signature data address from array of signature objects.*/
+        fit_memset((uint8_t *)&context, 0 , sizeof(fit_context_data_t));
+        context.level = FIT_STRUCT_SIGNATURE_LEVEL;
+        context.index = FIT_SIGNATURE_DATA_FIELD;
+        context.operation = (uint8_t)FIT_OP_GET_DATA_ADDRESS;
+        status = fit_parse_array(FIT_STRUCT_SIGNATURE_LEVEL, 0, &sigarray, &context);
+        if (status != FIT_STATUS_OK && context.parserstatus != FIT_INFO_STOP_PARSE)
+        {
+            DBG(FIT_TRACE_ERROR, "Not able to get rsa data %d\n", status);
+            return status;
+        }
+        if (context.parserdata.addr == NULL)
+            return FIT_STATUS_INVALID_V2C;
+
+        layout->sigoffset = (uint16_t)(context.parserdata.addr - license->data);
+    }
+
+    if ((uint32_t)layout->licoffset + layout->liclength > layout->length ||
+        (uint32_t)layout->sigoffset + FIT_RSA_SIG_SIZE > layout->length)
+    {
+        return FIT_STATUS_INVALID_V2C;
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_chunk_overlap
+ *
+ * This function gets the part of data chunk read from license that belongs to given
+ * license region.
+ *
+ * @param IN    offset      \n Offset of data chunk in license.
+ *
+ * @param IN    len         \n Length of data chunk.
+ *
+ * @param IN    start       \n Offset of region in license.
+ *
+ * @param IN    length      \n Length of region.
+ *
+ * @param OUT   from        \n On return contains offset of overlap in data chunk.
+ *
+ * @param OUT   cnt         \n On return contains length of overlap.
+ *
+ * @return FIT_TRUE if chunk and region overlap; FIT_FALSE otherwise.
+ *
+ */
+static fit_boolean_t fit_chunk_overlap(uint16_t offset,
+                                       uint16_t len,
+                                       uint16_t start,
+                                       uint16_t length,
+                                       uint16_t *from,
+                                       uint16_t *cnt)
+{
+    uint32_t first  = (offset > start) ? offset : start;
+    uint32_t end    = (uint32_t)offset + len;
+
+    if (end > (uint32_t)start + length)
+        end = (uint32_t)start + length;
+    if (first >= end)
+        return FIT_FALSE;
+
+    *from = (uint16_t)(first - offset);
+    *cnt = (uint16_t)(end - first);
+
+    return FIT_TRUE;
+}
+
 /**
  *
  * \skip fit_verify_rsa_signature
@@ -136,46 +1038,46 @@ fit_status_t fit_validate_rsa_signature(fit_pointer_t *signature,
  * @param IN    check_cache \n FIT_TRUE if RSA verification is already done; FIT_FALSE
  *                             otherwise.
  *
+ * @param IN    licindex    \n Pointer to license index for license passed in. NULL if
+ *                             license binary is to be parsed for getting field data.
+ *
  * @return FIT_STATUS_OK on success; otherwise appropriate error code.
  *
  */
 fit_status_t fit_verify_rsa_signature(fit_pointer_t *license,
                                       fit_pointer_t *key,
-                                      fit_boolean_t check_cache)
+                                      fit_boolean_t check_cache,
+                                      fit_license_index_t *licindex)
 {
     fit_status_t status             = FIT_STATUS_UNKNOWN_ERROR;
     uint8_t dmhash[FIT_DM_HASH_SIZE];
-    fit_context_data_t context;
+    fit_rsa_lic_layout_t layout;
     fit_pointer_t fitptr;
+    fit_cache_entry_t *entry        = NULL;
 
     DBG(FIT_TRACE_INFO, "[fit_verify_rsa_signature]: license=0x%p length=%hd\n",
         license->data, license->length);
-    fit_memset((uint8_t *)&context, 0 , sizeof(fit_context_data_t));
     fit_memset((uint8_t *)&fitptr, 0, sizeof(fit_pointer_t));
     fit_memset(dmhash, 0, sizeof(dmhash));
 
     fitptr.read_byte = license->read_byte;
 
     /* Check validity of license data by RSA signature check.*/
-    if (fit_cache.rsa_check_done == FIT_TRUE && check_cache == FIT_TRUE)
+    if (check_cache == FIT_TRUE)
     {
         /* Calculate Davies-Meyer-hash on the license. Write that hash into the
          * hash table.
          */
-        context.level = FIT_STRUCT_V2C_LEVEL;
-        context.index = FIT_LICENSE_FIELD;
-        context.operation = (uint8_t)FIT_OP_PARSE_LICENSE;
-        /* Get license data address in data passed in. */
-        status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license,
-            &context);
-        if (status != FIT_STATUS_OK && context.parserstatus != FIT_INFO_STOP_PARSE)
+        /* License length (from license index or top level fields of license).*/
+        status = fit_get_rsa_lic_layout(license, licindex, &layout);
+        if (status != FIT_STATUS_OK)
         {
             DBG(FIT_TRACE_ERROR, "Error in license parsing %d\n", status);
             goto bail;
         }
 
         fitptr.data = (uint8_t *) license->data;
-        fitptr.length = context.length;
+        fitptr.length = layout.length;
         /* Get the hash of data.*/
         status = fit_davies_meyer_hash(&fitptr, (uint8_t *)&dmhash);
         if (status != FIT_STATUS_OK)
@@ -184,18 +1086,31 @@ fit_status_t fit_verify_rsa_signature(fit_pointer_t *license,
                 " %d\n", status);
             goto bail;
         }
+        /* Key id of key passed in.*/
+        status = fit_cache_get_key_hash(key);
+        if (status != FIT_STATUS_OK)
+            goto bail;
+
         /*
-         * If calculated hash does not match with stored hash then perform license
+         * If license is not verified against this key before then perform license
          * validation again. 
          */
-        if(fit_memcmp(fit_cache.dm_hash, dmhash, FIT_DM_HASH_SIZE) != 0 )
+        entry = fit_cache_find(dmhash, fit_cache.key_hash);
+        if (entry != NULL)
+        {
+            fit_cache.hits++;
+            entry->stamp = ++fit_cache.clock;
+            status = entry->status;
+        }
+        else
         {
-            status = fit_lic_do_rsa_verification(license, key);
+            fit_cache.misses++;
+            status = fit_lic_do_rsa_verification(license, key, licindex);
         }
     }
     else
     {
-        status = fit_lic_do_rsa_verification(license, key);
+        status = fit_lic_do_rsa_verification(license, key, licindex);
     }
 
     /* Check the result of license validation */
@@ -211,7 +1126,7 @@ fit_status_t fit_verify_rsa_signature(fit_pointer_t *license,
     }
 
     /* Validate fingerprint information present in the license */
-    status = fit_validate_fp_data(license);
+    status = fit_validate_fp_data(license, licindex);
      if (status != FIT_STATUS_OK)
     {
         DBG(FIT_TRACE_CRITICAL, "fit_validate_fp_data failed with error code %d\n",
@@ -220,12 +1135,6 @@ fit_status_t fit_verify_rsa_signature(fit_pointer_t *license,
     }
 
 bail:
-    if (status != FIT_STATUS_OK)
-    {
-        fit_cache.rsa_check_done = FIT_FALSE;
-        fit_memset(fit_cache.dm_hash, 0, sizeof(fit_cache.dm_hash));
-    }
-
     return status;
 }
 
@@ -233,15 +1142,16 @@ bail:
  *
  * fit_lic_do_rsa_verification
  *
- * This function will be used to validate license string. It will perform following
- * operations
+ * This function will be used to validate license string. License binary is read
+ * only once; each chunk read is passed to both hash calculations:
  *
  * A) Check RSA signature:
- *      Calculate Hash of the license by Abreast-DM
+ *      Calculate Hash of the license by Abreast-DM (license part only)
+ *      Copy RSA signature into RAM
  *      Validate RSA signature by RSA public key and license hash.
-* B) If the RSA signature has been verified, update the Hash table in RAM:
- *      Calculate Davies-Meyer-hash on the license
- *      Write that hash into the hash table.
+ * B) If the RSA signature has been checked, update the Hash table in RAM:
+ *      Calculate Davies-Meyer-hash on the license (complete license binary)
+ *      Record that hash, hash of RSA public key and result in the hash table.
  *
  * @param IN    license \n Pointer to fit_pointer_t structure that contains license
  *                         data that need to be validated for RSA decryption. To
@@ -253,70 +1163,69 @@ bail:
  *                         key in different types of memory (FLASH, E2, RAM),
  *                         fit_pointer_t is used.
  *
+ * @param IN    licindex    \n Pointer to license index for license passed in. NULL if
+ *                             license binary is to be parsed for getting field data.
+ *
  */
 fit_status_t fit_lic_do_rsa_verification(fit_pointer_t* license,
-                                         fit_pointer_t* rsakey)
+                                         fit_pointer_t* rsakey,
+                                         fit_license_index_t *licindex)
 {
     fit_status_t status           = FIT_STATUS_UNKNOWN_ERROR;
-    fit_context_data_t context;
-    fit_pointer_t licaddr;
+    fit_rsa_lic_layout_t layout;
     fit_pointer_t signature;
-    uint16_t num_fields           = 0;
+    fit_dm_hash_ctx_t dmctx;
+    fit_abreastdm_ctx_t abreastctx;
+    uint16_t offset               = 0;
+    uint16_t len                  = 0;
+    uint16_t from                 = 0;
+    uint16_t cnt                  = 0;
+    uint8_t chunk[FIT_RSA_VERIFY_CHUNK_SIZE];
+    uint8_t sigdata[FIT_RSA_SIG_SIZE];
     uint8_t abreasthash[FIT_ABREAST_DM_HASH_SIZE];
     uint8_t dmhash[FIT_DM_HASH_SIZE];
 
     DBG(FIT_TRACE_INFO, "[fit_lic_do_rsa_verification]: Entry.\n");
 
-    fit_memset((uint8_t *)&context, 0 , sizeof(fit_context_data_t));
-    fit_memset((uint8_t *)&licaddr, 0, sizeof(fit_pointer_t));
     fit_memset((uint8_t *)&signature, 0, sizeof(fit_pointer_t));
     fit_memset(abreasthash, 0, sizeof(abreasthash));
     fit_memset(dmhash, 0, sizeof(dmhash));
 
-    licaddr.read_byte = license->read_byte;
-    signature.read_byte = license->read_byte;
-
-    /*
-     * Check RSA signature:
-     * Step 1:   Calculate Hash of the license by Abreast-DM
-     * Step 2:   Validate RSA signature by RSA public key and license hash.
-     */
-
-    /* Get RSA signature data from license string.*/
-    context.level = FIT_STRUCT_SIGNATURE_LEVEL;
-    context.index = FIT_SIGNATURE_DATA_FIELD;
-    context.operation = (uint8_t)FIT_OP_GET_DATA_ADDRESS;
-    /* Parse license data to get address where RSA signature data is stored */
-    status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license,
-        &context);
-    if (status != FIT_STATUS_OK && context.parserstatus != FIT_INFO_STOP_PARSE)
+    /* Get location of license part and RSA signature in license binary.*/
+    status = fit_get_rsa_lic_layout(license, licindex, &layout);
+    if (status != FIT_STATUS_OK)
     {
         DBG(FIT_TRACE_ERROR, "Not able to get rsa data %d\n", status);
         goto bail;
     }
-    if (context.parserdata.addr == NULL)
-    {
-        status = FIT_STATUS_INVALID_V2C;
-        goto bail;
-    }
-
-    licaddr.data = context.parserdata.addr;
-    signature.data = licaddr.data;
-    signature.length = FIT_RSA_SIG_SIZE;
 
-    /*
-     * Step 1:  Calculate Hash of the license by Abreast-DM
-     * Get address and length of license part in binary.
-     */
-    num_fields  = read_word(license->data, license->read_byte);
-    licaddr.length  = (uint16_t)(read_dword(license->data +
-        ((num_fields*FIT_PFIELD_SIZE)+FIT_PFIELD_SIZE), license->read_byte));
-    licaddr.data = (uint8_t *)license->data +
-        ((num_fields*FIT_PFIELD_SIZE)+FIT_PFIELD_SIZE+FIT_PARRAY_SIZE);
+    /* Read license once and feed Abreast-DM hash, Davies-Meyer hash and signature.*/
+    fit_abreastdm_init(&abreastctx);
+    fit_dm_hash_init(&dmctx);
+    for (offset = 0; offset < layout.length; offset += len)
+    {
+        len = layout.length - offset;
+        if (len > FIT_RSA_VERIFY_CHUNK_SIZE)
+        {
+            len = FIT_RSA_VERIFY_CHUNK_SIZE;
+        }
+        fitptr_read_block(chunk, license->data + offset, len, license);
 
-    /* Get Abreast DM hash of the license */
-    status = fit_get_abreastdm_hash(&licaddr, abreasthash);
+        fit_dm_hash_update(&dmctx, chunk, len);
+        if (fit_chunk_overlap(offset, len, layout.licoffset, layout.liclength,
+                &from, &cnt))
+        {
+            fit_abreastdm_update(&abreastctx, chunk + from, cnt);
+        }
+        if (fit_chunk_overlap(offset, len, layout.sigoffset, FIT_RSA_SIG_SIZE,
+                &from, &cnt))
+        {
+            fit_memcpy(sigdata + (offset + from - layout.sigoffset), chunk + from, cnt);
+        }
+    }
 
+    /* Step 1:  Get Abreast DM hash of the license */
+    status = fit_abreastdm_final(&abreastctx, abreasthash);
     if (status != FIT_STATUS_OK)
     {
         DBG(FIT_TRACE_CRITICAL, "Error in getting AbreastDM hash, status = %d\n",
@@ -329,35 +1238,17 @@ fit_status_t fit_lic_do_rsa_verification(fit_pointer_t* license,
     }
 
     /* Step 2: Validate RSA signature by RSA public key and license hash.*/
+    signature.data = sigdata;
+    signature.length = FIT_RSA_SIG_SIZE;
+    signature.read_byte = (fit_read_byte_callback_t) FIT_READ_BYTE_RAM;
     status = fit_validate_rsa_signature(&signature, abreasthash, rsakey);
-    if (status != FIT_STATUS_OK)
-        goto bail;
-
-    /* Calculate Davies-Meyer-hash on the license. Write that hash into the hash table.*/
-    context.level = FIT_STRUCT_V2C_LEVEL;
-    context.index = FIT_LICENSE_FIELD;
-    context.operation = (uint8_t)FIT_OP_PARSE_LICENSE;
-    /* Parse license string to get address where license data is stored */
-    status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license, &context);
-    if (status != FIT_STATUS_OK && context.parserstatus != FIT_INFO_STOP_PARSE)
-    {
-        DBG(FIT_TRACE_ERROR, "Error in license parsing %d\n", status);
+    if (status != FIT_STATUS_OK && status != FIT_STATUS_INVALID_SIGNATURE)
         goto bail;
-    }
-
-    licaddr.length = context.length;
-    licaddr.data = (uint8_t *) license->data;
 
-    /* Get the davies meyer hash of data.*/
-    status = fit_davies_meyer_hash(&licaddr, (uint8_t *)&dmhash);
-    if (status != FIT_STATUS_OK)
-    {
-        DBG(FIT_TRACE_ERROR, "Error in getting Davies Meyer hash with status %d\n",
-            status);
-        goto bail;
-    }
-    fit_cache.rsa_check_done = FIT_TRUE;
-    fit_memcpy(fit_cache.dm_hash, dmhash, FIT_DM_HASH_SIZE);
+    /* Davies-Meyer-hash on the license. Write that hash into the hash table.*/
+    fit_dm_hash_final(&dmctx, dmhash);
+    if (fit_cache_get_key_hash(rsakey) == FIT_STATUS_OK)
+        fit_cache_store(dmhash, fit_cache.key_hash, status);
 
 bail:
     DBG(FIT_TRACE_INFO, "[fit_lic_do_rsa_verification]: Exit.\n");
@@ -366,3 +1257,219 @@ bail:
 }
 
 #endif // #ifdef FIT_USE_RSA_SIGNING
+
+/**
+ *
+ * \skip fit_licenf_rsa_key_cache_invalidate
+ *
+ * This function is used to drop RSA public key kept parsed between signature
+ * verifications (FIT_USE_RSA_KEY_CACHE). Should be called when RSA public key data
+ * is changed, so that memory of old key is released at once.
+ *
+ */
+void fit_licenf_rsa_key_cache_invalidate(void)
+{
+#ifdef FIT_USE_RSA_SIGNING
+#ifdef FIT_USE_RSA_KEY_CACHE
+    if (fit_rsa_key_cached == FIT_TRUE)
+        mbedtls_pk_free( &fit_rsa_key_pk );
+
+    fit_rsa_key_cached = FIT_FALSE;
+    fit_memset(fit_rsa_key_hash, 0, sizeof(fit_rsa_key_hash));
+#endif
+#ifdef FIT_USE_RSA_FIXED_VERIFY
+    fit_rsa_fixed_key_ok = FIT_FALSE;
+#endif
+#endif
+}
+
+/**
+ *
+ * \skip fit_licenf_get_verify_record
+ *
+ * This function is used for getting record of last successful RSA license
+ * verification (Davies Meyer hash of license and of RSA public key), so that
+ * application can keep it over reboot. Most recently used successful entry of RSA
+ * validation cache is returned.
+ *
+ * @param OUT   record  \n On return it will contain the verification record.
+ *
+ * @return FIT_STATUS_OK on success; FIT_STATUS_LIC_CACHING_ERROR if no license is
+ *         verified; otherwise appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_get_verify_record(fit_verify_record_t *record)
+{
+    if (record == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+
+#ifdef FIT_USE_RSA_SIGNING
+    fit_cache_entry_t *entry = NULL;
+    uint8_t cntr = 0;
+
+    for (cntr = 0; cntr < FIT_VERIFY_CACHE_SIZE; cntr++)
+    {
+        if (fit_cache.entry[cntr].stamp != 0 &&
+            fit_cache.entry[cntr].status == FIT_STATUS_OK &&
+            (entry == NULL || fit_cache.entry[cntr].stamp > entry->stamp))
+        {
+            entry = &fit_cache.entry[cntr];
+        }
+    }
+    if (entry == NULL)
+        return FIT_STATUS_LIC_CACHING_ERROR;
+
+    fit_memset((uint8_t *)record, 0, sizeof(fit_verify_record_t));
+    record->version = FIT_CORE_VERSION;
+    record->status = (uint16_t)entry->status;
+    fit_memcpy(record->lic_hash, entry->dm_hash, FIT_DM_HASH_SIZE);
+    fit_memcpy(record->key_hash, entry->key_hash, FIT_DM_HASH_SIZE);
+
+    return FIT_STATUS_OK;
+#else
+    return FIT_STATUS_NO_RSA_SUPPORT;
+#endif
+}
+
+/**
+ *
+ * \skip fit_licenf_set_verify_record
+ *
+ * This function is used to restore record of RSA license verification taken by
+ * fit_licenf_get_verify_record. Only records of successful verification done by
+ * same core version are accepted.
+ *
+ * @param IN    record  \n Pointer to verification record.
+ *
+ * @return FIT_STATUS_OK on success; FIT_STATUS_LIC_CACHING_ERROR if record is not
+ *         accepted; otherwise appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_set_verify_record(const fit_verify_record_t *record)
+{
+    if (record == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+
+#ifdef FIT_USE_RSA_SIGNING
+    if (record->version != FIT_CORE_VERSION || record->status != FIT_STATUS_OK)
+        return FIT_STATUS_LIC_CACHING_ERROR;
+
+    fit_cache_store((uint8_t *)record->lic_hash, (uint8_t *)record->key_hash,
+        FIT_STATUS_OK);
+
+    return FIT_STATUS_OK;
+#else
+    return FIT_STATUS_NO_RSA_SUPPORT;
+#endif
+}
+
+/**
+ *
+ * \skip fit_licenf_verify_cache_invalidate
+ *
+ * This function is used to drop all entries of RSA validation cache, so that next
+ * license use does RSA verification again.
+ *
+ */
+void fit_licenf_verify_cache_invalidate(void)
+{
+#ifdef FIT_USE_RSA_SIGNING
+    fit_memset((uint8_t *)fit_cache.entry, 0, sizeof(fit_cache.entry));
+#endif
+}
+
+/**
+ *
+ * \skip fit_licenf_get_verify_cache_stats
+ *
+ * This function is used for getting number of RSA validation cache lookups answered
+ * from cache (hits) and needing RSA verification (misses).
+ *
+ * @param OUT   hits    \n On return it will contain number of cache hits.
+ *
+ * @param OUT   misses  \n On return it will contain number of cache misses.
+ *
+ * @return FIT_STATUS_OK on success; otherwise appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_get_verify_cache_stats(uint32_t *hits, uint32_t *misses)
+{
+    if (hits == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+    if (misses == NULL)
+        return FIT_STATUS_INVALID_PARAM_2;
+
+#ifdef FIT_USE_RSA_SIGNING
+    *hits = fit_cache.hits;
+    *misses = fit_cache.misses;
+#else
+    *hits = 0;
+    *misses = 0;
+#endif
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * \skip fit_licenf_compile_rsa_key
+ *
+ * This function converts RSA-2048 public key (PEM or DER) into compiled key record
+ * of FIT_RSA_KEY_RECORD_SIZE bytes: modulus, public exponent, R^2 mod N and -N^-1
+ * mod 2^32, protected by Davies Meyer hash. Record can be used as RSA public key
+ * data; signatures are then verified without parsing the key.
+ *
+ * @param IN    key     \n Pointer to fit_pointer_t structure containing RSA public
+ *                         key (or compiled key record, which is checked and copied).
+ *
+ * @param OUT   record  \n Buffer for compiled key record.
+ *
+ * @param IO    length  \n Size of record buffer; on return length of record.
+ *
+ * @return FIT_STATUS_OK on success; FIT_STATUS_INVALID_RSA_PUBKEY if key can not be
+ *         compiled; otherwise appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_compile_rsa_key(fit_pointer_t *key,
+                                        uint8_t *record,
+                                        uint16_t *length)
+{
+    if (key == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+    if (record == NULL)
+        return FIT_STATUS_INVALID_PARAM_2;
+    if (length == NULL || *length < FIT_RSA_KEY_RECORD_SIZE)
+        return FIT_STATUS_INVALID_PARAM_3;
+
+#ifdef FIT_USE_RSA_FIXED_VERIFY
+    {
+        fit_status_t status = FIT_STATUS_UNKNOWN_ERROR;
+        mbedtls_pk_context pk;
+
+        if (fit_rsa_is_key_record(key) == FIT_TRUE)
+        {
+            status = fit_rsa_fixed_key_record_load(key);
+        }
+        else
+        {
+            /* key of RSA key cache is prepared again on next verification */
+            fit_rsa_fixed_key_ok = FIT_FALSE;
+            mbedtls_pk_init( &pk );
+            status = fit_parse_rsa_key(&pk, key);
+            if (status == FIT_STATUS_OK && fit_rsa_fixed_key_load(&pk) != FIT_TRUE)
+                status = FIT_STATUS_INVALID_RSA_PUBKEY;
+            mbedtls_pk_free( &pk );
+            fit_rsa_fixed_key_ok = FIT_FALSE;
+        }
+        if (status != FIT_STATUS_OK)
+            return status;
+
+        fit_rsa_fixed_key_record_store(record);
+        *length = FIT_RSA_KEY_RECORD_SIZE;
+
+        return FIT_STATUS_OK;
+    }
+#else
+    return FIT_STATUS_NO_RSA_SUPPORT;
+#endif
+}
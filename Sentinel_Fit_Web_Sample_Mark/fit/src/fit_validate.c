@@ -19,6 +19,9 @@
 #include "stddef.h"
 #include "fit_debug.h"
 #include "fit_internal.h"
+#include "fit_parser.h"
+#include "fit_mem_read.h"
+#include "fit_consume.h"
 
 /* Function Definitions *****************************************************/
 
@@ -57,8 +60,181 @@ fit_status_t fit_licenf_validate_license(fit_pointer_t *license,
     /** Verify the license string against signing key data present in keys array
       * and node locking 
       */
-    status = fit_verify_license(license, keys, FIT_FALSE);
+    status = fit_verify_license(license, keys, FIT_FALSE, NULL);
 
     return status;
 }
 
+
+/**
+ *
+ * \skip fit_licenf_build_license_index
+ *
+ * This function will parse the license binary once and record addresses of
+ * signature, algorithm id, header, fingerprint, license container and license
+ * property blocks in license index. License index can then be passed to
+ * fit_licenf_validate_license_idx and fit_licenf_consume_license_idx so that these
+ * functions do not need to parse complete license binary on every call.
+ *
+ * @param IN    license     \n Pointer to fit_pointer_t structure containing license
+ *                             data. To access the license data in different types
+ *                             of memory (FLASH, E2, RAM), fit_pointer_t is used.
+ *
+ * @param OUT   licindex    \n Pointer to license index to be filled in.
+ *
+ * @return FIT_STATUS_OK on success; otherwise appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_build_license_index(fit_pointer_t *license,
+                                            fit_license_index_t *licindex)
+{
+    fit_status_t status = FIT_STATUS_UNKNOWN_ERROR;
+    fit_context_data_t context;
+    fit_pointer_t fitptr;
+    uint16_t num_fields = 0;
+    uint8_t cntr        = 0;
+
+    DBG(FIT_TRACE_INFO, "[fit_licenf_build_license_index]: pdata=0x%p \n", license->data);
+
+    if (license->read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+    if (licindex == NULL)
+        return FIT_STATUS_INVALID_PARAM_2;
+
+    fit_memset((uint8_t *)licindex, 0, sizeof(fit_license_index_t));
+    fit_memset((uint8_t *)&context, 0, sizeof(fit_context_data_t));
+
+    /* Parse complete license binary and record addresses of license fields.*/
+    context.operation = (uint8_t)FIT_OP_BUILD_LICENSE_INDEX;
+    context.parserdata.licindex = licindex;
+    status = fit_parse_object(FIT_STRUCT_V2C_LEVEL, FIT_LICENSE_FIELD, license, &context);
+    if (status != FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "Error in building license index %d\n", status);
+        goto bail;
+    }
+
+    /* Signature data and header are mandatory in license binary.*/
+    if (licindex->signature == NULL || licindex->header == NULL)
+    {
+        status = FIT_STATUS_INVALID_V2C;
+        goto bail;
+    }
+
+    /* Get address and length of license part in binary.*/
+    num_fields = fitptr_read_word(license->data, license);
+    licindex->liclength = (uint16_t)(fitptr_read_dword(license->data +
+        ((num_fields*FIT_PFIELD_SIZE)+FIT_PFIELD_SIZE), license));
+    licindex->licdata = (uint8_t *)license->data +
+        ((num_fields*FIT_PFIELD_SIZE)+FIT_PFIELD_SIZE+FIT_PARRAY_SIZE);
+
+    /* Decode licensing model of each license property block once.*/
+    fit_memset((uint8_t *)&fitptr, 0, sizeof(fit_pointer_t));
+    fitptr.read_byte = license->read_byte;
+    for (cntr = 0; cntr < licindex->num_lic_props; cntr++)
+    {
+        fitptr.data = licindex->lic_prop[cntr];
+        status = fit_get_lic_prop_data(&fitptr, &licindex->lic_model[cntr]);
+        if (status != FIT_STATUS_OK)
+            goto bail;
+    }
+
+    licindex->length = context.length;
+    licindex->license = license->data;
+    licindex->datalength = license->length;
+    licindex->checksum = fit_license_index_checksum(license, licindex);
+    licindex->valid = FIT_TRUE;
+
+bail:
+    if (status != FIT_STATUS_OK)
+        fit_memset((uint8_t *)licindex, 0, sizeof(fit_license_index_t));
+
+    return status;
+}
+
+/**
+ *
+ * \skip fit_licenf_validate_license_idx
+ *
+ * This function is same as fit_licenf_validate_license except that addresses of
+ * license fields are taken from license index instead of parsing license binary.
+ *
+ * @param IN    license     \n Pointer to fit_pointer_t structure containing license
+ *                             data. To access the license data in different types
+ *                             of memory (FLASH, E2, RAM), fit_pointer_t is used.
+ *
+ * @param IN    keys    \n Pointer to array of key data. Also contains callback
+ *                         function to read key data in differenttypes of memory
+ *                         (FLASH, E2, RAM).
+ *
+ * @param IN    licindex    \n Pointer to license index built by
+ *                             fit_licenf_build_license_index for license passed in.
+ *
+ * @return FIT_STATUS_OK on success; otherwise appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_validate_license_idx(fit_pointer_t *license,
+                                             fit_key_array_t *keys,
+                                             fit_license_index_t *licindex)
+{
+    fit_status_t status = FIT_STATUS_UNKNOWN_ERROR;
+
+    DBG(FIT_TRACE_INFO, "[fit_licenf_validate_license_idx]: pdata=0x%p \n", license->data);
+
+    if (license->read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+
+    if (keys->read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM_2;
+
+    if (fit_license_index_ok(license, licindex) != FIT_TRUE)
+        return FIT_STATUS_INVALID_PARAM_3;
+
+    status = fit_verify_license(license, keys, FIT_FALSE, licindex);
+
+    return status;
+}
+
+/**
+ *
+ * \skip fit_licenf_revalidate_license_idx
+ *
+ * This function is same as fit_licenf_validate_license_idx except that RSA signature
+ * is not verified again if result of verification of same license data against same
+ * RSA public key is cached (see FIT_VERIFY_CACHE_SIZE).
+ *
+ * @param IN    license     \n Pointer to fit_pointer_t structure containing license
+ *                             data. To access the license data in different types
+ *                             of memory (FLASH, E2, RAM), fit_pointer_t is used.
+ *
+ * @param IN    keys    \n Pointer to array of key data. Also contains callback
+ *                         function to read key data in differenttypes of memory
+ *                         (FLASH, E2, RAM).
+ *
+ * @param IN    licindex    \n Pointer to license index built by
+ *                             fit_licenf_build_license_index for license passed in.
+ *
+ * @return FIT_STATUS_OK on success; otherwise appropriate error code.
+ *
+ */
+fit_status_t fit_licenf_revalidate_license_idx(fit_pointer_t *license,
+                                               fit_key_array_t *keys,
+                                               fit_license_index_t *licindex)
+{
+    fit_status_t status = FIT_STATUS_UNKNOWN_ERROR;
+
+    DBG(FIT_TRACE_INFO, "[fit_licenf_revalidate_license_idx]: pdata=0x%p \n", license->data);
+
+    if (license->read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM_1;
+
+    if (keys->read_byte == NULL)
+        return FIT_STATUS_INVALID_PARAM_2;
+
+    if (fit_license_index_ok(license, licindex) != FIT_TRUE)
+        return FIT_STATUS_INVALID_PARAM_3;
+
+    status = fit_verify_license(license, keys, FIT_TRUE, licindex);
+
+    return status;
+}
@@ -14,6 +14,12 @@
 
 #include "fit_types.h"
 
+/*
+ * Writer function of fit_getinfo_json_stream. Called with each chunk of JSON
+ * output, e.g. to send it to network client.
+ */
+typedef void (*fit_getinfo_write_fn)(const uint8_t *data, uint16_t len, void *ctx);
+
 /*
 EXTERNC fit_status_t fit_testgetinfodata(
                           fit_pointer_t *licenseData,
@@ -26,4 +32,9 @@ EXTERNC fit_status_t fit_testgetinfodata_json(
                           uint8_t *pgetinfo,
                           uint16_t *getinfolen);
 
+EXTERNC fit_status_t fit_getinfo_json_stream(
+                          fit_pointer_t *licenseData,
+                          fit_getinfo_write_fn write_fn,
+                          void *write_ctx);
+
 #endif /* SENTINEL_FIT_WEB_SAMPLE_MARK_FIT_DEMO_GETINFO_H_ */
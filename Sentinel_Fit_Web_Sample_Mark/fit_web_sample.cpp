@@ -130,7 +130,7 @@ void set_key_array (void)
     aesalglist->num_of_alg = no_of_alg;
     aesalglist->algorithm_guid[0] = &aes_alg_guid;
 
-    set_fit_ptr_ee(&fp, EE_AES_OFFSET, EE_AES_MAXSIZE);
+    set_fit_ptr_ab(&fp, &ee_ab_aes);
     aes_key_data.key = fp.data;
     aes_key_data.key_length = fp.length;
     aes_key_data.algorithms = aesalglist;
@@ -140,7 +140,7 @@ void set_key_array (void)
     rsaalglist->num_of_alg = no_of_alg;
     rsaalglist->algorithm_guid[0] = &rsa_alg_guid;
 
-    set_fit_ptr_ee(&fp, EE_RSA_OFFSET, EE_RSA_MAXSIZE);
+    set_fit_ptr_ab(&fp, &ee_ab_rsa);
     rsa_key_data.key = fp.data;
     rsa_key_data.key_length = fp.length;
     rsa_key_data.algorithms = rsaalglist;
@@ -153,12 +153,12 @@ void set_key_array (void)
 
 #if 0
     dump_fit_key_array(key_arr);
-    set_fit_ptr_ee(&fitptrlic, EE_V2C_OFFSET, EE_V2C_MAXSIZE);
+    set_fit_ptr_v2c(&fitptrlic);
     status = fit_licenf_consume_license(&fitptrlic, 2, key_arr);
     pr("fit_licenf_consume_license() status: %d: %s\n", status, fit_get_error_str(status));
 
     dump_fit_key_array(&fit_keys);
-    set_fit_ptr_ee(&fitptrlic, EE_V2C_OFFSET, EE_V2C_MAXSIZE);
+    set_fit_ptr_v2c(&fitptrlic);
     status = fit_licenf_consume_license(&fitptrlic, 2, &fit_keys);
     pr("fit_licenf_consume_license() status: %d: %s\n", status, fit_get_error_str(status));
 #endif
@@ -175,8 +175,11 @@ fit_status_t do_consume_license(uint16_t feature_id)
     fit_status_t status = FIT_STATUS_UNKNOWN_ERROR;
 
     set_key_array();
-    set_fit_ptr_ee(&fp, EE_V2C_OFFSET, EE_V2C_MAXSIZE);
-    status = fit_licenf_consume_license(&fp, feature_id, key_arr);
+    set_fit_ptr_v2c(&fp);
+    if (lic_index.valid == FIT_TRUE)
+        status = fit_licenf_consume_license_idx(&fp, feature_id, key_arr, &lic_index);
+    else
+        status = fit_licenf_consume_license(&fp, feature_id, key_arr);
     pr("fit_licenf_consume_license(feature:%d) status: %d: %s\n", feature_id, status,
             fit_get_error_str(status));
 
@@ -282,6 +285,11 @@ void setup()
     //MAH
 
     pr("\r\nEE size: %d\n", EEPROMSizeGet());
+    ee_layout_init(); /* once: take over licensing data of the former EEPROM layout */
+
+    /* validate stored license at boot; a matching verification record saves the RSA check */
+    verify_record_load();
+    validate_license_ee();
 
     /* notify user about IP address */
     pr("\r\n"
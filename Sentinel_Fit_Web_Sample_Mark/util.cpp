@@ -178,6 +178,19 @@ uint8_t read_0(const uint8_t *p)
 
 /**************************************************************************************************/
 
+static uint32_t read_ee_u32(uint32_t offset)
+{
+    uint32_t v;
+
+    v = read_eeprom_u8((uint8_t*) offset++);
+    v += read_eeprom_u8((uint8_t*) offset++) << 8;
+    v += read_eeprom_u8((uint8_t*) offset++) << 16;
+    v += read_eeprom_u8((uint8_t*) offset++) << 24;
+    return v;
+}
+
+/**************************************************************************************************/
+
 void set_fit_ptr_ee(fit_pointer_t *fp, uint32_t offset, uint32_t maxsize)
 {
     uint32_t size;
@@ -199,10 +212,176 @@ void set_fit_ptr_ee(fit_pointer_t *fp, uint32_t offset, uint32_t maxsize)
 
 /**************************************************************************************************/
 
+/**
+ * A/B slots
+ *
+ * Commit record entry of a slot: 16 bit sequence number in the low half, its complement in
+ * the high half, so erased or torn entries are recognized. A slot is valid if its entry is
+ * and its size header is in range (below 4 meaning "no object"). The newest valid slot is
+ * active; without any valid entry slot A is used as is (taken over from the former layout,
+ * or erased EEPROM).
+ */
+
+const ee_ab_t ee_ab_v2c = { EE_V2C_OFFSET, EE_V2C_MAXSIZE, EE_V2C_COMMIT_OFFSET };
+const ee_ab_t ee_ab_rsa = { EE_RSA_OFFSET, EE_RSA_MAXSIZE, EE_RSA_COMMIT_OFFSET };
+const ee_ab_t ee_ab_aes = { EE_AES_OFFSET, EE_AES_MAXSIZE, EE_AES_COMMIT_OFFSET };
+
+static uint32_t ee_ab_slot_offset(const ee_ab_t *ab, int slot)
+{
+    return ab->ofs + slot * ab->max;
+}
+
+/**
+ * returns 1 and sequence number of slot if the slot is valid, 0 otherwise
+ */
+static int ee_ab_slot_seq(const ee_ab_t *ab, int slot, uint16_t *seq)
+{
+    uint32_t entry = read_ee_u32(ab->commit + 4 * slot);
+    uint32_t size = read_ee_u32(ee_ab_slot_offset(ab, slot));
+
+    if ((entry >> 16) != (~entry & 0xFFFF))
+        return 0;
+    if (size > ab->max)
+        return 0;
+
+    *seq = (uint16_t) entry;
+    return 1;
+}
+
+int ee_ab_active_slot(const ee_ab_t *ab)
+{
+    uint16_t seq[2];
+    int valid[2];
+    int slot;
+
+    for (slot = 0; slot < 2; slot++)
+        valid[slot] = ee_ab_slot_seq(ab, slot, &seq[slot]);
+
+    /* sequence numbers wrap, newer is at most 0x7FFF ahead */
+    if (valid[0] && valid[1])
+        return ((int16_t) (seq[1] - seq[0]) > 0) ? 1 : 0;
+    return valid[1] ? 1 : 0;
+}
+
+void set_fit_ptr_ab(fit_pointer_t *fp, const ee_ab_t *ab)
+{
+    set_fit_ptr_ee(fp, ee_ab_slot_offset(ab, ee_ab_active_slot(ab)), ab->max);
+}
+
+/**
+ * stage a new object in the inactive slot; the active one stays untouched until
+ * ee_ab_stream_commit()
+ */
+void ee_ab_stream_begin(ee_stream_t *es, const ee_ab_t *ab)
+{
+    ee_stream_begin(es, ee_ab_slot_offset(ab, 1 - ee_ab_active_slot(ab)), ab->max);
+}
+
+/**
+ * commit staged object: write its size header, then switch slots with one commit record word
+ */
+int ee_ab_stream_commit(ee_stream_t *es, const ee_ab_t *ab)
+{
+    int active = ee_ab_active_slot(ab);
+    int slot = (es->ofs - ab->ofs) / ab->max;
+    uint16_t seq = 0;
+
+    if (!ee_stream_commit(es))
+        return 0;
+
+    if (ee_ab_slot_seq(ab, active, &seq))
+        seq++;
+    write_eeprom_u32(ab->commit + 4 * slot, ((uint32_t) (uint16_t) ~seq << 16) | seq);
+
+    return 1;
+}
+
+/**
+ * write an object from RAM to the inactive slot and commit it; returns 0 if it did not fit
+ */
+int ee_ab_write(const ee_ab_t *ab, const uint8_t *data, uint32_t size)
+{
+    ee_stream_t es;
+
+    ee_ab_stream_begin(&es, ab);
+    ee_stream_write(&es, data, size);
+
+    return ee_ab_stream_commit(&es, ab);
+}
+
+int ee_v2c_active_slot(void)
+{
+    return ee_ab_active_slot(&ee_ab_v2c);
+}
+
+void set_fit_ptr_v2c(fit_pointer_t *fp)
+{
+    set_fit_ptr_ab(fp, &ee_ab_v2c);
+}
+
+void ee_v2c_stream_begin(ee_stream_t *es)
+{
+    ee_ab_stream_begin(es, &ee_ab_v2c);
+}
+
+int ee_v2c_stream_commit(ee_stream_t *es)
+{
+    return ee_ab_stream_commit(es, &ee_ab_v2c);
+}
+
+/**
+ * Take over licensing data of the former single slot layout (V2C 4 KB at 0, AES key at 4096,
+ * RSA key at 4608), once. V2C slot A and RSA key slot A are at their former offsets; the AES
+ * key, which lies in V2C slot B now, is copied to AES key slot A. Objects that do not fit a
+ * slot are reported and dropped. The commit record is cleared, so all A slots are used as
+ * they are; the layout word is written last, so an interrupted take over is repeated at the
+ * next boot.
+ */
+void ee_layout_init(void)
+{
+    uint8_t buf[EE_AES_MAXSIZE];
+    uint32_t size, ofs;
+
+    if (read_ee_u32(EE_LAYOUT_OFFSET) == EE_LAYOUT_MAGIC)
+        return;
+
+    size = read_ee_u32(EE_V2C_OFFSET);
+    if (size >= 4 && size <= EE_OLD_V2C_MAXSIZE - 4 && size > EE_V2C_MAXSIZE - 4) {
+        pr("Stored V2C (%u bytes) exceeds V2C slot size (max: %u bytes), removed.\n",
+           (unsigned int) size, (unsigned int) (EE_V2C_MAXSIZE - 4));
+        write_eeprom_u32(EE_V2C_OFFSET, 0);
+    }
+
+    size = read_ee_u32(EE_RSA_OFFSET);
+    if (size >= 4 && size <= EE_OLD_RSA_MAXSIZE - 4 && size > EE_RSA_MAXSIZE - 4) {
+        pr("Stored RSA key (%u bytes) exceeds RSA key region (max: %u bytes), removed.\n",
+           (unsigned int) size, (unsigned int) (EE_RSA_MAXSIZE - 4));
+        write_eeprom_u32(EE_RSA_OFFSET, 0);
+    }
+
+    size = read_ee_u32(EE_OLD_AES_OFFSET);
+    if (size >= 4 && size <= EE_OLD_AES_MAXSIZE - 4) {
+        if (size > EE_AES_MAXSIZE - 4) {
+            pr("Stored AES key (%u bytes) exceeds AES key region (max: %u bytes), removed.\n",
+               (unsigned int) size, (unsigned int) (EE_AES_MAXSIZE - 4));
+        } else {
+            read_eeprom_block(buf, (uint8_t*) (EE_OLD_AES_OFFSET + 4), (uint16_t) size);
+            blob_write_ee(EE_AES_OFFSET, EE_AES_MAXSIZE, (char*) buf, size);
+        }
+    }
+
+    for (ofs = EE_COMMIT_OFFSET; ofs < EE_COMMIT_OFFSET + EE_COMMIT_SIZE; ofs += 4)
+        write_eeprom_u32(ofs, 0);
+
+    write_eeprom_u32(EE_LAYOUT_OFFSET, EE_LAYOUT_MAGIC);
+}
+
+/**************************************************************************************************/
+
 void ee_v2c_dump(void)
 {
     fit_pointer_t fp;
-    set_fit_ptr_ee(&fp, EE_V2C_OFFSET, EE_V2C_MAXSIZE);
+    set_fit_ptr_v2c(&fp);
     fit_ptr_dump(&fp);
 }
 
@@ -219,28 +398,107 @@ void set_fit_ptr_ram(fit_pointer_t *fp, uint8_t *data, uint32_t size)
 
 int blob_write_ee(uint32_t ofs, uint32_t max, char *start, uint32_t size)
 {
-    uint32_t i, addr;
-    uint8_t data;
+    ee_stream_t es;
 
     if (size + 4 > max) {
         pr("Object to be written to EE is to big.\n");
         return 0;
     }
 
-    addr = ofs; /* offset into EE space */
-    write_eeprom_u8(addr++, (size) & 0xFF);
-    write_eeprom_u8(addr++, (size >> 8) & 0xFF);
-    write_eeprom_u8(addr++, (size >> 16) & 0xFF);
-    write_eeprom_u8(addr++, (size >> 24) & 0xFF);
-
-    for (i = 0; i < max - 4; i++) {
-        if (i < size)
-            data = *(start + i);
-        else
-            data = 0;
-        write_eeprom_u8(addr, data);
-        addr++;
+    /* only the object's own words are programmed, size header last */
+    ee_stream_begin(&es, ofs, max);
+    ee_stream_write(&es, (const uint8_t*) start, size);
+
+    return ee_stream_commit(&es);
+}
+
+/**************************************************************************************************/
+
+/**
+ * Streaming write of an object into EEPROM region ofs/max.
+ *
+ * ee_stream_begin() clears the size header, ee_stream_write() collects the data and programs
+ * it an EEPROM block at a time (unchanged words are skipped by write_eeprom_words()) and
+ * ee_stream_commit() writes the size header last, in a single word program. Nothing beyond the
+ * object's own words is touched. An interrupted or abandoned write leaves an empty region,
+ * never a partial object.
+ */
+
+void ee_stream_begin(ee_stream_t *es, uint32_t ofs, uint32_t max)
+{
+    es->ofs = ofs;
+    es->max = max;
+    es->size = 0;
+    es->flushed = 0;
+    es->overflow = 0;
+
+    write_eeprom_u32(ofs, 0);
+}
+
+/**
+ * program collected data; a trailing partial word is programmed as well but stays in buf
+ * until it is complete
+ */
+static void ee_stream_flush(ee_stream_t *es)
+{
+    uint32_t pending = es->size - es->flushed;
+    uint32_t full = pending / 4;
+
+    if (pending == 0)
+        return;
+
+    write_eeprom_words(es->ofs + 4 + es->flushed, es->buf, (pending + 3) / 4);
+
+    es->flushed += full * 4;
+    if (pending % 4)
+        es->buf[0] = es->buf[full];
+}
+
+void ee_stream_write(ee_stream_t *es, const uint8_t *data, uint32_t len)
+{
+    uint32_t idx;
+
+    while (len--) {
+        if (es->size + 4 >= es->max) {
+            es->overflow = 1;
+            return;
+        }
+        idx = es->size - es->flushed;
+        if (idx % 4 == 0)
+            es->buf[idx / 4] = 0;
+        es->buf[idx / 4] |= (uint32_t)*data++ << (8 * (idx % 4));
+        es->size++;
+
+        if (es->size - es->flushed == sizeof(es->buf))
+            ee_stream_flush(es);
     }
+}
+
+/**
+ * program all data written so far and point fp to it (e.g. to validate it before
+ * ee_stream_commit())
+ */
+void ee_stream_fit_ptr(ee_stream_t *es, fit_pointer_t *fp)
+{
+    ee_stream_flush(es);
+
+    fp->length = es->size;
+    fp->data = (uint8_t*) (es->ofs + 4);
+    fp->read_byte = (fit_read_byte_callback_t) read_eeprom_u8;
+}
+
+/**
+ * make the object valid by writing its size header; returns 0 if it did not fit into the region
+ */
+int ee_stream_commit(ee_stream_t *es)
+{
+    fit_pointer_t fp;
+
+    if (es->overflow)
+        return 0;
+
+    ee_stream_fit_ptr(es, &fp);
+    write_eeprom_u32(es->ofs, es->size);
 
     return 1;
 }
@@ -22,28 +22,112 @@
 /**************************************************************************************************/
 
 /**
- * Locations & size of licensing data in EEPROM
+ * Locations & size of licensing data in EEPROM (6 KB on TM4C1294)
+ *
+ * The V2C is kept in two slots (A/B). A new V2C is written to the inactive slot and made
+ * active by a single word write of its sequence number into the commit record; see
+ * ee_ab_active_slot(). Both slots have to fit next to the keys, so a V2C is limited to
+ * EE_V2C_MAXSIZE - 4 = 2300 bytes (the former single slot layout took up to 4092 bytes).
+ *
+ * The RSA and AES keys are kept in A/B slots of their own, committed the same way, so a key
+ * upload neither touches the key in use nor the license fallback slot.
+ *
+ * V2C slot A and RSA key slot A are at the offsets of the former layout; an AES key and a V2C
+ * that still fits a slot are taken over at the first boot, see ee_layout_init().
  */
 
 #define EE_V2C_OFFSET  0
-#define EE_V2C_MAXSIZE 4096
+#define EE_V2C_SLOTS   2
+#define EE_V2C_MAXSIZE 2304                     /* per slot, including size header */
 
-#define EE_AES_OFFSET  (EE_V2C_OFFSET + EE_V2C_MAXSIZE)
-#define EE_AES_MAXSIZE 512
+#define EE_RSA_OFFSET  (EE_V2C_OFFSET + EE_V2C_SLOTS * EE_V2C_MAXSIZE)
+#define EE_RSA_MAXSIZE 640                      /* per slot: PEM or compiled RSA-2048 key */
 
-#define EE_RSA_OFFSET  (EE_AES_OFFSET + EE_AES_MAXSIZE)
-#define EE_RSA_MAXSIZE 1024
+#define EE_AES_OFFSET  (EE_RSA_OFFSET + EE_V2C_SLOTS * EE_RSA_MAXSIZE)
+#define EE_AES_MAXSIZE 64                       /* per slot */
+
+/* commit record: one sequence word per A/B slot of V2C, RSA and AES key */
+#define EE_COMMIT_OFFSET   (EE_AES_OFFSET + EE_V2C_SLOTS * EE_AES_MAXSIZE)
+#define EE_V2C_COMMIT_OFFSET  EE_COMMIT_OFFSET
+#define EE_RSA_COMMIT_OFFSET  (EE_V2C_COMMIT_OFFSET + EE_V2C_SLOTS * 4)
+#define EE_AES_COMMIT_OFFSET  (EE_RSA_COMMIT_OFFSET + EE_V2C_SLOTS * 4)
+#define EE_COMMIT_SIZE     (3 * EE_V2C_SLOTS * 4)
+
+/* EEPROM layout version, written once the former layout is taken over */
+#define EE_LAYOUT_OFFSET   (EE_COMMIT_OFFSET + EE_COMMIT_SIZE)
+#define EE_LAYOUT_MAGIC    0x32454546           /* "FEE2" */
+
+/* record of the last RSA verification of the stored license (fit_verify_record_t object) */
+#define EE_VERIFY_OFFSET   (EE_LAYOUT_OFFSET + 4)
+#define EE_VERIFY_MAXSIZE  64
+
+#define EE_LAYOUT_SIZE     (EE_VERIFY_OFFSET + EE_VERIFY_MAXSIZE)
+
+/* former single slot layout */
+#define EE_OLD_V2C_MAXSIZE 4096
+#define EE_OLD_AES_OFFSET  4096
+#define EE_OLD_AES_MAXSIZE 512
+#define EE_OLD_RSA_MAXSIZE 1024
+
+/**
+ * Object kept in two EEPROM slots (A/B) of max bytes each, starting at ofs; commit is the
+ * offset of its two commit record words. See ee_ab_active_slot().
+ */
+
+typedef struct ee_ab {
+    uint32_t ofs;
+    uint32_t max;
+    uint32_t commit;
+} ee_ab_t;
+
+extern const ee_ab_t ee_ab_v2c;
+extern const ee_ab_t ee_ab_rsa;
+extern const ee_ab_t ee_ab_aes;
+
+/**
+ * Streaming write of an object (size header + data) into an EEPROM region, see ee_stream_begin()
+ */
+
+#define EE_STREAM_WORDS 16  /* data is programmed in chunks of one EEPROM block */
+
+typedef struct ee_stream {
+    uint32_t ofs;                   /* region offset, size header */
+    uint32_t max;                   /* region size including size header */
+    uint32_t size;                  /* data bytes written so far */
+    uint32_t flushed;               /* data bytes programmed so far, multiple of 4 */
+    uint32_t buf[EE_STREAM_WORDS];  /* data words not yet programmed */
+    uint8_t  overflow;              /* data did not fit into region */
+} ee_stream_t;
 
 /**************************************************************************************************/
 
 EXTERNC void write_eeprom_u8 (int address, uint8_t value);
+EXTERNC void write_eeprom_u32 (int address, uint32_t value);
+EXTERNC void write_eeprom_words (int address, const uint32_t *words, uint32_t count);
+EXTERNC uint32_t eeprom_block_writes (uint32_t block);
+EXTERNC void eeprom_cache_invalidate (void);
+EXTERNC void eeprom_cache_stats (uint32_t *hits, uint32_t *misses);
 
 void      fit_ptr_dump (fit_pointer_t *fp);
 uint8_t   read_0 (const uint8_t *p);
 void      set_fit_ptr_ee (fit_pointer_t *fp, uint32_t offset, uint32_t maxsize );
+void      ee_layout_init (void);
+int       ee_ab_active_slot (const ee_ab_t *ab);
+void      set_fit_ptr_ab (fit_pointer_t *fp, const ee_ab_t *ab);
+void      ee_ab_stream_begin (ee_stream_t *es, const ee_ab_t *ab);
+int       ee_ab_stream_commit (ee_stream_t *es, const ee_ab_t *ab);
+int       ee_ab_write (const ee_ab_t *ab, const uint8_t *data, uint32_t size);
+void      set_fit_ptr_v2c (fit_pointer_t *fp);
+int       ee_v2c_active_slot (void);
 void      set_fit_ptr_ram (fit_pointer_t *fp, uint8_t *data, uint32_t size);
 void      ee_v2c_dump (void);
 int       blob_write_ee (uint32_t ofs, uint32_t max, char *start, uint32_t size);
+void      ee_stream_begin (ee_stream_t *es, uint32_t ofs, uint32_t max);
+void      ee_stream_write (ee_stream_t *es, const uint8_t *data, uint32_t len);
+void      ee_stream_fit_ptr (ee_stream_t *es, fit_pointer_t *fp);
+int       ee_stream_commit (ee_stream_t *es);
+void      ee_v2c_stream_begin (ee_stream_t *es);
+int       ee_v2c_stream_commit (ee_stream_t *es);
 void      dump_ram (uint8_t *data, uint32_t size);
 
 void      trim(char* s);
@@ -36,6 +36,34 @@ void print404()
               "\r\n");
 }
 
+/**
+ * reply 400 bad request header and content (request line too long or malformed)
+ */
+
+void print400()
+{
+    www.print("HTTP/1.1 400 Bad Request\r\n"
+              "Content-type:text/plain\r\n"
+              "\r\n"
+              "Sentinel Fit Web Demo\r\n"
+              "400 Bad Request\r\n"
+              "\r\n");
+}
+
+/**
+ * reply 503 service unavailable header and content (another upload is in progress)
+ */
+
+void print503()
+{
+    www.print("HTTP/1.1 503 Service Unavailable\r\n"
+              "Content-type:text/plain\r\n"
+              "\r\n"
+              "Sentinel Fit Web Demo\r\n"
+              "503 Service Unavailable\r\n"
+              "\r\n");
+}
+
 /**
  * reply <hr>, Back button, and end-of-page
  */
@@ -104,13 +132,55 @@ void print_http_title()
 int          validation_cache_ok = 0;
 fit_status_t validation_cache    = FIT_STATUS_LIC_CACHING_ERROR;
 
+/* offsets of license fields, built once per validated license (see do_consume_license) */
+fit_license_index_t lic_index;
+
 void validation_cache_invalidate (void)
 {
     validation_cache_ok = 0;
     validation_cache = FIT_STATUS_LIC_CACHING_ERROR;
+    memset(&lic_index, 0, sizeof(lic_index));
     fit_led_off();
 }
 
+/**
+ * The verification record of the stored license is kept in EEPROM, so after a reboot the
+ * license is accepted by recomputing the Davies Meyer hashes of license and key only, without
+ * RSA verification. A changed V2C or key does not match the record and is verified in full.
+ */
+
+void verify_record_load (void)
+{
+    fit_verify_record_t rec;
+    fit_pointer_t fp;
+
+    set_fit_ptr_ee(&fp, EE_VERIFY_OFFSET, EE_VERIFY_MAXSIZE);
+    if (fp.length != sizeof(rec))
+        return;
+
+    read_eeprom_block((uint8_t*) &rec, fp.data, sizeof(rec));
+    if (fit_licenf_set_verify_record(&rec) != FIT_STATUS_OK)
+        pr("verification record in EEPROM not accepted\n");
+}
+
+static void verify_record_save (void)
+{
+    fit_verify_record_t rec, old;
+    fit_pointer_t fp;
+
+    if (fit_licenf_get_verify_record(&rec) != FIT_STATUS_OK)
+        return;
+
+    /* rewrite only a changed record */
+    set_fit_ptr_ee(&fp, EE_VERIFY_OFFSET, EE_VERIFY_MAXSIZE);
+    if (fp.length == sizeof(old)) {
+        read_eeprom_block((uint8_t*) &old, fp.data, sizeof(old));
+        if (!memcmp(&old, &rec, sizeof(rec)))
+            return;
+    }
+    blob_write_ee(EE_VERIFY_OFFSET, EE_VERIFY_MAXSIZE, (char*) &rec, sizeof(rec));
+}
+
 fit_status_t validate_license_ee (void)
 {
     fit_pointer_t lic = {0};
@@ -120,7 +190,7 @@ fit_status_t validate_license_ee (void)
     if (validation_cache_ok)
         goto cache_ok;
 
-    set_fit_ptr_ee(&lic, EE_V2C_OFFSET, EE_V2C_MAXSIZE);
+    set_fit_ptr_v2c(&lic);
     if (lic.length < 1) {
         validation_cache_ok = 0;
         validation_cache = FIT_STATUS_INVALID_V2C;
@@ -130,7 +200,15 @@ fit_status_t validate_license_ee (void)
     tm = millis();
     set_key_array();
     fit_trace_flags = 0;
-    status = fit_licenf_validate_license(&lic, key_arr);
+    status = fit_licenf_build_license_index(&lic, &lic_index);
+    if (status == FIT_STATUS_OK)
+        status = fit_licenf_revalidate_license_idx(&lic, key_arr, &lic_index);
+    else
+        status = fit_licenf_validate_license(&lic, key_arr);
+    if (status != FIT_STATUS_OK)
+        memset(&lic_index, 0, sizeof(lic_index));
+    else
+        verify_record_save();
     tm = millis() - tm;
     pr("re-validate: %d %s (%d ms)\n", status, fit_get_error_str(status), tm);
 
@@ -156,44 +234,42 @@ fit_status_t validate_license_ee_new (void)
 /***********************************************************************************************************/
 
 /**
- * send get_info information in JSON format
+ * writer for fit_getinfo_json_stream - send chunk of JSON to web client
  */
 
-uint8_t getinfojson[4096];
+static void www_write_json(const uint8_t *data, uint16_t len, void *ctx)
+{
+    ((EthernetClient *)ctx)->write(data, len);
+}
+
+/**
+ * send get_info information in JSON format; JSON is sent while license is parsed
+ */
 
 void print_getinfo_json()
 {
-    uint16_t getinfolen = sizeof(getinfojson);
     fit_pointer_t fitptrlic = {0};
     fit_status_t     status   = FIT_STATUS_OK;
     fit_status_t     valid_status;
 
-    set_fit_ptr_ee(&fitptrlic, EE_V2C_OFFSET, EE_V2C_MAXSIZE);
+    set_fit_ptr_v2c(&fitptrlic);
 
     fit_trace_flags = 0; //FMT_TRACE_ALL;
-    status = fit_testgetinfodata_json(&fitptrlic, getinfojson, &getinfolen);
-    pr("getinfo json status=%d, size=%d\n", status, getinfolen);
-
-    valid_status = validate_license_ee();
 
     print_200_plain();
 
-    if (status==FIT_STATUS_OK) {
-        www.print((char*)&getinfojson);
-        www.print("\"validate\":\"");
-        www.print(valid_status);
-        www.print("\",\r\n\"vtext\":\"");
-        www.print(fit_get_error_str(valid_status));
-        www.print("\",\r\n\"time\":\"");
-        www.print(fit_time_get());
-        www.println("\"\r\n}\r\n");
-    } else {
-        www.print("{\"status\":\"");
-        www.print(status);
-        www.print("\",\r\n\"text\":\"");
-        www.print(fit_get_error_str(status));
-        www.print("\"\r\n}\r\n");
-    }
+    status = fit_getinfo_json_stream(&fitptrlic, www_write_json, &www);
+    pr("getinfo json status=%d\n", status);
+
+    valid_status = validate_license_ee();
+
+    www.print("\"validate\":\"");
+    www.print(valid_status);
+    www.print("\",\r\n\"vtext\":\"");
+    www.print(fit_get_error_str(valid_status));
+    www.print("\",\r\n\"time\":\"");
+    www.print(fit_time_get());
+    www.println("\"\r\n}\r\n");
 }
 
 /***********************************************************************************************************/
@@ -281,15 +357,15 @@ void print_getinfo()
                 "<script>");
 
     www.print("document.getElementById(\"v2c\").innerHTML=\"");
-    set_fit_ptr_ee(&fp, EE_V2C_OFFSET, EE_V2C_MAXSIZE);
+    set_fit_ptr_v2c(&fp);
     fit_ptr_dump_www_8(&fp);
 
     www.print("\";document.getElementById(\"rsa\").innerHTML=\"");
-    set_fit_ptr_ee(&fp, EE_RSA_OFFSET, EE_RSA_MAXSIZE);
+    set_fit_ptr_ab(&fp, &ee_ab_rsa);
     fit_ptr_dump_www_8(&fp);
 
     www.print("\";document.getElementById(\"aes\").innerHTML=\"");
-    set_fit_ptr_ee(&fp, EE_AES_OFFSET, EE_AES_MAXSIZE);
+    set_fit_ptr_ab(&fp, &ee_ab_aes);
     fit_ptr_dump_www_8(&fp);
     www.println("\";");
 
@@ -449,34 +525,22 @@ void do_cmd(char *cmd, char* result)
 
 /***********************************************************************************************************/
 
-void get_set(const char *line)
+void get_set(char *query)
 {
-    char arg[128];
     char result[128];
-    char *cmd = NULL;
-    char *end_args;
 
     result[0] = 0;
 
     print_200_plain();
 
-    strncpy(arg, line, sizeof(arg));
-    pr("set: \"%s\"\n", arg);
+    pr("set: \"%s\"\n", query);
 
-    if (strstr(arg, "GET /set?") == arg) {
-        cmd = arg + 9;
-        end_args = strstr(cmd, " HTTP");
-        if (end_args) {
-            *end_args = 0;
-            do_cmd(cmd, result);
-        }
-    }
+    if (query[0] != 0)
+        do_cmd(query, result);
 
     if (result[0] == 0) {
         www.println("unknown \"set\" command.<br>");
-        if (cmd) {
-            www.println(cmd);
-        }
+        www.println(query);
     } else {
         www.print(result);
     }
@@ -484,35 +548,22 @@ void get_set(const char *line)
 
 /***********************************************************************************************************/
 
-void get_consume(const char *line)
+void get_consume(char *query)
 {
-    char arg[128];
     char result[128];
-    char *cmd;
-    char *end_args;
 
     result[0] = 0;
-    cmd       = NULL;
 
     print_http_head(0);
     www.println("<body>");
     print_http_title();
 
-    strncpy(arg, line, sizeof(arg));
-    // pr("set: \"%s\"\n", arg);
-
-    if (strstr(arg, "GET /consume?") == arg) {
-        cmd = arg + 13;
-        end_args = strstr(cmd, " HTTP");
-        if (end_args) {
-            *end_args = 0;
-            do_cmd(cmd, result);
-        }
-    }
+    if (query[0] != 0)
+        do_cmd(query, result);
 
     if (result[0] == 0) {
         www.println("unknown \"set\" command.<br>");
-        if (cmd) www.println(cmd);
+        www.println(query);
     }
 
     www.println("</body></html>");
@@ -680,13 +731,13 @@ void dump_v2c_and_keys()
 
     print_200_plain();
 
-    set_fit_ptr_ee(&fp, EE_V2C_OFFSET, EE_V2C_MAXSIZE);
+    set_fit_ptr_v2c(&fp);
     fit_ptr_dump_www(&fp, "V2C");
 
-    set_fit_ptr_ee(&fp, EE_RSA_OFFSET, EE_RSA_MAXSIZE);
+    set_fit_ptr_ab(&fp, &ee_ab_rsa);
     fit_ptr_dump_www(&fp, "RSA pubkey");
 
-    set_fit_ptr_ee(&fp, EE_AES_OFFSET, EE_AES_MAXSIZE);
+    set_fit_ptr_ab(&fp, &ee_ab_aes);
     fit_ptr_dump_www(&fp, "AES key");
 }
 
@@ -698,6 +749,8 @@ extern char firmware_version[];
 void dump_v2c_and_keys_html()
 {
     fit_pointer_t fp;
+    uint32_t hits, misses;
+    uint32_t i, writes, total = 0, maxwrites = 0, maxblock = 0;
 
     print_http_head(0);
     www.println("<body>");
@@ -705,15 +758,47 @@ void dump_v2c_and_keys_html()
 
     www.print("<div class=\"up\"><pre>");
 
-    set_fit_ptr_ee(&fp, EE_V2C_OFFSET, EE_V2C_MAXSIZE);
+    set_fit_ptr_v2c(&fp);
     fit_ptr_dump_www(&fp, "V2C");
 
-    set_fit_ptr_ee(&fp, EE_RSA_OFFSET, EE_RSA_MAXSIZE);
+    set_fit_ptr_ab(&fp, &ee_ab_rsa);
     fit_ptr_dump_www(&fp, "RSA pubkey");
 
-    set_fit_ptr_ee(&fp, EE_AES_OFFSET, EE_AES_MAXSIZE);
+    set_fit_ptr_ab(&fp, &ee_ab_aes);
     fit_ptr_dump_www(&fp, "AES key");
 
+    eeprom_cache_stats(&hits, &misses);
+    www.print("EEPROM read cache: ");
+    www.print((unsigned long)hits);
+    www.print(" hits, ");
+    www.print((unsigned long)misses);
+    www.println(" misses");
+
+    fit_licenf_get_verify_cache_stats(&hits, &misses);
+    www.print("License verification cache: ");
+    www.print((unsigned long)hits);
+    www.print(" hits, ");
+    www.print((unsigned long)misses);
+    www.println(" misses");
+
+    /* EEPROM wear: words programmed per 64 byte block since power up */
+    for (i = 0; i < EEPROMSizeGet() / 64; i++) {
+        writes = eeprom_block_writes(i);
+        total += writes;
+        if (writes > maxwrites) {
+            maxwrites = writes;
+            maxblock = i;
+        }
+    }
+    www.print("EEPROM words programmed: ");
+    www.print((unsigned long)total);
+    www.print(", max ");
+    www.print((unsigned long)maxwrites);
+    www.print(" in block ");
+    www.print((unsigned long)maxblock);
+    www.print(", active V2C slot: ");
+    www.println(ee_v2c_active_slot() ? "B\n" : "A\n");
+
     www.print("<tr><td>Firmware ");
     www.print(firmware_version);
     www.println(" (" __DATE__ ", " __TIME__ ")</td></tr>"
@@ -776,16 +861,24 @@ void pr_www_div(int divclass, const char *msg)
 
 #include "mbedtls/pk.h"
 
-fit_status_t validate_rsa_key(char *data_start, int data_len)
+fit_status_t validate_rsa_key(fit_pointer_t *fp)
 {
+    static unsigned char pem[EE_RSA_MAXSIZE];
     fit_status_t status = FIT_STATUS_INVALID_RSA_PUBKEY;
     int ret;
     mbedtls_pk_context pk;
 
     pr("validate_rsa_key()\n");
+    if (fp->length >= sizeof(pem))
+        return FIT_STATUS_INVALID_RSA_PUBKEY;
+
+    /* key is staged in EEPROM; parse a copy with a 0 appended to make mbedtls PEM parser happy */
+    read_eeprom_block(pem, fp->data, fp->length);
+    pem[fp->length] = 0;
+
     mbedtls_pk_init(&pk);
 
-    ret = mbedtls_pk_parse_public_key(&pk, (const unsigned char *) data_start, data_len + 1);
+    ret = mbedtls_pk_parse_public_key(&pk, pem, fp->length + 1);
     if (ret) {
         pr("[fit_validate_rsa_signature] parsing public key FAILED -0x%04x\n", -ret);
         status = FIT_STATUS_INVALID_RSA_PUBKEY;
@@ -802,26 +895,190 @@ fit_status_t validate_rsa_key(char *data_start, int data_len)
 /**
  * POST handling for V2C/RSA/AES
  * multipart mime
+ *
+ * The body is parsed while it arrives: www_mp_feed() locates the first part of the multipart
+ * body and streams its data into EEPROM: a V2C or key into the inactive slot of its own A/B
+ * pair (see ee_ab_stream_begin()). post_file() then validates the staged object in EEPROM and
+ * commits it (see ee_ab_stream_commit()); the object in use is kept until then.
  */
 #define POST_FILE_V2C 1
 #define POST_FILE_RSA 2
 #define POST_FILE_AES 3
 
-#define POST_BUFFER_SIZE (6 * 1024)
+#define POST_BOUNDARY_MAX 72
+
+#define MP_PREAMBLE     0   /* looking for "--boundary" */
+#define MP_HEADERS      1   /* looking for empty line ending part headers */
+#define MP_DATA         2   /* streaming data, looking for "\r\n--boundary" */
+#define MP_DONE         3   /* first part complete, rest is discarded */
+
+#define MP_BUF_SIZE     256
+
+/* streaming multipart/form-data parser */
+typedef struct www_multipart {
+    uint8_t      state;
+    uint8_t      patlen;
+    const char  *pat;                           /* pattern searched for in this state */
+    uint8_t      skip[256];                     /* Boyer-Moore-Horspool shift table of pat */
+    char         delim[POST_BOUNDARY_MAX + 4];  /* "\r\n--" boundary */
+    uint16_t     len;                           /* bytes in buf */
+    uint8_t      buf[MP_BUF_SIZE];
+} www_multipart_t;
+
+/* POST request collected by the connection state machine */
+typedef struct www_upload {
+    boolean         busy;                           /* owned by a connection */
+    uint8_t         filetype;                       /* POST_FILE_xxx */
+    int             length;                         /* Content-Length */
+    int             received;                       /* body bytes received so far */
+    char            boundary[POST_BOUNDARY_MAX];    /* mime boundary from Content-Type */
+    www_multipart_t mp;
+    ee_stream_t     es;                             /* EEPROM target of the part data */
+} www_upload_t;
+
+static www_upload_t www_upload;
+
+static void www_mp_pattern(www_multipart_t *mp, const char *pat)
+{
+    int i;
+
+    mp->pat = pat;
+    mp->patlen = (uint8_t) strlen(pat);
+
+    memset(mp->skip, mp->patlen, sizeof(mp->skip));
+    for (i = 0; i < mp->patlen - 1; i++)
+        mp->skip[(uint8_t) pat[i]] = (uint8_t) (mp->patlen - 1 - i);
+}
+
+/**
+ * Boyer-Moore-Horspool search of mp->pat in mp->buf; returns offset of match or -1
+ */
+static int www_mp_search(const www_multipart_t *mp)
+{
+    int m = mp->patlen;
+    int i = 0;
+    int j;
+
+    while (i + m <= mp->len) {
+        j = m - 1;
+        while (mp->buf[i + j] == (uint8_t) mp->pat[j]) {
+            if (j == 0)
+                return i;
+            j--;
+        }
+        i += mp->skip[mp->buf[i + m - 1]];
+    }
+    return -1;
+}
+
+/**
+ * drop n bytes from the front of mp->buf; part data is passed to the EEPROM stream first
+ */
+static void www_mp_consume(www_multipart_t *mp, uint16_t n, boolean data)
+{
+    if (data)
+        ee_stream_write(&www_upload.es, mp->buf, n);
+
+    mp->len -= n;
+    memmove(mp->buf, mp->buf + n, mp->len);
+}
+
+/**
+ * process search results in mp->buf; only the last patlen - 1 bytes, which may start a match,
+ * are kept when the pattern is not found
+ */
+static void www_mp_process(www_multipart_t *mp)
+{
+    int pos;
+
+    while (mp->state != MP_DONE) {
+        pos = www_mp_search(mp);
+        if (pos < 0) {
+            if (mp->len >= mp->patlen)
+                www_mp_consume(mp, mp->len - (mp->patlen - 1), mp->state == MP_DATA);
+            return;
+        }
+
+        www_mp_consume(mp, (uint16_t) pos, mp->state == MP_DATA);
+        www_mp_consume(mp, mp->patlen, false);
+        mp->state++;
+
+        switch (mp->state) {
+        case MP_HEADERS:
+            www_mp_pattern(mp, "\r\n\r\n");
+            break;
+        case MP_DATA:
+            www_mp_pattern(mp, mp->delim);
+            /* the old object is dropped only once the new data really starts */
+            switch (www_upload.filetype) {
+            case POST_FILE_V2C:
+                ee_v2c_stream_begin(&www_upload.es);
+                break;
+            case POST_FILE_RSA:
+                ee_ab_stream_begin(&www_upload.es, &ee_ab_rsa);
+                break;
+            case POST_FILE_AES:
+                ee_ab_stream_begin(&www_upload.es, &ee_ab_aes);
+                break;
+            }
+            break;
+        }
+    }
+    mp->len = 0;
+}
+
+/**
+ * feed received body bytes to the multipart parser
+ */
+static void www_mp_feed(const uint8_t *data, uint16_t len)
+{
+    www_multipart_t *mp = &www_upload.mp;
+    uint16_t n;
+
+    /* no boundary given, nothing to look for */
+    if (!mp->patlen)
+        return;
+
+    while (len) {
+        n = MP_BUF_SIZE - mp->len;
+        if (n > len)
+            n = len;
+        memcpy(mp->buf + mp->len, data, n);
+        mp->len += n;
+        data += n;
+        len -= n;
+
+        www_mp_process(mp);
+    }
+}
+
+/**
+ * POST headers complete: set up the multipart parser for the body
+ */
+void post_start(uint8_t filetype)
+{
+    www_multipart_t *mp = &www_upload.mp;
+
+    www_upload.filetype = filetype;
 
-char post_header[POST_BUFFER_SIZE + 16];
+    memset(mp, 0, sizeof(*mp));
+    mp->state = MP_PREAMBLE;
+    if (www_upload.boundary[0]) {
+        strcpy(mp->delim, "\r\n--");
+        strcat(mp->delim, www_upload.boundary);
+        www_mp_pattern(mp, mp->delim + 2);
+    }
+}
 
+/**
+ * POST body complete: validate, commit and report the uploaded object
+ */
 void post_file(uint8_t filetype)
 {
-    char *s;
-    int index, length = 0;
-    unsigned long timeout;
-    int i, data_length = 0;
-    char c;
+    www_multipart_t *mp = &www_upload.mp;
+    ee_stream_t *es = &www_upload.es;
+    int data_length = 0;
     char tmp[256];
-    char boundary[256];
-    char *data_start = NULL;
-    char *data_stop = NULL;
     fit_status_t status = FIT_STATUS_INVALID_V2C;
     fit_pointer_t fp = { 0 };
 
@@ -848,111 +1105,37 @@ void post_file(uint8_t filetype)
     }
     www.println("</div>");
 
-    memset(post_header, 0, sizeof(post_header));
-
-    index = 0;
-    for (i = 0; i < POST_BUFFER_SIZE; i++) {
-        c = www.read();
-        post_header[index++] = c;
-
-        if ((strstr(post_header, "\n\n")) ||
-            (strstr(post_header, "\r\r")) ||
-            (strstr(post_header, "\r\n\r\n")) ||
-            (strstr(post_header, "\n\r\n\r")))
-            break;
-    }
-
-    /* detect mime boundary */
-    s = strstr(post_header, "Content-Type:");
-    if (!s) {
-        pr_www_div(0, "Content-Type not found");
-        goto bail;
-    }
-
-    s = strstr(post_header, "boundary=");
-    if (!s) {
+    if (!www_upload.boundary[0]) {
         pr_www_div(0, "\"boundary=\" not found");
         goto bail;
     }
 
-    s += 9; // skip "boundary="
-    boundary[0] = 0;
-    for (i = 0; i < 250; i++) {
-        if (*s == '\n')
-            break;
-        if (*s == '\r')
-            break;
-        boundary[i] = *s;
-        s++;
-        boundary[i + 1] = 0;
-    }
+    pr("Boundary: \"%s\"\n", www_upload.boundary);
+    pr("v2c length: %d\n", www_upload.length);
 
-    pr("Boundary: \"%s\"\n", boundary);
-
-    /* detect content length */
-    s = strstr(post_header, "Content-Length:");
-    length = 0;
-    if (s)
-        length = atoi(s + 15);
-    pr("v2c length: %d\n", length);
-
-    // read data
-    index = 0;
-    timeout = millis() + 1000;
-    for (i = 0; i < length; i++) {
-        while (www.available() <= 0) {
-            if (timeout < millis())
-                break;
-        }
-        c = www.read();
-        if (index < POST_BUFFER_SIZE)
-            post_header[index++] = c;
-    }
-
-    if (length < 2) {
-        snprintf(tmp, sizeof(tmp), "Received data too small (%d)", length);
-        www.print("<br>");
-        pr_www_div(0, tmp);
-        goto bail;
-    }
-
-    if (length > POST_BUFFER_SIZE) {
-        snprintf(tmp, sizeof(tmp), "Received data too big (is: %d, max: %d)",
-                length, POST_BUFFER_SIZE);
-        www.print("<br>");
-        pr_www_div(0, tmp);
-        goto bail;
-    }
-
-    /* Extract data:
-     *   - boundary
-     *   - \n\r\n\r
-     */
-
-    s = strstr(post_header, boundary);
-    if (!s) {
+    switch (mp->state) {
+    case MP_PREAMBLE:
         pr_www_div(0, "First boundary not found");
         goto bail;
-    }
-    s++;
-    s = strstr(s, "\r\n\r\n");
-    if (!s) {
+    case MP_HEADERS:
         pr_www_div(0, "Boundary local header not found");
         goto bail;
-    }
-    data_start = s + 4;
-    pr("Start: %d\r\n", data_start - post_header);
-
-    data_stop = strstr(data_start, boundary);
-    data_stop = (char*) memmem(data_start, length - (data_start - post_header), boundary, strlen(boundary));
-    if (!data_stop) {
+    case MP_DATA:
         pr_www_div(0, "2nd boundary not found");
         goto bail;
     }
 
-    pr("Stop: %d\r\n", data_stop - post_header);
+    if (es->overflow) {
+        snprintf(tmp, sizeof(tmp), "Received data too big for its EEPROM region (max: %u bytes), "
+                 "nothing stored", (unsigned int) (es->max - 4));
+        www.print("<br>");
+        pr_www_div(0, tmp);
+        goto bail;
+    }
 
-    data_length = data_stop - data_start - 4; // "\r\n--"
+    /* data is staged in EEPROM, not committed yet */
+    ee_stream_fit_ptr(es, &fp);
+    data_length = fp.length;
 
     // dump data to http reply
     www.print("<div class=\"up\"><pre>");
@@ -961,7 +1144,6 @@ void post_file(uint8_t filetype)
     } else {
         www.print(data_length);
         www.println(" bytes");
-        set_fit_ptr_ram(&fp, (uint8_t *) data_start, data_length);
         fit_ptr_dump_www(&fp, NULL);
     }
     www.println("</pre></div>");
@@ -970,14 +1152,6 @@ void post_file(uint8_t filetype)
 
     if (filetype == POST_FILE_V2C) {
 
-        // validate received V2C
-        if (data_length >= EE_V2C_MAXSIZE - 4) {
-            snprintf(tmp, sizeof(tmp), "Received V2C too big: is %d, max %d", data_length, EE_V2C_MAXSIZE - 4);
-            pr_www_div(0, tmp);
-            goto bail;
-        }
-
-        set_fit_ptr_ram(&fp, (uint8_t *) data_start, data_length);
         fit_trace_flags = 0;
         status = FIT_STATUS_OK;
         set_key_array();
@@ -1002,13 +1176,17 @@ void post_file(uint8_t filetype)
                             "before you can consume licenses from this V2C.</div>");
             }
 
-            // write V2C to EEPROM
-            blob_write_ee(EE_V2C_OFFSET, EE_V2C_MAXSIZE, data_start, data_length);
+            /* a V2C for a key that is uploaded later is kept, anything else invalid is not */
+            if ((FIT_STATUS_OK == status) || (FIT_STATUS_KEY_NOT_PRESENT == status)) {
+                ee_v2c_stream_commit(es);
+                www.println("<br><div class=\"upb\">License stored into EEPROM</div>");
+            } else {
+                www.println("<br><div class=\"upb\">License rejected, previous license kept</div>");
+            }
             validate_license_ee_new(); /* do an uncached validate and set LED */
-            www.println("<br><div class=\"upb\">License stored into EEPROM</div>");
         } else {
             /* Empty License */
-            blob_write_ee(EE_V2C_OFFSET, EE_V2C_MAXSIZE, data_start, 0);
+            ee_v2c_stream_commit(es);
             www.println("<div class=\"upb\">Existing license was removed from EEPROM</div>");
             validate_license_ee_new();
         }
@@ -1017,47 +1195,47 @@ void post_file(uint8_t filetype)
     /*-------------------------------------------------------------------------------------------------------------*/
 
     if (filetype == POST_FILE_RSA) {
+        static uint8_t record[FIT_RSA_KEY_RECORD_SIZE];
+        uint16_t reclen = sizeof(record);
+        int compiled = 0;
 
-        // validate received RSA pubkey
-        if (data_length >= EE_RSA_MAXSIZE - 4) {
-            snprintf(tmp, sizeof(tmp), "RSA pubkey too big: is %d, max %d <br>", data_length, EE_RSA_MAXSIZE - 4);
-            pr_www_div(0, tmp);
-            goto bail;
-        }
-
-        /*  insert RSA public key validation */
         status = FIT_STATUS_OK;
-
-        /* patch a 0 after RSA key to make mbedtls PEM parser happy */
-        *(data_start + data_length) = 0;
-
-        status = validate_rsa_key(data_start, data_length);
-        snprintf(tmp, sizeof(tmp), "Validating received RSA pubkey: %d %s\n", status,
-                fit_get_error_str(status));
-        pr_www_div((FIT_STATUS_OK == status), tmp);
+        if (data_length > 0) {
+            /* an RSA-2048 key is stored compiled, later verifications skip PEM/ASN.1 parsing */
+            status = fit_licenf_compile_rsa_key(&fp, record, &reclen);
+            compiled = (FIT_STATUS_OK == status);
+            if (!compiled)
+                status = validate_rsa_key(&fp);
+            snprintf(tmp, sizeof(tmp), "Validating received RSA pubkey: %d %s\n", status,
+                    fit_get_error_str(status));
+            pr_www_div((FIT_STATUS_OK == status), tmp);
+        }
 
         // write RSA pubkey to EEPROM
-        blob_write_ee(EE_RSA_OFFSET, EE_RSA_MAXSIZE, data_start, data_length);
+        if (compiled) {
+            /* the staged PEM is replaced by the record, still in the inactive slot */
+            ee_ab_write(&ee_ab_rsa, record, reclen);
+            www.println("<br><div class=\"upb\">RSA public key compiled and stored into EEPROM</div>");
+        } else if (FIT_STATUS_OK == status) {
+            ee_ab_stream_commit(es, &ee_ab_rsa);
+            www.println("<br><div class=\"upb\">RSA public key stored into EEPROM</div>");
+        } else {
+            www.println("<br><div class=\"upb\">RSA public key rejected, previous key kept</div>");
+        }
+        fit_licenf_rsa_key_cache_invalidate();
         validate_license_ee_new(); /* do an uncached validate and set LED */
-        www.println("<br><div class=\"upb\">RSA public key stored into EEPROM</div>");
     }
 
     /*-------------------------------------------------------------------------------------------------------------*/
 
     if (filetype == POST_FILE_AES) {
 
-        // validate received AES key
-        if (data_length >= EE_AES_MAXSIZE - 4) {
-            snprintf(tmp, sizeof(tmp), "AES key too big: is %d, max %d", data_length, EE_AES_MAXSIZE - 4);
-            pr_www_div(0, tmp);
-            goto bail;
-        }
-
         /*  insert AES key validation */
         status = FIT_STATUS_OK;
 
         // write AES key to EEPROM
-        blob_write_ee(EE_AES_OFFSET, EE_AES_MAXSIZE, data_start, data_length);
+        ee_ab_stream_commit(es, &ee_ab_aes);
+        fit_licenf_aes_key_cache_invalidate();
         validate_license_ee_new(); /* do an uncached validate and set LED */
         www.println("<br><div class=\"upb\">AES key stored into EEPROM</div>");
     }
@@ -1065,7 +1243,6 @@ void post_file(uint8_t filetype)
     /*-------------------------------------------------------------------------------------------------------------*/
 
 bail:
-    memset(post_header, 0, sizeof(post_header));
     print_end_of_page();
 }
 
@@ -1086,15 +1263,20 @@ void erase_ee(void)
 
     www.println("<tr><td colspan=\"2\"><b><font color=\"#FF0000\">Performing an EEPROM mass erase ...</font></b></td></tr>");
     EEPROMMassErase();
+    eeprom_cache_invalidate();
+    ee_layout_init(); /* erased EEPROM holds nothing of the former layout */
+    fit_licenf_rsa_key_cache_invalidate();
+    fit_licenf_aes_key_cache_invalidate();
+    fit_licenf_verify_cache_invalidate();
     validate_license_ee_new();
 
-    set_fit_ptr_ee(&fp, EE_V2C_OFFSET, EE_V2C_MAXSIZE);
+    set_fit_ptr_v2c(&fp);
     if (!fp.length) www.print("<tr><td>V2C</td><td>EMPTY</td></tr>");
 
-    set_fit_ptr_ee(&fp, EE_RSA_OFFSET, EE_RSA_MAXSIZE);
+    set_fit_ptr_ab(&fp, &ee_ab_rsa);
     if (!fp.length) www.print("<tr><td>RSA pubkey</td><td>EMPTY</td></tr>");
 
-    set_fit_ptr_ee(&fp, EE_AES_OFFSET, EE_AES_MAXSIZE);
+    set_fit_ptr_ab(&fp, &ee_ab_aes);
     if (!fp.length) www.print("<tr><td>AES key</td><td>EMPTY</td></tr>");
 
     www.print("</table>");
@@ -1103,123 +1285,410 @@ void erase_ee(void)
 
 /***********************************************************************************************************/
 
-void do_www(void)
+/**
+ * HTTP request routing
+ *
+ * The request line is read into a fixed buffer, split in place into method, path and
+ * query string, and the handler is found by binary search in www_routes[].
+ */
+
+#define WWW_LINE_MAX    128
+
+#define WWW_METHOD_GET  0
+#define WWW_METHOD_POST 1
+
+/* handler of one route; query is the decoded query string ("" if none) */
+typedef void (*www_handler_t)(char *query);
+
+typedef struct www_route {
+    const char    *path;
+    uint8_t        method;
+    www_handler_t  handler;
+} www_route_t;
+
+static void route_getinfo(char *query)      { (void)query; print_getinfo(); }
+static void route_getinfo_json(char *query) { (void)query; print_getinfo_json(); }
+static void route_fingerprint(char *query)  { (void)query; print_fingerprint(); }
+static void route_post_v2c(char *query)     { (void)query; post_start(POST_FILE_V2C); }
+static void route_post_rsa(char *query)     { (void)query; post_start(POST_FILE_RSA); }
+static void route_post_aes(char *query)     { (void)query; post_start(POST_FILE_AES); }
+static void route_dump(char *query)         { (void)query; dump_v2c_and_keys(); }
+static void route_dump_html(char *query)    { (void)query; dump_v2c_and_keys_html(); }
+static void route_led1(char *query)         { (void)query; ledtoggle(1); } //Green
+static void route_led2(char *query)         { (void)query; ledtoggle(2); } //Blue
+static void route_erase_ee(char *query)     { (void)query; erase_ee(); }
+static void route_logo(char *query)         { (void)query; get_logo(); }
+
+/* route table - must be kept sorted by path (strcmp order), then method */
+static const www_route_t www_routes[] = {
+    { "/",             WWW_METHOD_GET,  route_getinfo },
+    { "/aeskey",       WWW_METHOD_POST, route_post_aes },
+    { "/consume",      WWW_METHOD_GET,  get_consume },
+    { "/dump",         WWW_METHOD_GET,  route_dump },
+    { "/dump.html",    WWW_METHOD_GET,  route_dump_html },
+    { "/dump.txt",     WWW_METHOD_GET,  route_dump },
+    { "/eraseee",      WWW_METHOD_GET,  route_erase_ee },
+    { "/fingerprint",  WWW_METHOD_GET,  route_fingerprint },
+    { "/gemalto.png",  WWW_METHOD_GET,  route_logo },
+    { "/getinfo.html", WWW_METHOD_GET,  route_getinfo },
+    { "/getinfo.txt",  WWW_METHOD_GET,  route_getinfo_json },
+    { "/index.html",   WWW_METHOD_GET,  route_getinfo },
+    { "/led1toggle",   WWW_METHOD_GET,  route_led1 },
+    { "/led2toggle",   WWW_METHOD_GET,  route_led2 },
+    { "/rsakey",       WWW_METHOD_POST, route_post_rsa },
+    { "/set",          WWW_METHOD_GET,  get_set },
+    { "/v2c",          WWW_METHOD_POST, route_post_v2c },
+};
+
+#define WWW_NUM_ROUTES  (sizeof(www_routes) / sizeof(www_routes[0]))
+
+/**
+ * compare route with path and method; returns <0, 0, >0 like strcmp
+ */
+static int www_route_cmp(const www_route_t *route, const char *path, uint8_t method)
 {
+    int d = strcmp(route->path, path);
 
-	www = server.available();
-    if (www) {
-        String currentLine = "";               // incoming data from the client
-        boolean newConnection = true;
-        uint32_t connectionActiveTimer = 0;    // connection start time
+    if (d == 0)
+        d = (int)route->method - (int)method;
+    return d;
+}
 
-        pr("%u ", fit_time_get());
-        // pr("port %d ", www.port());
+/**
+ * find handler for path and method; returns NULL if there is none
+ */
+static www_handler_t www_find_route(const char *path, uint8_t method)
+{
+    int lo = 0;
+    int hi = (int)WWW_NUM_ROUTES - 1;
 
-        while (www.connected()) {
-            if (newConnection) {
-                connectionActiveTimer = millis();
-                newConnection = false;
-            }
-            if (!newConnection && connectionActiveTimer + 1000 < millis()) {
-                // if this while loop is still active 1000ms after a web client connected,
-                // something is wrong - drop connection end exit
-                goto www_done;
-            }
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int d = www_route_cmp(&www_routes[mid], path, method);
 
-            while (www.available()) {             // if there's bytes to read from the client,
-
-
-            	char c = www.read();             // read a byte, then
-
-                if ((c == '\n') || (c == '\r')) {                    // if the byte is a newline character
-
-                    pr("Web request: <%s>\n", currentLine.c_str());
-
-                    if (currentLine.startsWith("GET /getinfo.txt ")) {
-                        print_getinfo_json();
-                        goto www_done;
-                    }
-                    if ((currentLine.startsWith("GET / ")) ||
-                        (currentLine.startsWith("GET /index.html "))) {
-                        print_getinfo();
-                        goto www_done;
-                    }
-                    if (currentLine.startsWith("GET /getinfo.html ")) {
-                        print_getinfo();
-                        goto www_done;
-                    }
-                    if (currentLine.startsWith("GET /fingerprint ")) {
-                        print_fingerprint();
-                        goto www_done;
-                    }
-                    if (currentLine.startsWith("POST /v2c ")) {
-                        post_file(POST_FILE_V2C);
-                        goto www_done;
-                    }
-                    if (currentLine.startsWith("POST /rsakey ")) {
-                        post_file(POST_FILE_RSA);
-                        goto www_done;
-                    }
-                    if (currentLine.startsWith("POST /aeskey ")) {
-                        post_file(POST_FILE_AES);
-                        goto www_done;
-                    }
-                    if ((currentLine.startsWith("GET /dump.txt ")) ||
-                            (currentLine.startsWith("GET /dump "))) {
-                        dump_v2c_and_keys();
-                        goto www_done;
-                    }
-                    if (currentLine.startsWith("GET /dump.html ")) {
-                        dump_v2c_and_keys_html();
-                        goto www_done;
-                    }
-                    if (currentLine.startsWith("GET /set?")) {
-                        get_set(currentLine.c_str());
-                        goto www_done;
-                    }
-                    if (currentLine.startsWith("GET /consume?")) {
-                        get_consume(currentLine.c_str());
-                        goto www_done;
-                    }
-//MAH
-					if (currentLine.startsWith("GET /led1toggle")) { //Green
-						ledtoggle(1);
-						goto www_done;
-					}
-
-					 if (currentLine.startsWith("GET /led2toggle")) { //Blue
-						ledtoggle(2);
-						goto www_done;
-					}
-//MAH
-                    if (currentLine.startsWith("GET /eraseee")) {
-                        erase_ee();
-                        goto www_done;
-                    }
-                    if (currentLine.startsWith("GET /gemalto.png ")) {
-                        get_logo();
-                        goto www_done;
-                    }
-
-                    print404();
-                    goto www_done;
-                }
-                currentLine += c;
+        if (d == 0)
+            return www_routes[mid].handler;
+        if (d < 0)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return NULL;
+}
 
-            }
+/**
+ * value of hex digit c, or -1 if c is not a hex digit
+ */
+static int www_hexval(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * decode query string in place: "+" becomes space, "%XX" becomes character XX
+ */
+static void www_query_decode(char *s)
+{
+    char *d = s;
+
+    while (*s) {
+        if (*s == '+') {
+            *d++ = ' ';
+            s++;
+        } else if (*s == '%' && www_hexval(s[1]) >= 0 && www_hexval(s[2]) >= 0) {
+            *d++ = (char)(www_hexval(s[1]) * 16 + www_hexval(s[2]));
+            s += 3;
+        } else {
+            *d++ = *s++;
+        }
+    }
+    *d = 0;
+}
+
+/**
+ * split request line "METHOD /path?query HTTP/1.x" in place and look up the handler;
+ * replies 400 or 404 and returns NULL if there is none
+ */
+static www_handler_t www_parse_request(char *line, uint8_t *method, char **query)
+{
+    char *path, *end;
+    www_handler_t handler;
+
+    if (strncmp(line, "GET ", 4) == 0) {
+        *method = WWW_METHOD_GET;
+        path = line + 4;
+    } else if (strncmp(line, "POST ", 5) == 0) {
+        *method = WWW_METHOD_POST;
+        path = line + 5;
+    } else {
+        print400();
+        return NULL;
+    }
+
+    end = strchr(path, ' ');
+    if (end)
+        *end = 0;
+
+    *query = strchr(path, '?');
+    if (*query)
+        *(*query)++ = 0;
+    else
+        *query = end ? end : path + strlen(path);    /* empty string */
+
+    handler = www_find_route(path, *method);
+    if (handler == NULL) {
+        print404();
+        return NULL;
+    }
+
+    www_query_decode(*query);
+    return handler;
+}
+
+/***********************************************************************************************************/
+
+/**
+ * HTTP connection handling
+ *
+ * do_www() is called from loop() and never waits for a client. Each call accepts at most
+ * one new connection into a free slot of www_conn[] and advances every open connection by
+ * the bytes it has available. GET requests are served as soon as the request line is
+ * complete; for POST the headers are parsed and the body is streamed into www_upload (see
+ * post_start()), which only one connection can own at a time. Connections idle for
+ * WWW_IDLE_TIMEOUT ms are dropped.
+ */
+
+#define WWW_MAX_CONN        4
+#define WWW_IDLE_TIMEOUT    1000
+
+#define WWW_CONN_FREE       0
+#define WWW_CONN_REQUEST    1   /* reading request line */
+#define WWW_CONN_HEADERS    2   /* reading POST headers */
+#define WWW_CONN_BODY       3   /* reading POST body */
+
+typedef struct www_conn {
+    EthernetClient  client;
+    uint8_t         state;
+    boolean         overflow;           /* line longer than WWW_LINE_MAX */
+    uint16_t        linelen;
+    uint32_t        lastactive;         /* millis() of last received byte */
+    www_handler_t   handler;            /* POST handler, called once the headers are complete */
+    char            line[WWW_LINE_MAX]; /* request line or current header line */
+} www_conn_t;
+
+static www_conn_t www_conn[WWW_MAX_CONN];
+
+static void www_conn_close(www_conn_t *conn)
+{
+    if (conn->state == WWW_CONN_HEADERS || conn->state == WWW_CONN_BODY)
+        www_upload.busy = false;
+
+    conn->client.stop();
+    conn->state = WWW_CONN_FREE;
+}
+
+/**
+ * request line complete: serve GET, start collecting POST
+ */
+static void www_conn_request(www_conn_t *conn)
+{
+    www_handler_t handler;
+    uint8_t method;
+    char *query;
+
+    conn->line[conn->linelen] = 0;
+    pr("Web request: <%s>\n", conn->line);
+
+    www = conn->client;
+    if (conn->overflow) {
+        print400();
+        www_conn_close(conn);
+        return;
+    }
+
+    handler = www_parse_request(conn->line, &method, &query);
+    if (handler && method == WWW_METHOD_POST) {
+        if (!www_upload.busy) {
+            memset(&www_upload, 0, sizeof(www_upload));
+            www_upload.busy = true;
+
+            conn->handler = handler;
+            conn->state = WWW_CONN_HEADERS;
+            conn->linelen = 0;
+            return;
+        }
+        print503();
+    } else if (handler) {
+        handler(query);
+    }
+    www_conn_close(conn);
+}
+
+/**
+ * POST body complete: reply
+ */
+static void www_conn_body_done(www_conn_t *conn)
+{
+    www = conn->client;
+    post_file(www_upload.filetype);
+    www_conn_close(conn);
+}
+
+/**
+ * pass available POST body bytes to the multipart parser
+ */
+static void www_conn_body(www_conn_t *conn)
+{
+    uint8_t buf[64];
+    int n = www_upload.length - www_upload.received;
+
+    if (n > (int) sizeof(buf))
+        n = sizeof(buf);
+    n = conn->client.read(buf, n);
+    if (n <= 0)
+        return;
+
+    www_upload.received += n;
+    www_mp_feed(buf, (uint16_t) n);
+
+    if (www_upload.received >= www_upload.length)
+        www_conn_body_done(conn);
+}
+
+/**
+ * POST header line complete: pick up boundary and Content-Length, empty line ends headers
+ */
+static void www_conn_header(www_conn_t *conn)
+{
+    char *s;
+    int i;
+
+    conn->line[conn->linelen] = 0;
+
+    if (conn->linelen == 0) {
+        conn->handler((char *)"");
+        conn->state = WWW_CONN_BODY;
+        if (www_upload.length <= 0)
+            www_conn_body_done(conn);
+        return;
+    }
+
+    if (strncmp(conn->line, "Content-Type:", 13) == 0) {
+        s = strstr(conn->line, "boundary=");
+        if (s) {
+            s += 9; // skip "boundary="
+            for (i = 0; i < POST_BOUNDARY_MAX - 1 && s[i]; i++)
+                www_upload.boundary[i] = s[i];
+            www_upload.boundary[i] = 0;
+        }
+    } else if (strncmp(conn->line, "Content-Length:", 15) == 0) {
+        www_upload.length = atoi(conn->line + 15);
+    }
+
+    conn->linelen = 0;
+    conn->overflow = false;
+}
+
+/**
+ * consume whatever the client has sent so far, drop the connection if it has gone away
+ * or has been idle for too long
+ */
+static void www_conn_poll(www_conn_t *conn)
+{
+    while (conn->state != WWW_CONN_FREE && conn->client.available() > 0) {
+        char c;
+
+        conn->lastactive = millis();
+
+        if (conn->state == WWW_CONN_BODY) {
+            www_conn_body(conn);
+            continue;
         }
 
-        www_done:
-        www.stop();
+        c = conn->client.read();
+        if (c == '\r')
+            continue;
 
+        if (c == '\n') {
+            if (conn->state == WWW_CONN_HEADERS)
+                www_conn_header(conn);
+            else if (conn->linelen || conn->overflow)   /* skip stray empty lines */
+                www_conn_request(conn);
+            continue;
+        }
+
+        if (conn->linelen < WWW_LINE_MAX - 1)
+            conn->line[conn->linelen++] = c;
+        else
+            conn->overflow = true;
     }
 
+    if (conn->state == WWW_CONN_FREE)
+        return;
+
+    if (!conn->client.connected() || (uint32_t)(millis() - conn->lastactive) > WWW_IDLE_TIMEOUT)
+        www_conn_close(conn);
+}
+
+/**
+ * take a new connection into a free slot; if all slots are busy it is left pending
+ * and picked up by a later call
+ */
+static void www_accept(void)
+{
+    EthernetClient client = server.available();
+    www_conn_t *conn = NULL;
+    int i;
+
+    if (!client)
+        return;
+
+    for (i = 0; i < WWW_MAX_CONN; i++) {
+        if (www_conn[i].state == WWW_CONN_FREE) {
+            if (conn == NULL)
+                conn = &www_conn[i];
+        } else if (www_conn[i].client == client) {
+            return;                             // already being served
+        }
+    }
+    if (conn == NULL)
+        return;
+
+    pr("%u ", fit_time_get());
+
+    conn->client = client;
+    conn->state = WWW_CONN_REQUEST;
+    conn->overflow = false;
+    conn->linelen = 0;
+    conn->lastactive = millis();
+}
+
+void do_www(void)
+{
+    int i;
+
+    www_accept();
+
+    for (i = 0; i < WWW_MAX_CONN; i++)
+        www_conn_poll(&www_conn[i]);
+
 } /* do_www() */
 
 /***********************************************************************************************************/
 
 void www_server_init (void)
 {
+    unsigned int i;
+
+    /* www_find_route relies on sorted route table */
+    for (i = 1; i < WWW_NUM_ROUTES; i++) {
+        if (www_route_cmp(&www_routes[i-1], www_routes[i].path, www_routes[i].method) >= 0)
+            pr("www_routes[] not sorted at %s\n", www_routes[i].path);
+    }
+
     server.begin();
 }
 
@@ -25,6 +25,7 @@
 /********************************************************************************************/
 
 extern fit_key_array_t *key_arr;
+extern fit_license_index_t lic_index;
 
 EXTERNC void set_key_array (void);
 EXTERNC fit_status_t do_consume_license(uint16_t feature_id);
@@ -34,4 +35,7 @@ EXTERNC fit_status_t do_consume_license(uint16_t feature_id);
 void www_server_init(void);
 void do_www(void);
 
+void verify_record_load(void);
+fit_status_t validate_license_ee(void);
+
 #endif
@@ -62,6 +62,7 @@ const char www_script[] =
 "var myTime;\n"
 "var algo,lock;\n"
 "eval('var c='+ s);\n"
+"if(c[\"error\"]!==undefined){c[\"status\"]=c[\"error\"];c[\"text\"]=c[\"etext\"];}\n"
 "if(c[\"status\"]!=\"0\"){\n"
 "o+=\"<table><tr><td><font color=\\\"#ff0000\\\"><b>License Parsing Error:&nbsp;&nbsp;\"+c[\"status\"]+\n"
 "\"&nbsp;&nbsp;\"+c[\"text\"]+\"</b></font></td></tr><table\";\n"